@@ -1,9 +1,14 @@
 #include "CommandLineInterface.h"
 
 //std library
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
 
+//external vendor libraries
+#include <fmt/format.h>
+
 
 namespace MiMaCLI {
 	CommandLineInterface::CommandLineInterface(const std::shared_ptr<Command>& rootCommand) :
@@ -32,4 +37,53 @@ namespace MiMaCLI {
 			std::cout << ">> ";
 		}
 	}
+
+
+	size_t CommandLineInterface::runScript(std::istream& script, const std::string& scriptName, const bool& quiet) {
+		std::string output;
+		std::string errors;
+		size_t failedCommands = 0;
+
+		std::string input;
+		for (size_t lineNumber = 1; std::getline(script, input); ++lineNumber) {
+			size_t commandStart = input.find_first_not_of(" \t\r");
+			if (commandStart == std::string::npos || input.compare(commandStart, 2, "//") == 0) {
+				continue;
+			}
+
+			if (!quiet) {
+				fmt::format_to(std::back_inserter(output), ">> {}\n", input);
+			}
+
+			try {
+				CommandResult result = rootCommand->execute(input);
+
+				fmt::format_to(std::back_inserter(output), quiet ? "{}\n" : "<< {}\n", result.output);
+
+				if (result.end) {
+					break;
+				}
+			}
+			catch (const CommandException& exc) {
+				fmt::format_to(std::back_inserter(errors), "{}:{}: Failed to execute '{}': {}\n", scriptName, lineNumber, input, exc.what());
+				failedCommands++;
+			}
+		}
+
+		//a single write for the whole script instead of a flush per command
+		std::cout.write(output.data(), output.size());
+		std::cout.flush();
+		std::cerr.write(errors.data(), errors.size());
+
+		return failedCommands;
+	}
+
+	size_t CommandLineInterface::runScriptFile(const std::string& fileName, const bool& quiet) {
+		std::ifstream fileInputStream(fileName);
+		if (!fileInputStream.good()) {
+			throw CommandException(fmt::format("Failed to open script file '{}'", fileName));
+		}
+
+		return runScript(fileInputStream, fileName, quiet);
+	}
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 //std library
+#include <istream>
 #include <memory>
+#include <string>
 
 //internal classes
 #include "Command.h"
@@ -16,5 +18,10 @@ namespace MiMaCLI {
 		CommandLineInterface(const std::shared_ptr<Command>& rootCommand);
 
 		void run();
+
+		//executes every line of the script as a command, skipping empty lines and lines starting with //,
+		//collects all output to write it at once (without echoing the commands if quiet) and returns the number of failed commands
+		size_t runScript(std::istream& script, const std::string& scriptName, const bool& quiet = false);
+		size_t runScriptFile(const std::string& fileName, const bool& quiet = false);
 	};
 }
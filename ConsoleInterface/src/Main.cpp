@@ -1,5 +1,7 @@
 //std library
+#include <iostream>
 #include <memory>
+#include <string>
 
 //minimal machine
 #include "mimaCLI/MiMaCommandExecutor.h"
@@ -9,12 +11,42 @@
 #include "CLI/CommandLineInterface.h"
 
 
-int main() {
+static const char* USAGE = "usage: ConsoleInterface [--script <fileName> [--quiet]]";
+
+
+int main(int argc, char** argv) {
+	std::string scriptFileName;
+	bool quiet = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+
+		if (argument == "--script" && i + 1 < argc) {
+			scriptFileName = argv[++i];
+		}
+		else if (argument == "--quiet") {
+			quiet = true;
+		}
+		else {
+			std::cerr << USAGE << std::endl;
+			return 2;
+		}
+	}
+
 	std::shared_ptr<MiMaCLI::MiMaCLIState> state = std::make_shared<MiMaCLI::MiMaCLIState>();
 	std::shared_ptr<MiMaCLI::MiMaCommandExecutor> mimaRootCommand = std::make_shared<MiMaCLI::MiMaCommandExecutor>(state);
 	MiMaCLI::CommandLineInterface cli(mimaRootCommand);
 
-	cli.run();
+	if (scriptFileName.empty()) {
+		cli.run();
+		return 0;
+	}
 
-	return 0;
-}
\ No newline at end of file
+	try {
+		return cli.runScriptFile(scriptFileName, quiet) == 0 ? 0 : 1;
+	}
+	catch (const MiMaCLI::CommandException& exc) {
+		std::cerr << exc.what() << std::endl;
+		return 2;
+	}
+}
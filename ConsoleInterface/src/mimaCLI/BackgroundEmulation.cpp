@@ -0,0 +1,92 @@
+#include "BackgroundEmulation.h"
+
+//std library
+#include <algorithm>
+#include <exception>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+
+namespace MiMaCLI {
+	BackgroundEmulation::BackgroundEmulation(const std::shared_ptr<MiMa::MinimalMachine>& mima, const uint64_t& cycleLimit) :
+		mima(mima),
+		cycleLimit(cycleLimit),
+		stopRequested(false),
+		state(State::RUNNING),
+		cycles(mima->getCycleCount()),
+		instructions(mima->getInstructionCount()),
+		startInstructions(mima->getInstructionCount()),
+		startTime(std::chrono::steady_clock::now())
+	{
+		//the worker is started last, once all members it uses are initialized
+		worker = std::thread(&BackgroundEmulation::emulate, this);
+	}
+
+
+	void BackgroundEmulation::emulate() {
+		State finalState = State::STOPPED;
+
+		try {
+			while (!stopRequested) {
+				if (!mima->isRunning()) {
+					finalState = State::HALTED;
+					break;
+				}
+				if (mima->getCycleCount() >= cycleLimit) {
+					finalState = State::CYCLE_LIMIT;
+					break;
+				}
+
+				mima->emulateLifeTime(std::min(mima->getCycleCount() + CHECK_INTERVAL, cycleLimit));
+
+				cycles = mima->getCycleCount();
+				instructions = mima->getInstructionCount();
+			}
+		}
+		catch (const std::exception& exc) {
+			failure = exc.what();
+			finalState = State::FAILED;
+		}
+
+		runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		state = finalState;
+	}
+
+
+	void BackgroundEmulation::stop() {
+		stopRequested = true;
+
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+
+
+	std::string BackgroundEmulation::getStatus() const {
+		State currentState = state;
+		double seconds = currentState == State::RUNNING ? std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() : runSeconds;
+		double instructionRate = seconds > 0 ? (instructions - startInstructions) / seconds : 0;
+
+		std::string description;
+		switch (currentState) {
+		case State::RUNNING:
+			description = "running";
+			break;
+		case State::HALTED:
+			description = "halted";
+			break;
+		case State::CYCLE_LIMIT:
+			description = fmt::format("reached the cycle limit of {}", cycleLimit);
+			break;
+		case State::STOPPED:
+			description = "stopped";
+			break;
+		case State::FAILED:
+			description = fmt::format("failed: {}", failure);
+			break;
+		}
+
+		return fmt::format("{} after {} cycles and {} instructions ({:.0f} instructions/s over {:.1f}s)", description, cycles.load(), instructions.load(), instructionRate, seconds);
+	}
+}
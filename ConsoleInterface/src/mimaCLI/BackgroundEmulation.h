@@ -0,0 +1,72 @@
+#pragma once
+
+//std library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+//minimal machine
+#include "mima/MinimalMachine.h"
+
+
+namespace MiMaCLI {
+	// ------------------------------------------------
+	// Background emulation
+	//
+	// Emulates the lifetime of a minimal machine on a
+	// worker thread, in slices of CHECK_INTERVAL clock
+	// cycles. Between two slices the progress counters
+	// are published and a requested stop is honored,
+	// so neither costs anything inside a slice.
+	// ------------------------------------------------
+
+	class BackgroundEmulation {
+	public:
+		static constexpr uint64_t CHECK_INTERVAL = 100000;
+
+		enum class State {
+			RUNNING,
+			HALTED,      //the MiMa halted on its own
+			CYCLE_LIMIT, //the cycle limit was reached
+			STOPPED,     //stopped on request
+			FAILED       //the emulation threw an exception
+		};
+
+	private:
+		std::shared_ptr<MiMa::MinimalMachine> mima;
+		uint64_t cycleLimit;
+
+		std::atomic<bool> stopRequested;
+		std::atomic<State> state;
+		std::atomic<uint64_t> cycles;
+		std::atomic<uint64_t> instructions;
+
+		//only written by the worker before the state leaves RUNNING
+		std::string failure;
+		double runSeconds = 0;
+
+		uint64_t startInstructions;
+		std::chrono::steady_clock::time_point startTime;
+		std::thread worker;
+
+		void emulate();
+
+	public:
+		BackgroundEmulation(const std::shared_ptr<MiMa::MinimalMachine>& mima, const uint64_t& cycleLimit);
+		~BackgroundEmulation() { stop(); }
+
+		BackgroundEmulation(const BackgroundEmulation&) = delete;
+		BackgroundEmulation& operator=(const BackgroundEmulation&) = delete;
+
+		//requests the worker to stop after the current slice and waits for it
+		void stop();
+
+		inline bool isRunning() const { return state == State::RUNNING; }
+
+		//describes the state, the cycles and instructions emulated and the instruction rate
+		std::string getStatus() const;
+	};
+}
@@ -2,20 +2,35 @@
 
 //std library
 #include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <regex>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 
 //external vendor libraries
 #include <fmt/format.h>
+#include <fmt/ranges.h>
 
 //minimal machine
 #include "mima/microprogram/MicroProgramCompiler.h"
 #include "mima/mimaprogram/MiMaCompiler.h"
+#include "mima/devices/StandardDevices.h"
+#include "mima/Profiler.h"
+#include "mima/ExecutionRecord.h"
+#include "mima/PipelinedMachine.h"
+#include "mima/DifferentialChecker.h"
 #include "mima/CompilerException.h"
 
 //internal classes
 #include "CLI/CommandUtility.h"
 
+//debugging utility
+#include "debug/Log.h"
+
 
 namespace MiMaCLI {
 	const std::regex MiMaCLIState::identifierPattern(R"([_a-zA-Z][_a-zA-Z0-9]*)");
@@ -33,8 +48,63 @@ namespace MiMaCLI {
 	// --- Constants definitions ---
 
 	static const std::regex emptyLinePattern(R"(\s*)");
+
+	// --- Background emulation utility ---
+
+	//a minimal machine running in the background may only be inspected through its status
+	static void assertNotInBackground(const std::string& name, const std::shared_ptr<MiMaCLIState>& state) {
+		NamedBackgroundEmulations::const_iterator foundEmulation = (state->backgroundEmulations).find(name);
+
+		if (foundEmulation != (state->backgroundEmulations).end() && (foundEmulation->second)->isRunning()) {
+			throw CommandException(fmt::format("Minimal machine '{}' is running in the background, stop it first", name));
+		}
+	}
 	
 
+	// --- Logging utility ---
+
+	//every minimal machine logs to its own file, starting with the channel levels of the default logger,
+	//a minimal machine which already exists under the name keeps its logger and file
+	static std::shared_ptr<MiMa::Logger> getMachineLogger(const std::string& name, const std::shared_ptr<MiMaCLIState>& state) {
+		NamedMinimalMachines::const_iterator foundMinimalMachine = (state->minimalMachines).find(name);
+		if (foundMinimalMachine != (state->minimalMachines).end() && (foundMinimalMachine->second)->getLogger()) {
+			return (foundMinimalMachine->second)->getLogger();
+		}
+
+		std::shared_ptr<MiMa::Logger> logger = MiMa::Logger::createAsync(fmt::format("mima {}", name), fmt::format("mima_{}", name));
+
+		for (size_t channel = 0; channel < MiMa::LOG_CHANNEL_COUNT; ++channel) {
+			logger->setChannelLevel((MiMa::LogChannel)channel, MiMa::mimaDefaultLog.getChannelLevel((MiMa::LogChannel)channel));
+		}
+		return logger;
+	}
+
+
+	// --- Differential check utility ---
+
+	//the image both engines of a differential check are reset to
+	static std::shared_ptr<const MiMa::MemoryImage> compileCheckedProgram(const std::string& fileName) {
+		try {
+			return MiMa::MiMaMemoryCompiler::compileFile(fileName);
+		}
+		catch (const MiMa::CompilerException& exc) {
+			throw CommandException(exc);
+		}
+	}
+
+	static CommandResult runDifferentialCheck(MiMa::DifferentialChecker& checker, const uint64_t& instructionLimit) {
+		MiMa::DifferentialResult result = checker.run(instructionLimit);
+
+		std::ostringstream report;
+		result.writeReport(report, checker.getPrimary(), checker.getSecondary());
+
+		//the CLI ends every result with a line break itself
+		std::string output = report.str();
+		output.pop_back();
+		return { false, output };
+	}
+
+
 	// -----------------------------
 	// Command functions definitions
 	// -----------------------------
@@ -48,6 +118,46 @@ namespace MiMaCLI {
 	};
 
 
+	// --- Log function ---
+
+	//sets the level of a channel, or of all channels, of the default logger and the loggers of all minimal machines
+	static const MiMaCLIStateModifier logFunction = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 2);
+
+		std::vector<MiMa::LogChannel> channels;
+		MiMa::LogChannel channel;
+		if (arguments[0] == "all") {
+			for (size_t i = 0; i < MiMa::LOG_CHANNEL_COUNT; ++i) {
+				channels.push_back((MiMa::LogChannel)i);
+			}
+		}
+		else if (MiMa::parseLogChannel(arguments[0], channel)) {
+			channels.push_back(channel);
+		}
+		else {
+			throw CommandException(fmt::format("No log channel under the name '{}' exists, use core, memory, microcompiler, assembler or all", arguments[0]));
+		}
+
+		//spdlog reads unknown level names as off
+		spdlog::level::level_enum level = spdlog::level::from_str(arguments[1]);
+		if (level == spdlog::level::off && arguments[1] != "off") {
+			throw CommandException(fmt::format("No log level under the name '{}' exists, use trace, debug, info, warn, error, critical or off", arguments[1]));
+		}
+
+		for (const MiMa::LogChannel& logChannel : channels) {
+			MiMa::mimaDefaultLog.setChannelLevel(logChannel, level);
+
+			for (const std::pair<const std::string, std::shared_ptr<MiMa::MinimalMachine>>& minimalMachine : state->minimalMachines) {
+				if ((minimalMachine.second)->getLogger()) {
+					(minimalMachine.second)->getLogger()->setChannelLevel(logChannel, level);
+				}
+			}
+		}
+
+		return { false, fmt::format("Logging messages of level {} and above on the channel '{}'", spdlog::level::to_string_view(level), arguments[0]) };
+	};
+
+
 	// --- Microprogram command functions ---
 
 	static const MiMaCLIStateModifier microprogramCompileFunction = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
@@ -66,6 +176,53 @@ namespace MiMaCLI {
 		return { false, fmt::format("Compiled microprogram '{}'", arguments[1]) };
 	};
 
+	static const MiMaCLIStateModifier microprogramOptimizeFunction = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 2);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+
+		MiMa::MicroProgramOptimization optimization;
+		try {
+			std::shared_ptr<const MiMa::MicroProgram> microprogram = MiMa::MicroProgramCompiler::compileFile(arguments[1], &optimization);
+			(state->microprograms).insert({ arguments[0], microprogram });
+		}
+		catch (const MiMa::CompilerException& exc) {
+			throw CommandException(exc);
+		}
+
+		std::ostringstream report;
+		optimization.writeReport(report);
+
+		return { false, fmt::format("Compiled and optimized microprogram '{}'\n{}", arguments[1], report.str()) };
+	};
+
+	static const MiMaCLIStateModifier microprogramCheckFunction = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name otherName programFileName [checkInterval [instructionLimit]]
+		if (arguments.size() < 3 || arguments.size() > 5) {
+			throw CommandException(fmt::format("expected 3 to 5 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		CommandUtility::validateIdentifier(arguments[1], MiMaCLIState::identifierPattern);
+		uint64_t checkInterval = arguments.size() >= 4 ? std::max<uint64_t>(CommandUtility::validatePositiveDecimalInteger(arguments[3]), 1) : MiMa::DifferentialChecker::DEFAULT_CHECK_INTERVAL;
+		uint64_t instructionLimit = arguments.size() == 5 ? CommandUtility::validatePositiveDecimalInteger(arguments[4]) : std::numeric_limits<uint64_t>::max();
+
+		NamedMicroPrograms::const_iterator foundMicroprogram = (state->microprograms).find(arguments[0]);
+		NamedMicroPrograms::const_iterator foundOtherMicroprogram = (state->microprograms).find(arguments[1]);
+		if (foundMicroprogram == (state->microprograms).end() || foundOtherMicroprogram == (state->microprograms).end()) {
+			throw CommandException(fmt::format("No microprogram under the name '{}' exists", foundMicroprogram == (state->microprograms).end() ? arguments[0] : arguments[1]));
+		}
+
+		MiMa::DifferentialChecker checker(
+			std::make_unique<MiMa::MachineEngine<MiMa::MinimalMachine>>(arguments[0], std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, std::make_shared<MiMa::MiMaMemory>())),
+			std::make_unique<MiMa::MachineEngine<MiMa::MinimalMachine>>(arguments[1], std::make_shared<MiMa::MinimalMachine>(foundOtherMicroprogram->second, std::make_shared<MiMa::MiMaMemory>())),
+			compileCheckedProgram(arguments[2]), checkInterval);
+
+		return runDifferentialCheck(checker, instructionLimit);
+	};
+
 	static const size_t maxUpperLimit = 0xFF;
 	static const MiMaCLIStateModifier microprogramShowFunction = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
 		std::vector<std::string> arguments = CommandUtility::getArguments(input, 3);
@@ -98,8 +255,19 @@ namespace MiMaCLI {
 			throw CommandException(fmt::format("No microprogram under the name '{}' exists", arguments[2]));
 		}
 
+		//the compilation already logs like the minimal machine
+		std::shared_ptr<MiMa::Logger> logger = getMachineLogger(arguments[0], state);
+		MIMA_LOG_SCOPE(logger.get());
+
 		try {
-			(state->minimalMachines).insert({ arguments[0], std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, MiMa::MiMaMemoryCompiler::compileFile(arguments[1])) });
+			ProgramSource source;
+			std::shared_ptr<MiMa::MiMaMemory> memory = MiMa::MiMaMemoryCompiler::compileFile(arguments[1], &source.symbols, &source.sourceMap);
+			std::shared_ptr<MiMa::MinimalMachine> minimalMachine = std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, memory);
+			minimalMachine->setLogger(logger);
+
+			if ((state->minimalMachines).insert({ arguments[0], minimalMachine }).second) {
+				(state->programSources)[arguments[0]] = std::move(source);
+			}
 		}
 		catch (const MiMa::CompilerException& exc) {
 			throw CommandException(exc);
@@ -108,10 +276,38 @@ namespace MiMaCLI {
 		return { false, fmt::format("Created minimal machine '{}' with the microprogram '{}'", arguments[0], foundMicroprogram->first) };
 	};
 
+	static const MiMaCLIStateModifier minimalMachineLoad = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 3);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		CommandUtility::validateIdentifier(arguments[2], MiMaCLIState::identifierPattern);
+
+		NamedMicroPrograms::const_iterator foundMicroprogram = (state->microprograms).find(arguments[2]);
+		if (foundMicroprogram == (state->microprograms).end()) {
+			throw CommandException(fmt::format("No microprogram under the name '{}' exists", arguments[2]));
+		}
+
+		std::shared_ptr<MiMa::Logger> logger = getMachineLogger(arguments[0], state);
+		MIMA_LOG_SCOPE(logger.get());
+
+		//the memory of the minimal machine is the memory file itself, so results are written back to it
+		try {
+			std::shared_ptr<MiMa::MinimalMachine> minimalMachine = std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, MiMa::MiMaMemory::mapFile(arguments[1]));
+			minimalMachine->setLogger(logger);
+			(state->minimalMachines).insert({ arguments[0], minimalMachine });
+		}
+		catch (const std::runtime_error& exc) {
+			throw CommandException(exc);
+		}
+
+		return { false, fmt::format("Created minimal machine '{}' on the memory file '{}' with the microprogram '{}'", arguments[0], arguments[1], foundMicroprogram->first) };
+	};
+
 	static const MiMaCLIStateModifier minimalMachineShow = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
 		std::vector<std::string> arguments = CommandUtility::getArguments(input, 1);
 
 		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
 
 		NamedMinimalMachines::const_iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
 
@@ -122,10 +318,112 @@ namespace MiMaCLI {
 		return { false, fmt::format("Minimal machine '{}':\n{}", foundMinimalMachine->first, *(foundMinimalMachine->second)) };
 	};
 
+	static const MiMaCLIStateModifier minimalMachineDump = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name fileName [lowerLimit upperLimit]
+		if (arguments.size() != 2 && arguments.size() != 4) {
+			throw CommandException(fmt::format("expected 2 or 4 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+		size_t lowerLimit = 0;
+		size_t upperLimit = MiMa::DEFAULT_MEMORY_CAPACITY + 1;
+		if (arguments.size() == 4) {
+			lowerLimit = CommandUtility::validatePositiveDecimalInteger(arguments[2]);
+			upperLimit = std::max(CommandUtility::validatePositiveDecimalInteger(arguments[3]), lowerLimit);
+		}
+
+		NamedMinimalMachines::const_iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		std::ofstream fileOutputStream(arguments[1]);
+		if (!fileOutputStream.good()) {
+			throw CommandException(fmt::format("Failed to open memory dump file '{}'", arguments[1]));
+		}
+
+		//stream the compact hex dump straight into the file
+		std::string dumpFormat = fmt::format("{}:x{},{}{}", '{', lowerLimit, upperLimit, '}');
+		fmt::format_to(std::ostreambuf_iterator<char>(fileOutputStream), dumpFormat, *((foundMinimalMachine->second)->getMemory()));
+		fileOutputStream.close();
+
+		return { false, fmt::format("Dumped memory of minimal machine '{}' to '{}'", foundMinimalMachine->first, arguments[1]) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineDiff = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 2);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+
+		NamedMinimalMachines::const_iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		//compare the memory of the minimal machine to the expected memory image compiled from the given file
+		std::vector<MiMa::MemoryDifference> differences;
+		try {
+			differences = MiMa::diff(*((foundMinimalMachine->second)->getMemory()), *MiMa::MiMaMemoryCompiler::compileFile(arguments[1]));
+		}
+		catch (const MiMa::CompilerException& exc) {
+			throw CommandException(exc);
+		}
+
+		if (differences.empty()) {
+			return { false, fmt::format("Memory of minimal machine '{}' matches '{}'", foundMinimalMachine->first, arguments[1]) };
+		}
+
+		fmt::memory_buffer output;
+		fmt::format_to(std::back_inserter(output), "Memory of minimal machine '{}' differs from '{}' in {} cells:", foundMinimalMachine->first, arguments[1], differences.size());
+		for (const MiMa::MemoryDifference& difference : differences) {
+			fmt::format_to(std::back_inserter(output), "\n0x{:05X}: {} instead of {}", difference.address, difference.left, difference.right);
+		}
+
+		return { false, fmt::to_string(output) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineDevices = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name [inputFileName [inputLatency]]
+		if (arguments.size() < 1 || arguments.size() > 3) {
+			throw CommandException(fmt::format("expected 1 to 3 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+
+		NamedMinimalMachines::iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		std::string inputFileName = arguments.size() >= 2 ? arguments[1] : "";
+		uint64_t inputLatency = arguments.size() == 3 ? CommandUtility::validatePositiveDecimalInteger(arguments[2]) : 0;
+		try {
+			(foundMinimalMachine->second)->setDeviceBus(MiMa::createStandardDeviceBus(std::cout, inputFileName, inputLatency));
+		}
+		catch (const std::runtime_error& exc) {
+			throw CommandException(exc);
+		}
+
+		std::string inputDevice = inputFileName.empty() ? "" : fmt::format(", input stream at 0x{:05X}", MiMa::InputStreamDevice::DEFAULT_ADDRESS);
+		return { false, fmt::format("Attached devices to minimal machine '{}': console output at 0x{:05X}{}, cycle counter at 0x{:05X}, timer at 0x{:05X}, bulk copy at 0x{:05X}",
+			foundMinimalMachine->first, MiMa::ConsoleOutputDevice::DEFAULT_ADDRESS, inputDevice, MiMa::CycleCounterDevice::DEFAULT_ADDRESS, MiMa::TimerDevice::DEFAULT_ADDRESS, MiMa::BulkCopyDevice::DEFAULT_ADDRESS) };
+	};
+
 	static const MiMaCLIStateModifier minimalMachineEmulate = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
 		std::vector<std::string> arguments = CommandUtility::getArguments(input, 2);
 
 		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
 
 		NamedMinimalMachines::iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
 
@@ -155,17 +453,324 @@ namespace MiMaCLI {
 
 
 
+	static const MiMaCLIStateModifier minimalMachineProfile = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 1);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+
+		NamedMinimalMachines::iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		//a new profiler, so profiling again starts from zero
+		(foundMinimalMachine->second)->setProfiler(std::make_shared<MiMa::Profiler>());
+
+		return { false, fmt::format("Started profiling minimal machine '{}'", foundMinimalMachine->first) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineReport = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name reportFileName [foldedStacksFileName]
+		if (arguments.size() != 2 && arguments.size() != 3) {
+			throw CommandException(fmt::format("expected 2 or 3 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+
+		NamedMinimalMachines::const_iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		const std::shared_ptr<MiMa::Profiler>& profiler = (foundMinimalMachine->second)->getProfiler();
+		if (!profiler) {
+			throw CommandException(fmt::format("Minimal machine '{}' is not being profiled", arguments[0]));
+		}
+
+		//machines loaded from memory files have no source to annotate the profile with
+		NamedProgramSources::const_iterator foundSource = (state->programSources).find(arguments[0]);
+		const ProgramSource* source = foundSource == (state->programSources).end() ? nullptr : &(foundSource->second);
+
+		std::ofstream reportOutputStream(arguments[1]);
+		if (!reportOutputStream.good()) {
+			throw CommandException(fmt::format("Failed to open profile report file '{}'", arguments[1]));
+		}
+		profiler->writeReport(reportOutputStream, source ? &source->sourceMap : nullptr);
+
+		if (arguments.size() == 3) {
+			std::ofstream stacksOutputStream(arguments[2]);
+			if (!stacksOutputStream.good()) {
+				throw CommandException(fmt::format("Failed to open folded stacks file '{}'", arguments[2]));
+			}
+			profiler->writeFoldedStacks(stacksOutputStream, source ? &source->sourceMap : nullptr, source ? &source->symbols : nullptr);
+		}
+
+		return { false, fmt::format("Wrote the profile of minimal machine '{}' to '{}'", foundMinimalMachine->first, fmt::join(arguments.begin() + 1, arguments.end(), "' and '")) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineRecord = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name recordFileName [digestInterval [cycleLimit]]
+		if (arguments.size() < 2 || arguments.size() > 4) {
+			throw CommandException(fmt::format("expected 2 to 4 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+		uint64_t digestInterval = arguments.size() >= 3 ? std::max<uint64_t>(CommandUtility::validatePositiveDecimalInteger(arguments[2]), 1) : MiMa::ExecutionRecorder::DEFAULT_DIGEST_INTERVAL;
+		uint64_t cycleLimit = arguments.size() == 4 ? CommandUtility::validatePositiveDecimalInteger(arguments[3]) : std::numeric_limits<uint64_t>::max();
+
+		NamedMinimalMachines::iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+
+		MiMa::RecordSummary summary;
+		try {
+			summary = MiMa::ExecutionRecorder(arguments[1], digestInterval).record(*(foundMinimalMachine->second), cycleLimit);
+		}
+		catch (const std::runtime_error& exc) {
+			throw CommandException(exc);
+		}
+
+		return { false, fmt::format("Recorded minimal machine '{}' to '{}' until it {} after {} instructions in {} cycles: {} inputs and {} digests in {} bytes",
+			foundMinimalMachine->first, arguments[1], summary.halted ? "halted" : "reached the cycle limit", summary.instructions, summary.cycles, summary.inputs, summary.digests, summary.bytes) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineReplay = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 3);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		CommandUtility::validateIdentifier(arguments[2], MiMaCLIState::identifierPattern);
+
+		if ((state->minimalMachines).find(arguments[0]) != (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("A minimal machine under the name '{}' already exists", arguments[0]));
+		}
+
+		NamedMicroPrograms::const_iterator foundMicroprogram = (state->microprograms).find(arguments[2]);
+		if (foundMicroprogram == (state->microprograms).end()) {
+			throw CommandException(fmt::format("No microprogram under the name '{}' exists", arguments[2]));
+		}
+
+		//the standard devices receive the output of the replay, the input comes from the record
+		std::shared_ptr<MiMa::MinimalMachine> minimalMachine = std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, std::make_shared<MiMa::MiMaMemory>());
+		minimalMachine->setDeviceBus(MiMa::createStandardDeviceBus(std::cout));
+
+		MiMa::ReplaySummary summary;
+		try {
+			summary = MiMa::ExecutionReplayer(arguments[1]).replay(*minimalMachine);
+		}
+		catch (const std::runtime_error& exc) {
+			throw CommandException(exc);
+		}
+		(state->minimalMachines).insert({ arguments[0], minimalMachine });
+
+		std::string outcome = summary.diverged ? fmt::format("diverged: {}", summary.divergence) : summary.complete ? "matched the record" : "matched the record up to its end, which is incomplete";
+		return { false, fmt::format("Replayed '{}' on minimal machine '{}' for {} instructions in {} cycles with {} inputs and {} digests, the replay {}",
+			arguments[1], arguments[0], summary.instructions, summary.cycles, summary.inputs, summary.digests, outcome) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineStart = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: name [cycleLimit]
+		if (arguments.size() != 1 && arguments.size() != 2) {
+			throw CommandException(fmt::format("expected 1 or 2 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+		assertNotInBackground(arguments[0], state);
+		uint64_t cycleLimit = std::numeric_limits<uint64_t>::max();
+		if (arguments.size() == 2) {
+			cycleLimit = CommandUtility::validatePositiveDecimalInteger(arguments[1]);
+		}
+
+		NamedMinimalMachines::iterator foundMinimalMachine = (state->minimalMachines).find(arguments[0]);
+
+		if (foundMinimalMachine == (state->minimalMachines).end()) {
+			throw CommandException(fmt::format("No minimal machine under the name '{}' exists", arguments[0]));
+		}
+		if (!(foundMinimalMachine->second)->isRunning()) {
+			throw CommandException(fmt::format("Minimal machine '{}' has already halted", arguments[0]));
+		}
+
+		//replaces the finished emulation of a previous start
+		(state->backgroundEmulations)[foundMinimalMachine->first] = std::make_unique<BackgroundEmulation>(foundMinimalMachine->second, cycleLimit);
+
+		return { false, fmt::format("Started emulating minimal machine '{}' in the background", foundMinimalMachine->first) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineStatus = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: [name], without a name all background emulations are listed
+		if (arguments.size() > 1) {
+			throw CommandException(fmt::format("expected 0 or 1 arguments, got {}", arguments.size()));
+		}
+
+		if (arguments.size() == 1) {
+			CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+
+			NamedBackgroundEmulations::const_iterator foundEmulation = (state->backgroundEmulations).find(arguments[0]);
+			if (foundEmulation == (state->backgroundEmulations).end()) {
+				throw CommandException(fmt::format("Minimal machine '{}' was never started in the background", arguments[0]));
+			}
+
+			return { false, fmt::format("Minimal machine '{}' {}", foundEmulation->first, (foundEmulation->second)->getStatus()) };
+		}
+
+		if ((state->backgroundEmulations).empty()) {
+			return { false, "No minimal machine was started in the background" };
+		}
+
+		std::vector<std::string> statuses;
+		for (const NamedBackgroundEmulations::value_type& emulation : state->backgroundEmulations) {
+			statuses.push_back(fmt::format("Minimal machine '{}' {}", emulation.first, (emulation.second)->getStatus()));
+		}
+		std::sort(statuses.begin(), statuses.end());
+
+		return { false, fmt::format("{}", fmt::join(statuses, "\n")) };
+	};
+
+	static const MiMaCLIStateModifier minimalMachineStop = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input, 1);
+
+		CommandUtility::validateIdentifier(arguments[0], MiMaCLIState::identifierPattern);
+
+		NamedBackgroundEmulations::iterator foundEmulation = (state->backgroundEmulations).find(arguments[0]);
+		if (foundEmulation == (state->backgroundEmulations).end()) {
+			throw CommandException(fmt::format("Minimal machine '{}' was never started in the background", arguments[0]));
+		}
+
+		//the machine keeps its state, so it can be inspected or started again
+		(foundEmulation->second)->stop();
+		std::string status = (foundEmulation->second)->getStatus();
+		(state->backgroundEmulations).erase(foundEmulation);
+
+		return { false, fmt::format("Minimal machine '{}' {}", arguments[0], status) };
+	};
+
+
+	// --- Pipeline command functions ---
+
+	static const MiMaCLIStateModifier pipelineCheck = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: programFileName microprogramName [checkInterval [instructionLimit]]
+		if (arguments.size() < 2 || arguments.size() > 4) {
+			throw CommandException(fmt::format("expected 2 to 4 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[1], MiMaCLIState::identifierPattern);
+		uint64_t checkInterval = arguments.size() >= 3 ? std::max<uint64_t>(CommandUtility::validatePositiveDecimalInteger(arguments[2]), 1) : MiMa::DifferentialChecker::DEFAULT_CHECK_INTERVAL;
+		uint64_t instructionLimit = arguments.size() == 4 ? CommandUtility::validatePositiveDecimalInteger(arguments[3]) : std::numeric_limits<uint64_t>::max();
+
+		NamedMicroPrograms::const_iterator foundMicroprogram = (state->microprograms).find(arguments[1]);
+		if (foundMicroprogram == (state->microprograms).end()) {
+			throw CommandException(fmt::format("No microprogram under the name '{}' exists", arguments[1]));
+		}
+
+		//the pipeline runs on the second thread, since it is the faster engine
+		MiMa::DifferentialChecker checker(
+			std::make_unique<MiMa::MachineEngine<MiMa::MinimalMachine>>(arguments[1], std::make_shared<MiMa::MinimalMachine>(foundMicroprogram->second, std::make_shared<MiMa::MiMaMemory>())),
+			std::make_unique<MiMa::MachineEngine<MiMa::PipelinedMachine>>("pipeline", std::make_shared<MiMa::PipelinedMachine>(std::make_shared<MiMa::MiMaMemory>())),
+			compileCheckedProgram(arguments[0]), checkInterval);
+
+		return runDifferentialCheck(checker, instructionLimit);
+	};
+
+	static const MiMaCLIStateModifier pipelineCompare = [](const std::string& input, const std::shared_ptr<MiMaCLIState>& state)->CommandResult {
+		std::vector<std::string> arguments = CommandUtility::getArguments(input);
+
+		//expected format: programFileName microprogramName [cycleLimit]
+		if (arguments.size() != 2 && arguments.size() != 3) {
+			throw CommandException(fmt::format("expected 2 or 3 arguments, got {}", arguments.size()));
+		}
+
+		CommandUtility::validateIdentifier(arguments[1], MiMaCLIState::identifierPattern);
+		uint64_t cycleLimit = std::numeric_limits<uint64_t>::max();
+		if (arguments.size() == 3) {
+			cycleLimit = CommandUtility::validatePositiveDecimalInteger(arguments[2]);
+		}
+
+		NamedMicroPrograms::const_iterator foundMicroprogram = (state->microprograms).find(arguments[1]);
+		if (foundMicroprogram == (state->microprograms).end()) {
+			throw CommandException(fmt::format("No microprogram under the name '{}' exists", arguments[1]));
+		}
+
+		//both machines run on their own copy of the program, so their results can be compared
+		std::shared_ptr<MiMa::MiMaMemory> microcodedMemory;
+		std::shared_ptr<MiMa::MiMaMemory> pipelinedMemory;
+		try {
+			microcodedMemory = MiMa::MiMaMemoryCompiler::compileFile(arguments[0]);
+			pipelinedMemory = MiMa::MiMaMemoryCompiler::compileFile(arguments[0]);
+		}
+		catch (const MiMa::CompilerException& exc) {
+			throw CommandException(exc);
+		}
+
+		MiMa::MinimalMachine microcoded(foundMicroprogram->second, microcodedMemory);
+		MiMa::PipelinedMachine pipelined(pipelinedMemory);
+		microcoded.emulateLifeTime(cycleLimit);
+		pipelined.emulateLifeTime(cycleLimit);
+
+		fmt::memory_buffer output;
+		fmt::format_to(std::back_inserter(output), "Microcoded minimal machine{}: {} cycles for {} instructions, {:.3f} cycles per instruction\n", microcoded.isRunning() ? " (cycle limit reached)" : "",
+			microcoded.getCycleCount(), microcoded.getInstructionCount(), microcoded.getInstructionCount() == 0 ? 0.0 : (double)microcoded.getCycleCount() / microcoded.getInstructionCount());
+		fmt::format_to(std::back_inserter(output), "Pipelined minimal machine{}: ", pipelined.isRunning() ? " (cycle limit reached)" : "");
+
+		std::ostringstream report;
+		pipelined.getStatistics().writeReport(report);
+		fmt::format_to(std::back_inserter(output), "{}", report.str());
+
+		//cut off runs may have stopped at different points of the program
+		if (!microcoded.isRunning() && !pipelined.isRunning()) {
+			std::vector<MiMa::MemoryDifference> differences = MiMa::diff(*microcodedMemory, *pipelinedMemory);
+			fmt::format_to(std::back_inserter(output), differences.empty() ? "The memories of both machines match" : "The memories of both machines differ in {} cells", differences.size());
+		}
+
+		return { false, fmt::to_string(output) };
+	};
+
+
+
 	MiMaCommandExecutor::MiMaCommandExecutor(const std::shared_ptr<MiMaCLIState>& state) :
 		ConditionalCommand({
 			{ "exit", new UniversalCommand(exitFunction) },
+			{ "log", new MiMaCLIStateCommand(state, logFunction) },
 			{ "microprogram", new ConditionalCommand({
 				{ "compile", new MiMaCLIStateCommand(state, microprogramCompileFunction) },
+				{ "check", new MiMaCLIStateCommand(state, microprogramCheckFunction) },
+				{ "optimize", new MiMaCLIStateCommand(state, microprogramOptimizeFunction) },
 				{ "show", new MiMaCLIStateCommand(state, microprogramShowFunction) }
 			}) },
 			{ "mima", new ConditionalCommand({
 				{ "compile", new MiMaCLIStateCommand(state, minimalMachineCompile) },
+				{ "load", new MiMaCLIStateCommand(state, minimalMachineLoad) },
 				{ "show", new MiMaCLIStateCommand(state, minimalMachineShow) },
-				{ "emulate", new MiMaCLIStateCommand(state, minimalMachineEmulate) }
+				{ "dump", new MiMaCLIStateCommand(state, minimalMachineDump) },
+				{ "diff", new MiMaCLIStateCommand(state, minimalMachineDiff) },
+				{ "devices", new MiMaCLIStateCommand(state, minimalMachineDevices) },
+				{ "emulate", new MiMaCLIStateCommand(state, minimalMachineEmulate) },
+				{ "profile", new MiMaCLIStateCommand(state, minimalMachineProfile) },
+				{ "report", new MiMaCLIStateCommand(state, minimalMachineReport) },
+				{ "record", new MiMaCLIStateCommand(state, minimalMachineRecord) },
+				{ "replay", new MiMaCLIStateCommand(state, minimalMachineReplay) },
+				{ "start", new MiMaCLIStateCommand(state, minimalMachineStart) },
+				{ "status", new MiMaCLIStateCommand(state, minimalMachineStatus) },
+				{ "stop", new MiMaCLIStateCommand(state, minimalMachineStop) }
+			}) },
+			{ "pipeline", new ConditionalCommand({
+				{ "check", new MiMaCLIStateCommand(state, pipelineCheck) },
+				{ "compare", new MiMaCLIStateCommand(state, pipelineCompare) }
 			}) }
 		})
 	{}
@@ -2,26 +2,40 @@
 
 //std library
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
 //minimal machine
 #include "mima/microprogram/MicroProgram.h"
+#include "mima/mimaprogram/MiMaCompiler.h"
 #include "mima/MinimalMachine.h"
 
 //internal classes
 #include "CLI/Command.h"
+#include "BackgroundEmulation.h"
 
 
 namespace MiMaCLI {
 	typedef std::unordered_map<std::string, std::shared_ptr<const MiMa::MicroProgram>> NamedMicroPrograms;
 	typedef std::unordered_map<std::string, std::shared_ptr<MiMa::MinimalMachine>> NamedMinimalMachines;
+	typedef std::unordered_map<std::string, std::unique_ptr<BackgroundEmulation>> NamedBackgroundEmulations;
+
+	//symbols and source lines of a compiled program, to annotate profiles
+	struct ProgramSource {
+		MiMa::MiMaSymbolTable symbols;
+		MiMa::MiMaSourceMap sourceMap;
+	};
+	typedef std::unordered_map<std::string, ProgramSource> NamedProgramSources;
 
 	struct MiMaCLIState {
 		static const std::regex identifierPattern;
 
 		NamedMicroPrograms microprograms = NamedMicroPrograms();
 		NamedMinimalMachines minimalMachines = NamedMinimalMachines();
+		NamedProgramSources programSources = NamedProgramSources(); //of the minimal machines compiled from code
+		//background emulations, stopped on destruction before the minimal machines they run
+		NamedBackgroundEmulations backgroundEmulations = NamedBackgroundEmulations();
 	};
 
 
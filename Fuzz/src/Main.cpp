@@ -0,0 +1,154 @@
+//std library
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//minimal machine
+#include "mima/CompilerException.h"
+
+//internal classes
+#include "fuzz/FuzzDriver.h"
+
+//debugging utility
+#include "debug/Log.h"
+
+
+static const char* USAGE = "usage: mima-fuzz [--threads <count>] [--seed <seed>] [--cases <count>] [--seconds <seconds>] [--cycles <budget>] [--hang <seconds>] [--case <caseSeed>] <referenceMicroprogramFileName>";
+
+//exit codes
+static const int NO_FINDINGS = 0;
+static const int FINDINGS = 1;
+static const int INVALID_INVOCATION = 2;
+static const int CRASHED = 4;
+
+static_assert(MiMaFuzz::FuzzDriver::HANG_EXIT_CODE == 3, "the exit codes of the fuzz driver have to be distinct");
+
+
+//the driver running while a signal arrives, to name the crashing case
+static MiMaFuzz::FuzzDriver* runningDriver = nullptr;
+
+static void onCrash(int signal) {
+	std::fprintf(stderr, "crashed with signal %d\n", signal);
+	if (runningDriver) {
+		runningDriver->writeRunningCases(stderr);
+	}
+	std::_Exit(CRASHED);
+}
+
+
+//accepts decimal and 0x prefixed hexadecimal numbers, so case seeds can be copied from the findings
+static uint64_t parseNumber(const std::string& text) {
+	size_t end = 0;
+	uint64_t number = std::stoull(text, &end, 0);
+	if (end != text.size()) {
+		throw std::invalid_argument(text);
+	}
+	return number;
+}
+
+
+int main(int argc, char** argv) {
+	MiMaFuzz::FuzzOptions options;
+	std::string microProgramFileName;
+	bool reproducing = false;
+	uint64_t caseSeed = 0;
+
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	for (size_t i = 0; i < arguments.size(); ++i) {
+		bool hasValue = i + 1 < arguments.size();
+
+		try {
+			if (arguments[i] == "--threads" && hasValue) {
+				options.threadCount = (size_t)parseNumber(arguments[++i]);
+			}
+			else if (arguments[i] == "--seed" && hasValue) {
+				options.seed = parseNumber(arguments[++i]);
+			}
+			else if (arguments[i] == "--cases" && hasValue) {
+				options.caseCount = parseNumber(arguments[++i]);
+			}
+			else if (arguments[i] == "--seconds" && hasValue) {
+				options.seconds = std::stod(arguments[++i]);
+			}
+			else if (arguments[i] == "--cycles" && hasValue) {
+				options.cycleBudget = parseNumber(arguments[++i]);
+			}
+			else if (arguments[i] == "--hang" && hasValue) {
+				options.hangSeconds = std::stod(arguments[++i]);
+			}
+			else if (arguments[i] == "--case" && hasValue) {
+				caseSeed = parseNumber(arguments[++i]);
+				reproducing = true;
+			}
+			else if (microProgramFileName.empty() && arguments[i].rfind("--", 0) != 0) {
+				microProgramFileName = arguments[i];
+			}
+			else {
+				std::cerr << fmt::format("unexpected argument '{}'\n{}\n", arguments[i], USAGE);
+				return INVALID_INVOCATION;
+			}
+		}
+		catch (const std::exception&) {
+			std::cerr << fmt::format("invalid value '{}' for '{}'\n{}\n", arguments[i], arguments[i - 1], USAGE);
+			return INVALID_INVOCATION;
+		}
+	}
+
+	if (microProgramFileName.empty() || (options.caseCount == 0 && options.seconds <= 0)) {
+		std::cerr << USAGE << "\n";
+		return INVALID_INVOCATION;
+	}
+
+	std::ifstream microProgramFile(microProgramFileName);
+	if (!microProgramFile.good()) {
+		std::cerr << fmt::format("failed to open reference microprogram '{}'\n", microProgramFileName);
+		return INVALID_INVOCATION;
+	}
+	std::stringstream microProgramCode;
+	microProgramCode << microProgramFile.rdbuf();
+
+	//most generated code is invalid, logging every compiler error would dominate the run time
+	MiMa::mimaDefaultLog.setLogLevel(spdlog::level::off);
+
+	std::unique_ptr<MiMaFuzz::FuzzDriver> driver;
+	try {
+		driver = std::make_unique<MiMaFuzz::FuzzDriver>(microProgramCode.str(), options);
+	}
+	catch (const MiMa::CompilerException& exc) {
+		std::cerr << fmt::format("failed to compile reference microprogram '{}': {}\n", microProgramFileName, exc.what());
+		return INVALID_INVOCATION;
+	}
+
+	runningDriver = driver.get();
+	std::signal(SIGSEGV, onCrash);
+	std::signal(SIGFPE, onCrash);
+	std::signal(SIGILL, onCrash);
+	std::signal(SIGABRT, onCrash);
+
+	MiMaFuzz::FuzzStatistics statistics;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<MiMaFuzz::Finding> findings = reproducing ? driver->reproduce(caseSeed, statistics) : driver->run(statistics);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (const MiMaFuzz::Finding& finding : findings) {
+		std::cout << fmt::format("case 0x{:016X} ({}): {}\n", finding.seed, MiMaFuzz::toString(finding.kind), finding.description);
+	}
+	std::cout << fmt::format("{} cases in {:.1f}s ({:.0f} per second), {} findings\n", statistics.cases, seconds, statistics.cases / std::max(seconds, 1e-9), findings.size());
+	std::cout << fmt::format("rejected {} programs and {} microprograms, {} runs halted, compared {} instructions over {} cycles\n",
+		statistics.rejectedPrograms, statistics.rejectedMicroprograms, statistics.halted, statistics.instructions, statistics.cycles);
+
+	runningDriver = nullptr;
+	return findings.empty() ? NO_FINDINGS : FINDINGS;
+}
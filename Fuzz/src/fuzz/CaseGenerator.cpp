@@ -0,0 +1,207 @@
+#include "CaseGenerator.h"
+
+//std library
+#include <algorithm>
+#include <vector>
+
+//external vendor libraries
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+
+namespace MiMaFuzz {
+	// --- Constants definitions ---
+
+	static const char* const MNEMONICS[] = { "LDC", "LDV", "STV", "ADD", "AND", "OR", "XOR", "EQL", "JMP", "JMN" };
+	static const char* const FUNCTIONS[] = { "HALT", "NOT", "RAR", "DS" };
+
+	static const char* const WRITING_REGISTERS[] = { "SDR", "IR", "IAR", "ONE", "Z", "ACCU" };
+	static const char* const READING_REGISTERS[] = { "SAR", "SDR", "IR", "IAR", "X", "Y", "ACCU" };
+	static const char* const ALU_OPERATIONS[] = { "RETURN", "ADD", "RAR", "AND", "OR", "XOR", "NOT", "EQL" };
+
+	//fragments of both languages, so mutations produce almost valid code
+	static const char* const TOKENS[] = { ";", ":", "#", "->", "=", "[", "]", ",", "$", "*", "\n", " ", "R = 1", "W = 1", "ALU", "max", "!cm(", ")", "conditional", "op_code", "accumulator_negative", "start", "-", "0", "255", "99999999999", "$FFFFFFFF", "LDV", "DS" };
+
+	template<typename T, size_t size>
+	static constexpr size_t countOf(const T(&)[size]) { return size; }
+
+
+	uint32_t CaseGenerator::generateCell(const size_t& programSize) {
+		switch (below(8)) {
+		case 0:
+		case 1:
+		case 2:
+		case 3:
+		case 4:
+			//short operation on an address within the program
+			return ((uint32_t)below(10) << 20) | (uint32_t)below(programSize);
+		case 5:
+			//HALT, NOT, RAR or now and then an unknown long operation
+			return 0xF00000 | ((uint32_t)(chance(8) ? below(16) : below(3)) << 16);
+		case 6:
+			//small numbers, sometimes negative
+			return chance(4) ? 0xFFFFFF - (uint32_t)below(16) : (uint32_t)below(16);
+		case 7:
+		default:
+			return (uint32_t)random() & 0xFFFFFF;
+		}
+	}
+
+
+	std::shared_ptr<MiMa::MemoryImage> CaseGenerator::generateImage() {
+		std::shared_ptr<MiMa::MemoryImage> image = std::make_shared<MiMa::MemoryImage>();
+		size_t programSize = 1 + below(IMAGE_SIZE);
+
+		for (size_t address = 0; address < programSize; ++address) {
+			image->store(address, generateCell(programSize));
+		}
+
+		return image;
+	}
+
+
+	std::string CaseGenerator::generateProgram() {
+		fmt::memory_buffer program;
+		size_t lineCount = 1 + below(IMAGE_SIZE);
+		size_t labelCount = 1 + below(8);
+
+		if (chance(4)) {
+			fmt::format_to(std::back_inserter(program), "* = {}\n", below(IMAGE_SIZE));
+		}
+		if (chance(4)) {
+			fmt::format_to(std::back_inserter(program), "c = ${:X}\n", below(0x1000000));
+		}
+
+		//labels are defined at random lines, some of them never, which fails the compilation
+		for (size_t line = 0; line < lineCount; ++line) {
+			if (chance(4)) {
+				fmt::format_to(std::back_inserter(program), "l{}: ", below(labelCount));
+			}
+
+			if (chance(4)) {
+				fmt::format_to(std::back_inserter(program), "{}", FUNCTIONS[below(countOf(FUNCTIONS))]);
+			}
+			else {
+				std::string operand = chance(3) ? fmt::format("l{}", below(labelCount)) : chance(2) ? fmt::format("${:X}", below(IMAGE_SIZE)) : fmt::format("{}", below(IMAGE_SIZE));
+				fmt::format_to(std::back_inserter(program), "{} {}", chance(8) ? "DS" : MNEMONICS[below(countOf(MNEMONICS))], operand);
+			}
+
+			fmt::format_to(std::back_inserter(program), chance(8) ? " ;comment\n" : "\n");
+		}
+
+		return fmt::to_string(program);
+	}
+
+
+	std::string CaseGenerator::generateMicroInstruction(const size_t& routineCount) {
+		std::vector<std::string> statements;
+
+		//distinct registers, a register can't be written twice in one cycle anyway
+		size_t transferCount = below(3);
+		for (size_t i = 0; i < transferCount; ++i) {
+			statements.push_back(fmt::format("{} -> {}", WRITING_REGISTERS[below(countOf(WRITING_REGISTERS))], READING_REGISTERS[below(countOf(READING_REGISTERS))]));
+		}
+		std::sort(statements.begin(), statements.end());
+		statements.erase(std::unique(statements.begin(), statements.end()), statements.end());
+
+		switch (below(4)) {
+		case 0:
+			statements.push_back("R = 1");
+			break;
+		case 1:
+			statements.push_back("W = 1");
+			break;
+		}
+		if (chance(3)) {
+			statements.push_back(fmt::format("ALU = {}", ALU_OPERATIONS[below(countOf(ALU_OPERATIONS))]));
+		}
+
+		//jumps end the routine, see generateMicroProgram
+		if (chance(6)) {
+			statements.push_back(chance(2) ? "#start" : fmt::format("#r{}", below(routineCount)));
+		}
+
+		return fmt::format("{};", fmt::join(statements, "; "));
+	}
+
+
+	std::string CaseGenerator::generateMicroProgram() {
+		fmt::memory_buffer microprogram;
+
+		if (chance(8)) {
+			fmt::format_to(std::back_inserter(microprogram), "start: {}\n", generateMicroInstruction(ROUTINE_COUNT));
+		}
+		else {
+			fmt::format_to(std::back_inserter(microprogram), "start: IAR -> SAR; IAR -> X; R = 1;\nONE -> Y; R = 1;\nALU = ADD; R = 1;\nZ -> IAR;\nSDR -> IR;\n");
+		}
+
+		//every op code range is decoded to a random routine, unused routines are still compiled
+		fmt::format_to(std::back_inserter(microprogram), "!cm(conditional, op_code, 255)\n[0, max] #r0");
+		size_t rangeCount = below(16);
+		for (size_t i = 0; i < rangeCount; ++i) {
+			size_t lower = below(256);
+			fmt::format_to(std::back_inserter(microprogram), "\n[{}, {}] #r{}", lower, lower + below(256 - lower), below(ROUTINE_COUNT));
+		}
+		fmt::format_to(std::back_inserter(microprogram), ";\n!cm(default)\n");
+
+		for (size_t routine = 0; routine < ROUTINE_COUNT; ++routine) {
+			if (chance(8)) {
+				fmt::format_to(std::back_inserter(microprogram), "r{}:\n!cm(conditional, accumulator_negative, 1)\n[0, 0] #r{}\n[1, 1] #r{};\n!cm(default)\n", routine, below(ROUTINE_COUNT), below(ROUTINE_COUNT));
+				continue;
+			}
+
+			fmt::format_to(std::back_inserter(microprogram), "r{}: ", routine);
+
+			size_t lineCount = 1 + below(6);
+			for (size_t line = 0; line < lineCount; ++line) {
+				std::string microInstruction = generateMicroInstruction(ROUTINE_COUNT);
+				bool jumping = microInstruction.find('#') != std::string::npos;
+
+				//without a jump, the last line returns to the fetch
+				if (line + 1 == lineCount && !jumping) {
+					microInstruction += " #start;";
+				}
+				fmt::format_to(std::back_inserter(microprogram), "{}\n", microInstruction);
+
+				if (jumping) {
+					break;
+				}
+			}
+		}
+
+		return fmt::to_string(microprogram);
+	}
+
+
+	std::string CaseGenerator::mutate(const std::string& text) {
+		std::string mutated = text;
+
+		size_t mutationCount = 1 + below(4);
+		for (size_t i = 0; i < mutationCount; ++i) {
+			size_t position = mutated.empty() ? 0 : below(mutated.size() + 1);
+			size_t length = std::min<size_t>(1 + below(8), mutated.size() - position);
+
+			switch (below(5)) {
+			case 0:
+				mutated.erase(position, length);
+				break;
+			case 1:
+				mutated.insert(position, mutated.substr(position, length));
+				break;
+			case 2:
+				if (position < mutated.size()) {
+					mutated[position] = (char)(32 + below(95));
+				}
+				break;
+			case 3:
+				mutated.insert(position, TOKENS[below(countOf(TOKENS))]);
+				break;
+			case 4:
+				mutated.resize(position);
+				break;
+			}
+		}
+
+		return mutated;
+	}
+}
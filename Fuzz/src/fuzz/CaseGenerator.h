@@ -0,0 +1,54 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+//minimal machine
+#include "mima/mimaprogram/MiMaMemory.h"
+
+
+namespace MiMaFuzz {
+	// ------------------------------------------------
+	// Fuzz case generator
+	//
+	// Generates the inputs of a single fuzz case from
+	// its seed, so every case can be reproduced from
+	// the seed alone. Memory images are generated as
+	// cells, skipping the program compiler. Programs
+	// and microprograms are generated as valid text,
+	// which mutate() turns into mostly invalid text.
+	// ------------------------------------------------
+
+	class CaseGenerator {
+	public:
+		//images only use the lowest addresses, so jumps and accesses mostly stay within the program
+		static constexpr size_t IMAGE_SIZE = 64;
+		static constexpr size_t ROUTINE_COUNT = 12;
+
+	private:
+		std::mt19937_64 random;
+
+		inline size_t below(const size_t& bound) { return (size_t)(random() % bound); }
+		inline bool chance(const size_t& oneIn) { return below(oneIn) == 0; }
+
+		uint32_t generateCell(const size_t& programSize);
+		std::string generateMicroInstruction(const size_t& routineCount);
+
+	public:
+		CaseGenerator(const uint64_t& seed) : random(seed) {}
+
+		inline uint64_t next() { return random(); }
+
+		std::shared_ptr<MiMa::MemoryImage> generateImage();
+		//assembler code for MiMa::MiMaMemoryCompiler
+		std::string generateProgram();
+		//microprogram code for MiMa::MicroProgramCompiler, mostly decoding all op codes to random routines after the usual fetch
+		std::string generateMicroProgram();
+
+		//deletes, duplicates, replaces and inserts characters and tokens of the text
+		std::string mutate(const std::string& text);
+	};
+}
@@ -0,0 +1,419 @@
+#include "FuzzDriver.h"
+
+//std library
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//minimal machine
+#include "mima/microprogram/MicroProgramCompiler.h"
+#include "mima/mimaprogram/MiMaCompiler.h"
+#include "mima/DifferentialChecker.h"
+#include "mima/microprogram/MicroProgramOptimizer.h"
+#include "mima/CompilerException.h"
+
+//internal classes
+#include "CaseGenerator.h"
+
+
+namespace MiMaFuzz {
+	const char* toString(const CaseKind& kind) {
+		switch (kind) {
+		case CaseKind::ENGINES:
+			return "engines";
+		case CaseKind::MICROPROGRAM:
+			return "microprogram";
+		case CaseKind::PROGRAM:
+		default:
+			return "program";
+		}
+	}
+
+
+	FuzzStatistics& FuzzStatistics::operator+=(const FuzzStatistics& other) {
+		cases += other.cases;
+		rejectedPrograms += other.rejectedPrograms;
+		rejectedMicroprograms += other.rejectedMicroprograms;
+		halted += other.halted;
+		instructions += other.instructions;
+		cycles += other.cycles;
+
+		return *this;
+	}
+
+
+
+	// -------------------
+	// Lockstep comparison
+	// -------------------
+
+	enum class Step {
+		COMPLETED,
+		HALTED,
+		OUT_OF_CYCLES
+	};
+
+	//steps clock cycles instead of instructions, since a generated microprogram may never complete one
+	template<typename Machine>
+	static Step emulateInstruction(Machine& mima, const uint64_t& cycleBudget, MiMa::ArchitecturalState& state) {
+		uint32_t address = mima.getInstructionAddress();
+		uint64_t instructions = mima.getInstructionCount();
+
+		while (mima.isRunning() && mima.getInstructionCount() == instructions) {
+			if (mima.getCycleCount() >= cycleBudget) {
+				return Step::OUT_OF_CYCLES;
+			}
+			mima.emulateClockCycle();
+		}
+
+		if (mima.getInstructionCount() == instructions) {
+			return Step::HALTED;
+		}
+
+		state = { address, (uint32_t)mima.getInstructionRegister(), (uint32_t)mima.getAccumulator() };
+		return Step::COMPLETED;
+	}
+
+	static std::string describe(const Step& step, const MiMa::ArchitecturalState& state) {
+		switch (step) {
+		case Step::COMPLETED:
+			return fmt::format("executed 0x{:06X} at 0x{:05X}, accumulator 0x{:06X}", state.instruction, state.address, state.accumulator);
+		case Step::HALTED:
+			return "halted";
+		case Step::OUT_OF_CYCLES:
+		default:
+			return "ran out of cycles";
+		}
+	}
+
+	//runs both machines from their current state until the reference one halts or runs out of cycles, returns the first difference or an empty string
+	template<typename Reference, typename Other>
+	static std::string compareLockstep(Reference& reference, Other& other, const uint64_t& cycleBudget, FuzzStatistics& statistics) {
+		MiMa::ArchitecturalState referenceState = {};
+		MiMa::ArchitecturalState otherState = {};
+
+		for (uint64_t instruction = 1;; ++instruction) {
+			Step referenceStep = emulateInstruction(reference, cycleBudget, referenceState);
+			if (referenceStep == Step::OUT_OF_CYCLES) {
+				return "";
+			}
+
+			//the other engine gets twice the budget, being slower is no finding
+			Step otherStep = emulateInstruction(other, 2 * cycleBudget, otherState);
+			if (otherStep != referenceStep || (referenceStep == Step::COMPLETED && referenceState != otherState)) {
+				return fmt::format("instruction {}: reference {}, other {}", instruction, describe(referenceStep, referenceState), describe(otherStep, otherState));
+			}
+
+			if (referenceStep == Step::HALTED) {
+				statistics.halted++;
+
+				std::vector<MiMa::MemoryDifference> differences = MiMa::diff(*reference.getMemory(), *other.getMemory());
+				if (!differences.empty()) {
+					return fmt::format("memory after halting differs in {} cells, first 0x{:05X}: reference {}, other {}", differences.size(), differences[0].address, differences[0].left, differences[0].right);
+				}
+				return "";
+			}
+
+			statistics.instructions++;
+		}
+	}
+
+
+
+	// -----------
+	// Fuzz driver
+	// -----------
+
+	struct FuzzDriver::Worker {
+		MiMa::MinimalMachine reference;
+		MiMa::MinimalMachine optimizedReference;
+		MiMa::PipelinedMachine pipeline;
+
+		FuzzStatistics statistics;
+		std::vector<Finding> findings;
+
+		Worker(const std::shared_ptr<const MiMa::MicroProgram>& reference, const std::shared_ptr<const MiMa::MicroProgram>& optimizedReference) :
+			reference(reference, std::make_shared<MiMa::MiMaMemory>()),
+			optimizedReference(optimizedReference, std::make_shared<MiMa::MiMaMemory>()),
+			pipeline(std::make_shared<MiMa::MiMaMemory>())
+		{}
+	};
+
+
+	FuzzDriver::FuzzDriver(const std::string& referenceMicroProgramCode, const FuzzOptions& options) :
+		reference(MiMa::MicroProgramCompiler::compile(referenceMicroProgramCode)),
+		options(options)
+	{
+		MiMa::MicroProgramOptimization optimization;
+		optimizedReference = MiMa::MicroProgramCompiler::compile(referenceMicroProgramCode, &optimization);
+	}
+
+
+	uint64_t FuzzDriver::getCaseSeed(const uint64_t& runSeed, const uint64_t& index) {
+		//splitmix64, so neighbouring cases get unrelated seeds
+		uint64_t seed = runSeed + (index + 1) * 0x9E3779B97F4A7C15;
+		seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9;
+		seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EB;
+		return seed ^ (seed >> 31);
+	}
+
+
+	void FuzzDriver::runEngineCase(Worker& worker, const uint64_t& seed, const bool& verbose) {
+		CaseGenerator generator(seed);
+		std::shared_ptr<MiMa::MemoryImage> image = generator.generateImage();
+
+		if (verbose) {
+			std::cout << fmt::format("image:\n{:0,64}\n", *image) << std::flush;
+		}
+
+		//every reset restores the whole image, since it differs from the one of the previous case
+		worker.reference.reset(*image);
+		worker.pipeline.reset(*image);
+		std::string difference = compareLockstep(worker.reference, worker.pipeline, options.cycleBudget, worker.statistics);
+		if (!difference.empty()) {
+			worker.findings.push_back({ seed, CaseKind::ENGINES, fmt::format("pipeline diverged from the reference microprogram at {}", difference) });
+		}
+		worker.statistics.cycles += worker.reference.getCycleCount();
+
+		worker.reference.reset(*image);
+		worker.optimizedReference.reset(*image);
+		difference = compareLockstep(worker.reference, worker.optimizedReference, options.cycleBudget, worker.statistics);
+		if (!difference.empty()) {
+			worker.findings.push_back({ seed, CaseKind::ENGINES, fmt::format("optimized microprogram diverged from the reference microprogram at {}", difference) });
+		}
+		worker.statistics.cycles += worker.reference.getCycleCount();
+	}
+
+	void FuzzDriver::runMicroProgramCase(Worker& worker, const uint64_t& seed, const bool& verbose) {
+		CaseGenerator generator(seed);
+		std::string code = generator.generateMicroProgram();
+		if (generator.next() % 2 == 0) {
+			code = generator.mutate(code);
+		}
+
+		if (verbose) {
+			std::cout << fmt::format("microprogram:\n{}\n", code) << std::flush;
+		}
+
+		std::shared_ptr<const MiMa::MicroProgram> microprogram;
+		try {
+			microprogram = MiMa::MicroProgramCompiler::compile(code);
+		}
+		catch (const MiMa::CompilerException&) {
+			worker.statistics.rejectedMicroprograms++;
+			return;
+		}
+
+		//the optimizer has to accept every microprogram the compiler does
+		std::shared_ptr<const MiMa::MicroProgram> optimized;
+		try {
+			MiMa::MicroProgramOptimization optimization;
+			optimized = MiMa::MicroProgramCompiler::compile(code, &optimization);
+		}
+		catch (const MiMa::CompilerException& exc) {
+			worker.findings.push_back({ seed, CaseKind::MICROPROGRAM, fmt::format("only compiled without the optimizer: {}", exc.what()) });
+			return;
+		}
+
+		std::shared_ptr<MiMa::MemoryImage> image = generator.generateImage();
+		if (verbose) {
+			std::cout << fmt::format("image:\n{:0,64}\n", *image) << std::flush;
+		}
+
+		MiMa::MinimalMachine plain(microprogram, std::make_shared<MiMa::MiMaMemory>(*image));
+		MiMa::MinimalMachine optimizedPlain(optimized, std::make_shared<MiMa::MiMaMemory>(*image));
+		std::string difference = compareLockstep(plain, optimizedPlain, options.cycleBudget, worker.statistics);
+		if (!difference.empty()) {
+			worker.findings.push_back({ seed, CaseKind::MICROPROGRAM, fmt::format("optimized microprogram diverged at {}", difference) });
+		}
+		worker.statistics.cycles += plain.getCycleCount();
+	}
+
+	void FuzzDriver::runProgramCase(Worker& worker, const uint64_t& seed, const bool& verbose) {
+		CaseGenerator generator(seed);
+		std::string code = generator.generateProgram();
+		if (generator.next() % 2 == 0) {
+			code = generator.mutate(code);
+		}
+		size_t threadCount = 2 + generator.next() % 3;
+
+		if (verbose) {
+			std::cout << fmt::format("program, compiled on {} threads:\n{}\n", threadCount, code) << std::flush;
+		}
+
+		//both compilations have to produce the same memory or both fail, though not necessarily on the same error, since the parallel compilation parses all lines before defining any symbol
+		std::shared_ptr<MiMa::MiMaMemory> sequential;
+		std::shared_ptr<MiMa::MiMaMemory> parallel;
+		std::string sequentialError;
+		std::string parallelError;
+		try {
+			sequential = MiMa::MiMaMemoryCompiler::compile(code);
+		}
+		catch (const MiMa::CompilerException& exc) {
+			sequentialError = exc.what();
+		}
+		try {
+			parallel = MiMa::MiMaMemoryCompiler::compileParallel(code, threadCount);
+		}
+		catch (const MiMa::CompilerException& exc) {
+			parallelError = exc.what();
+		}
+
+		if (sequentialError.empty() != parallelError.empty()) {
+			worker.findings.push_back({ seed, CaseKind::PROGRAM, fmt::format("sequential compilation {}, parallel compilation {}",
+				sequential ? "succeeded" : fmt::format("failed with '{}'", sequentialError), parallel ? "succeeded" : fmt::format("failed with '{}'", parallelError)) });
+			return;
+		}
+		if (!sequential) {
+			worker.statistics.rejectedPrograms++;
+			return;
+		}
+
+		std::vector<MiMa::MemoryDifference> differences = MiMa::diff(*sequential, *parallel);
+		if (!differences.empty()) {
+			worker.findings.push_back({ seed, CaseKind::PROGRAM, fmt::format("sequential and parallel compilation differ in {} cells, first 0x{:05X}: {} and {}", differences.size(), differences[0].address, differences[0].left, differences[0].right) });
+			return;
+		}
+
+		worker.reference.reset(*sequential);
+		worker.pipeline.reset(*sequential);
+		std::string difference = compareLockstep(worker.reference, worker.pipeline, options.cycleBudget, worker.statistics);
+		if (!difference.empty()) {
+			worker.findings.push_back({ seed, CaseKind::PROGRAM, fmt::format("pipeline diverged from the reference microprogram at {}", difference) });
+		}
+		worker.statistics.cycles += worker.reference.getCycleCount();
+	}
+
+
+	void FuzzDriver::runCase(Worker& worker, const uint64_t& seed, const bool& verbose) {
+		CaseKind kind = (CaseKind)(seed % 3);
+		worker.statistics.cases++;
+
+		//compiler exceptions are expected for invalid code and caught by the cases, everything else is a finding
+		try {
+			switch (kind) {
+			case CaseKind::ENGINES:
+				runEngineCase(worker, seed, verbose);
+				break;
+			case CaseKind::MICROPROGRAM:
+				runMicroProgramCase(worker, seed, verbose);
+				break;
+			case CaseKind::PROGRAM:
+				runProgramCase(worker, seed, verbose);
+				break;
+			}
+		}
+		catch (const std::exception& exc) {
+			worker.findings.push_back({ seed, kind, fmt::format("threw '{}'", exc.what()) });
+		}
+		catch (...) {
+			worker.findings.push_back({ seed, kind, "threw an unknown exception" });
+		}
+	}
+
+
+	std::vector<Finding> FuzzDriver::run(FuzzStatistics& statistics) {
+		workerCount = options.threadCount == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : options.threadCount;
+		workerStates = std::make_unique<WorkerState[]>(workerCount);
+		for (size_t i = 0; i < workerCount; ++i) {
+			workerStates[i].seed = 0;
+			workerStates[i].caseStart = 0;
+		}
+
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.seconds));
+		std::atomic<uint64_t> nextCase(0);
+		std::atomic<bool> done(false);
+
+		std::vector<std::vector<Finding>> workerFindings(workerCount);
+		std::vector<FuzzStatistics> workerStatistics(workerCount);
+		std::vector<std::thread> workers;
+
+		for (size_t i = 0; i < workerCount; ++i) {
+			workers.emplace_back([this, &deadline, &nextCase, &workerFindings, &workerStatistics, i]() {
+				Worker worker(reference, optimizedReference);
+				WorkerState& state = workerStates[i];
+
+				for (uint64_t index = nextCase++; options.caseCount == 0 || index < options.caseCount; index = nextCase++) {
+					if (options.seconds > 0 && std::chrono::steady_clock::now() >= deadline) {
+						break;
+					}
+
+					uint64_t seed = getCaseSeed(options.seed, index);
+					state.seed = seed;
+					state.caseStart = std::chrono::steady_clock::now().time_since_epoch().count();
+					runCase(worker, seed, false);
+					state.caseStart = 0;
+				}
+
+				workerFindings[i] = std::move(worker.findings);
+				workerStatistics[i] = worker.statistics;
+			});
+		}
+
+		//checks the running cases a few times per second, a hanging case can only be reported before ending the process
+		std::thread watchdog([this, &done]() {
+			std::chrono::steady_clock::duration hangDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.hangSeconds));
+
+			while (!done) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+
+				for (size_t i = 0; i < workerCount; ++i) {
+					int64_t caseStart = workerStates[i].caseStart;
+					if (caseStart != 0 && now - caseStart > hangDuration.count()) {
+						std::fprintf(stderr, "case 0x%016llX is hanging for more than %.1f seconds\n", (unsigned long long)workerStates[i].seed.load(), options.hangSeconds);
+						std::fflush(stderr);
+						std::_Exit(HANG_EXIT_CODE);
+					}
+				}
+			}
+		});
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		done = true;
+		watchdog.join();
+
+		std::vector<Finding> findings;
+		for (size_t i = 0; i < workerCount; ++i) {
+			findings.insert(findings.end(), workerFindings[i].begin(), workerFindings[i].end());
+			statistics += workerStatistics[i];
+		}
+
+		return findings;
+	}
+
+
+	std::vector<Finding> FuzzDriver::reproduce(const uint64_t& seed, FuzzStatistics& statistics) {
+		workerCount = 1;
+		workerStates = std::make_unique<WorkerState[]>(1);
+		workerStates[0].seed = seed;
+		workerStates[0].caseStart = std::chrono::steady_clock::now().time_since_epoch().count();
+
+		Worker worker(reference, optimizedReference);
+		std::cout << fmt::format("case 0x{:016X} of kind {}\n", seed, toString((CaseKind)(seed % 3))) << std::flush;
+		runCase(worker, seed, true);
+
+		workerStates[0].caseStart = 0;
+		statistics += worker.statistics;
+		return worker.findings;
+	}
+
+
+	void FuzzDriver::writeRunningCases(std::FILE* output) const {
+		for (size_t i = 0; i < workerCount; ++i) {
+			if (workerStates[i].caseStart != 0) {
+				uint64_t seed = workerStates[i].seed;
+				std::fprintf(output, "case 0x%016llX of kind %s was running\n", (unsigned long long)seed, toString((CaseKind)(seed % 3)));
+			}
+		}
+		std::fflush(output);
+	}
+}
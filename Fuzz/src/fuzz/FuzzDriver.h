@@ -0,0 +1,111 @@
+#pragma once
+
+//std library
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+//minimal machine
+#include "mima/microprogram/MicroProgram.h"
+#include "mima/MinimalMachine.h"
+#include "mima/PipelinedMachine.h"
+
+
+namespace MiMaFuzz {
+	enum class CaseKind {
+		ENGINES,      //a generated memory image on the reference microprogram, its optimized version and the pipeline
+		MICROPROGRAM, //generated microprogram code, compiled with and without the optimizer and run on a generated image
+		PROGRAM       //generated program code, compiled sequentially and in parallel and run on the reference microprogram
+	};
+
+	const char* toString(const CaseKind& kind);
+
+
+	struct FuzzOptions {
+		uint64_t seed = 0;
+		uint64_t caseCount = 0;    //0 = until the time runs out
+		double seconds = 60;       //0 = until all cases ran
+		uint64_t cycleBudget = 20000;
+		size_t threadCount = 0;    //0 = one per hardware thread
+		double hangSeconds = 10;   //a single case running longer is reported as a hang
+	};
+
+	//an unexpected exception or a difference between two engines or compilers
+	struct Finding {
+		uint64_t seed;
+		CaseKind kind;
+		std::string description;
+	};
+
+	struct FuzzStatistics {
+		uint64_t cases = 0;
+		uint64_t rejectedPrograms = 0;      //generated program code the compiler rejected
+		uint64_t rejectedMicroprograms = 0; //generated microprogram code the compiler rejected
+		uint64_t halted = 0;                //runs which halted within the cycle budget
+		uint64_t instructions = 0;          //instructions compared between engines
+		uint64_t cycles = 0;                //cycles emulated by the reference machines
+
+		FuzzStatistics& operator+=(const FuzzStatistics& other);
+	};
+
+
+	// ------------------------------------------------
+	// Fuzz driver
+	//
+	// Runs generated cases on a pool of worker threads,
+	// each case fully determined by its seed. Workers
+	// keep their reference machines and reset them to
+	// the image of every case instead of constructing
+	// new ones. Cases which throw anything but a
+	// compiler exception or on which two engines or
+	// compilers disagree are findings. A watchdog
+	// reports a case exceeding the hang timeout and
+	// ends the process, since a hanging thread can't
+	// be stopped.
+	// ------------------------------------------------
+
+	class FuzzDriver {
+	public:
+		static constexpr int HANG_EXIT_CODE = 3;
+
+	private:
+		//what a worker is doing, for the watchdog and crash reports
+		struct WorkerState {
+			std::atomic<uint64_t> seed;
+			std::atomic<int64_t> caseStart; //steady clock ticks, 0 if idle
+		};
+
+		struct Worker;
+
+	private:
+		std::shared_ptr<const MiMa::MicroProgram> reference;
+		std::shared_ptr<const MiMa::MicroProgram> optimizedReference;
+		FuzzOptions options;
+
+		std::unique_ptr<WorkerState[]> workerStates;
+		size_t workerCount = 0;
+
+		void runEngineCase(Worker& worker, const uint64_t& seed, const bool& verbose);
+		void runMicroProgramCase(Worker& worker, const uint64_t& seed, const bool& verbose);
+		void runProgramCase(Worker& worker, const uint64_t& seed, const bool& verbose);
+		void runCase(Worker& worker, const uint64_t& seed, const bool& verbose);
+
+	public:
+		//the reference microprogram has to implement the MiMa instruction set like the pipeline does
+		FuzzDriver(const std::string& referenceMicroProgramCode, const FuzzOptions& options);
+
+		//the seed of case number index of a run with the given seed
+		static uint64_t getCaseSeed(const uint64_t& runSeed, const uint64_t& index);
+
+		//runs cases until the case count or time is reached, the findings are in case order per worker
+		std::vector<Finding> run(FuzzStatistics& statistics);
+		//runs a single case on the calling thread, printing its generated inputs
+		std::vector<Finding> reproduce(const uint64_t& seed, FuzzStatistics& statistics);
+
+		//only uses the C stdio, so it can report the running cases from a signal handler
+		void writeRunningCases(std::FILE* output) const;
+	};
+}
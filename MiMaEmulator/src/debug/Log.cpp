@@ -2,46 +2,120 @@
 #include "Log.h"
 
 //external vendor libraries
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
 
 namespace MiMa {
-	Logger::Logger(char* name, spdlog::level::level_enum logLevel, const char* loggerPattern) {
-		spdlogLogger = spdlog::stdout_color_mt(name);
-		spdlogLogger->set_level(logLevel);
-		spdlogLogger->set_pattern(loggerPattern);
+	static const char* LOG_CHANNEL_NAMES[LOG_CHANNEL_COUNT] = { "core", "memory", "microcompiler", "assembler" };
+
+
+	const char* toString(const LogChannel& channel) {
+		return LOG_CHANNEL_NAMES[(size_t)channel];
 	}
 
-	Logger::Logger(std::shared_ptr<spdlog::logger>& spdlogLogger) : spdlogLogger(spdlogLogger) {}
-	
 
-	Logger constructDefaultLogger() {
+	bool parseLogChannel(const std::string& name, LogChannel& channel) {
+		for (size_t i = 0; i < LOG_CHANNEL_COUNT; ++i) {
+			if (name == LOG_CHANNEL_NAMES[i]) {
+				channel = (LogChannel)i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+
+	//the thread writing the messages of all asynchronous loggers, outlives them since it is destroyed last
+	static std::shared_ptr<spdlog::details::thread_pool> logThreadPool = std::make_shared<spdlog::details::thread_pool>(STANDARD_SPDLOG_QUEUE_SIZE, 1);
+
+	//shared by all loggers, so their console output keeps a single format
+	static std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> constructStdoutSink() {
 		//create stdout sink with default level info
 		std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> stdoutSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
 		stdoutSink->set_level(spdlog::level::level_enum::info);
 		stdoutSink->set_pattern(STANDARD_SPDLOG_STDOUT_PATTERN);
+		return stdoutSink;
+	}
+
+	static std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> stdoutSink = constructStdoutSink();
+
+
+	static std::shared_ptr<spdlog::logger> constructAsyncLogger(const std::string& name, [[maybe_unused]] const std::string& fileName) {
+		std::vector<spdlog::sink_ptr> sinks = { stdoutSink };
 
 		//create file sink with default level trace
 #ifdef MIMA_LOG
-		std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("log/mimaEmulation.log", true);
+		std::shared_ptr<spdlog::sinks::basic_file_sink_mt> fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("log/" + fileName + ".log", true);
 		fileSink->set_level(spdlog::level::level_enum::trace);
 		fileSink->set_pattern(STANDARD_SPDLOG_FILE_PATTERN);
+		sinks.push_back(fileSink);
 #endif
 
-		//create spdlog logger
-		spdlog::sinks_init_list sinks = { stdoutSink,
-#ifdef MIMA_LOG
-			fileSink
-#endif
-		};
-
-		std::shared_ptr<spdlog::logger> spdlogLogger = std::make_shared<spdlog::logger>("mimaDefaultLogger", sinks);
+		std::shared_ptr<spdlog::logger> spdlogLogger = std::make_shared<spdlog::async_logger>(name, sinks.begin(), sinks.end(), logThreadPool);
 		spdlogLogger->set_level(spdlog::level::level_enum::trace);
+		//errors usually end the emulation, so they should not wait in the queue
+		spdlogLogger->flush_on(spdlog::level::level_enum::err);
+		return spdlogLogger;
+	}
 
+
+
+	Logger::Logger(char* name, spdlog::level::level_enum logLevel, const char* loggerPattern) {
+		spdlogLogger = spdlog::stdout_color_mt(name);
+		spdlogLogger->set_level(logLevel);
+		spdlogLogger->set_pattern(loggerPattern);
+		initializeChannelLevels();
+	}
+
+	Logger::Logger(std::shared_ptr<spdlog::logger>& spdlogLogger) : spdlogLogger(spdlogLogger) {
+		initializeChannelLevels();
+	}
+
+
+	void Logger::initializeChannelLevels() {
+		for (std::atomic<int>& channelLevel : channelLevels) {
+			channelLevel.store(spdlog::level::level_enum::trace, std::memory_order_relaxed);
+		}
+	}
+
+
+	std::shared_ptr<Logger> Logger::createAsync(const std::string& name, const std::string& fileName) {
+		std::shared_ptr<spdlog::logger> spdlogLogger = constructAsyncLogger(name, fileName);
+		return std::make_shared<Logger>(spdlogLogger);
+	}
+
+
+
+	Logger constructDefaultLogger() {
+		std::shared_ptr<spdlog::logger> spdlogLogger = constructAsyncLogger("mimaDefaultLogger", "mimaEmulation");
 		return Logger(spdlogLogger);
 	}
 
 
 	Logger mimaDefaultLog = constructDefaultLogger();
+
+
+
+	//the logger of the innermost log scope of the thread
+	static thread_local Logger* threadLog = nullptr;
+
+
+	Logger& currentLog() {
+		return threadLog ? *threadLog : mimaDefaultLog;
+	}
+
+
+	LogScope::LogScope(Logger* logger) : previous(threadLog) {
+		if (logger) {
+			threadLog = logger;
+		}
+	}
+
+
+	LogScope::~LogScope() {
+		threadLog = previous;
+	}
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 //std library
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 //external vendor libraries
 #include <spdlog/spdlog.h>
@@ -12,18 +16,96 @@ namespace MiMa {
 	constexpr char* STANDARD_SPDLOG_STDOUT_PATTERN = "%^[%T] %n: %v%$";
 	constexpr char* STANDARD_SPDLOG_FILE_PATTERN = "[%L| %T] %n: %v";
 
+	//messages logged through the asynchronous loggers waiting to be written, the emulation blocks while it is full
+	constexpr size_t STANDARD_SPDLOG_QUEUE_SIZE = 8192;
+
+	//the parts of the emulator filtered separately, every message belongs to one of them
+	enum class LogChannel : uint8_t {
+		CORE,          //machines, devices, checkers and records
+		MEMORY,        //memory files and memory timing
+		MICROCOMPILER, //microprogram compiler and optimizer
+		ASSEMBLER      //MiMa program compiler
+	};
+
+	constexpr size_t LOG_CHANNEL_COUNT = 4;
+
+	const char* toString(const LogChannel& channel);
+	//accepts the lower case channel names, returns false for any other name
+	bool parseLogChannel(const std::string& name, LogChannel& channel);
+
+
+	// ------------------------------------------------
+	// Logger
+	//
+	// Wraps a spdlog logger and filters its messages
+	// per channel. The level of a channel is checked
+	// before the arguments of a message are evaluated,
+	// so filtered messages only cost a comparison.
+	// Levels can be changed while other threads log.
+	//
+	// Loggers created with createAsync only queue
+	// their messages, a single background thread
+	// shared by all of them writes them, so machines
+	// running in parallel neither wait for the sinks
+	// nor for each other.
+	// ------------------------------------------------
+
 	class Logger {
 	private:
 		std::shared_ptr<spdlog::logger> spdlogLogger;
+		std::array<std::atomic<int>, LOG_CHANNEL_COUNT> channelLevels;
+
+		void initializeChannelLevels();
+
 	public:
 		Logger(char* name, spdlog::level::level_enum logLevel = STANDARD_SPDLOG_DEFAULT_LEVEL, const char* loggerPattern = STANDARD_SPDLOG_STDOUT_PATTERN);
 		Logger(std::shared_ptr<spdlog::logger>& spdlogLogger);
+		Logger(const Logger&) = delete;
+		Logger& operator=(const Logger&) = delete;
+
+		//an asynchronous logger writing to the standard output like the default logger
+		//and, if logging is enabled, to its own file log/<fileName>.log
+		static std::shared_ptr<Logger> createAsync(const std::string& name, const std::string& fileName);
 
-		inline std::shared_ptr<spdlog::logger> get_spdlogLogger() { return spdlogLogger; };
+		inline const std::shared_ptr<spdlog::logger>& get_spdlogLogger() { return spdlogLogger; };
 		inline void setLogLevel(spdlog::level::level_enum logLevel) { spdlogLogger->set_level(logLevel); };
+		inline spdlog::level::level_enum getLogLevel() const { return spdlogLogger->level(); }
+
+		inline void setChannelLevel(const LogChannel& channel, spdlog::level::level_enum logLevel) { channelLevels[(size_t)channel].store(logLevel, std::memory_order_relaxed); }
+		inline spdlog::level::level_enum getChannelLevel(const LogChannel& channel) const { return (spdlog::level::level_enum)channelLevels[(size_t)channel].load(std::memory_order_relaxed); }
+
+		inline bool shouldLog(const LogChannel& channel, const spdlog::level::level_enum& logLevel) const {
+			return logLevel >= channelLevels[(size_t)channel].load(std::memory_order_relaxed) && spdlogLogger->should_log(logLevel);
+		}
 	};
 
 	extern Logger mimaDefaultLog;
+
+	//the logger the logging macros write to on the calling thread, the default logger outside of log scopes
+	Logger& currentLog();
+
+
+	// ------------------------------------------------
+	// Log scope
+	//
+	// Makes a logger the current logger of the
+	// calling thread until the scope ends, restoring
+	// the previous one. This gives every machine or
+	// compiler run its own logger without passing
+	// it through every call. A null logger keeps the
+	// current one.
+	// ------------------------------------------------
+
+	class LogScope {
+	private:
+		Logger* previous;
+
+	public:
+		LogScope(Logger* logger);
+		~LogScope();
+		LogScope(const LogScope&) = delete;
+		LogScope& operator=(const LogScope&) = delete;
+	};
 }
 
 
@@ -33,30 +115,40 @@ namespace MiMa {
 
 #ifdef MIMA_LOG
 
-#define MIMA_LOG_TRACE(...) MiMa::mimaDefaultLog.get_spdlogLogger()->trace(__VA_ARGS__)
-#define MIMA_LOG_INFO(...) MiMa::mimaDefaultLog.get_spdlogLogger()->info(__VA_ARGS__)
-#define MIMA_LOG_WARN(...) MiMa::mimaDefaultLog.get_spdlogLogger()->warn(__VA_ARGS__)
-#define MIMA_LOG_ERROR(...) MiMa::mimaDefaultLog.get_spdlogLogger()->error(__VA_ARGS__)
-#define MIMA_LOG_CRITICAL(...) MiMa::mimaDefaultLog.get_spdlogLogger()->critical(__VA_ARGS__)
-
-#define MIMA_ASSERT_TRACE(assertion, ...) if (!(assertion)) MiMa::mimaDefaultLog.get_spdlogLogger()->trace(__VA_ARGS__)
-#define MIMA_ASSERT_INFO(assertion, ...) if (!(assertion)) MiMa::mimaDefaultLog.get_spdlogLogger()->info(__VA_ARGS__)
-#define MIMA_ASSERT_WARN(assertion, ...) if (!(assertion)) MiMa::mimaDefaultLog.get_spdlogLogger()->warn(__VA_ARGS__)
-#define MIMA_ASSERT_ERROR(assertion, ...) if (!(assertion)) MiMa::mimaDefaultLog.get_spdlogLogger()->error(__VA_ARGS__)
-#define MIMA_ASSERT_CRITICAL(assertion, ...) if (!(assertion)) MiMa::mimaDefaultLog.get_spdlogLogger()->critical(__VA_ARGS__)
+#define MIMA_LOG_MESSAGE(channel, level, ...) do { MiMa::Logger& mimaLogger = MiMa::currentLog(); if (mimaLogger.shouldLog(channel, level)) mimaLogger.get_spdlogLogger()->log(level, __VA_ARGS__); } while (false)
+#define MIMA_ASSERT_MESSAGE(assertion, channel, level, ...) do { if (!(assertion)) MIMA_LOG_MESSAGE(channel, level, __VA_ARGS__); } while (false)
+#define MIMA_LOG_SCOPE(logger) MiMa::LogScope mimaLogScope(logger)
 
 #else
 
-#define MIMA_LOG_TRACE(...)
-#define MIMA_LOG_INFO(...)
-#define MIMA_LOG_WARN(...)
-#define MIMA_LOG_ERROR(...)
-#define MIMA_LOG_CRITICAL(...)
-
-#define MIMA_ASSERT_TRACE(assertion, ...)
-#define MIMA_ASSERT_INFO(assertion, ...)
-#define MIMA_ASSERT_WARN(assertion, ...)
-#define MIMA_ASSERT_ERROR(assertion, ...)
-#define MIMA_ASSERT_CRITICAL(assertion, ...)
+#define MIMA_LOG_MESSAGE(channel, level, ...)
+#define MIMA_ASSERT_MESSAGE(assertion, channel, level, ...)
+#define MIMA_LOG_SCOPE(logger)
 
 #endif
+
+//log to the core channel
+#define MIMA_LOG_TRACE(...) MIMA_LOG_MESSAGE(MiMa::LogChannel::CORE, spdlog::level::trace, __VA_ARGS__)
+#define MIMA_LOG_INFO(...) MIMA_LOG_MESSAGE(MiMa::LogChannel::CORE, spdlog::level::info, __VA_ARGS__)
+#define MIMA_LOG_WARN(...) MIMA_LOG_MESSAGE(MiMa::LogChannel::CORE, spdlog::level::warn, __VA_ARGS__)
+#define MIMA_LOG_ERROR(...) MIMA_LOG_MESSAGE(MiMa::LogChannel::CORE, spdlog::level::err, __VA_ARGS__)
+#define MIMA_LOG_CRITICAL(...) MIMA_LOG_MESSAGE(MiMa::LogChannel::CORE, spdlog::level::critical, __VA_ARGS__)
+
+#define MIMA_ASSERT_TRACE(assertion, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::CORE, spdlog::level::trace, __VA_ARGS__)
+#define MIMA_ASSERT_INFO(assertion, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::CORE, spdlog::level::info, __VA_ARGS__)
+#define MIMA_ASSERT_WARN(assertion, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::CORE, spdlog::level::warn, __VA_ARGS__)
+#define MIMA_ASSERT_ERROR(assertion, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::CORE, spdlog::level::err, __VA_ARGS__)
+#define MIMA_ASSERT_CRITICAL(assertion, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::CORE, spdlog::level::critical, __VA_ARGS__)
+
+//log to the given channel, for example MIMA_CHANNEL_LOG_INFO(ASSEMBLER, ...)
+#define MIMA_CHANNEL_LOG_TRACE(channel, ...) MIMA_LOG_MESSAGE(MiMa::LogChannel::channel, spdlog::level::trace, __VA_ARGS__)
+#define MIMA_CHANNEL_LOG_INFO(channel, ...) MIMA_LOG_MESSAGE(MiMa::LogChannel::channel, spdlog::level::info, __VA_ARGS__)
+#define MIMA_CHANNEL_LOG_WARN(channel, ...) MIMA_LOG_MESSAGE(MiMa::LogChannel::channel, spdlog::level::warn, __VA_ARGS__)
+#define MIMA_CHANNEL_LOG_ERROR(channel, ...) MIMA_LOG_MESSAGE(MiMa::LogChannel::channel, spdlog::level::err, __VA_ARGS__)
+#define MIMA_CHANNEL_LOG_CRITICAL(channel, ...) MIMA_LOG_MESSAGE(MiMa::LogChannel::channel, spdlog::level::critical, __VA_ARGS__)
+
+#define MIMA_CHANNEL_ASSERT_TRACE(assertion, channel, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::channel, spdlog::level::trace, __VA_ARGS__)
+#define MIMA_CHANNEL_ASSERT_INFO(assertion, channel, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::channel, spdlog::level::info, __VA_ARGS__)
+#define MIMA_CHANNEL_ASSERT_WARN(assertion, channel, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::channel, spdlog::level::warn, __VA_ARGS__)
+#define MIMA_CHANNEL_ASSERT_ERROR(assertion, channel, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::channel, spdlog::level::err, __VA_ARGS__)
+#define MIMA_CHANNEL_ASSERT_CRITICAL(assertion, channel, ...) MIMA_ASSERT_MESSAGE(assertion, MiMa::LogChannel::channel, spdlog::level::critical, __VA_ARGS__)
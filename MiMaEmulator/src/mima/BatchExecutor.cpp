@@ -0,0 +1,100 @@
+#include "mimapch.h"
+#include "BatchExecutor.h"
+
+//std library
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+
+namespace MiMa {
+	BatchExecutor::BatchExecutor(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<const MemoryImage>& image, const std::vector<AddressRange>& outputRanges, const uint64_t& cycleLimit) :
+		instructionDecoder(instructionDecoder),
+		image(image),
+		outputRanges(outputRanges),
+		cycleLimit(cycleLimit)
+	{}
+
+
+	BatchResult BatchExecutor::run(MinimalMachine& mima, const InputVector& input) const {
+		//patches are stored, so the next reset knows to restore their blocks
+		mima.reset(*image);
+		for (const MemoryPatch& patch : input) {
+			mima.getMemory()->store(patch.address, patch.data);
+		}
+
+		mima.emulateLifeTime(cycleLimit);
+
+		BatchResult result = { {}, mima.getCycleCount(), !mima.isRunning() };
+		for (const AddressRange& outputRange : outputRanges) {
+			for (size_t address = outputRange.lower; address < outputRange.upper; ++address) {
+				result.outputs.push_back(mima.getMemory()->get(address).data);
+			}
+		}
+
+		return result;
+	}
+
+
+	std::vector<BatchResult> BatchExecutor::run(const std::vector<InputVector>& inputs, size_t threadCount) const {
+		//memory indices wrap around, so these would silently read or patch the wrong cells
+		for (const AddressRange& outputRange : outputRanges) {
+			if (outputRange.lower > outputRange.upper || outputRange.upper > DEFAULT_MEMORY_CAPACITY + 1) {
+				MIMA_LOG_ERROR("The output range [0x{:X}, 0x{:X}) isn't a range of MiMa addresses", outputRange.lower, outputRange.upper);
+				throw std::invalid_argument(fmt::format("the output range [0x{:X}, 0x{:X}) isn't a range of MiMa addresses", outputRange.lower, outputRange.upper));
+			}
+		}
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			for (const MemoryPatch& patch : inputs[i]) {
+				if (patch.address > DEFAULT_MEMORY_CAPACITY) {
+					MIMA_LOG_ERROR("The address 0x{:X} patched by input vector {} isn't a MiMa address", patch.address, i);
+					throw std::invalid_argument(fmt::format("the address 0x{:X} patched by input vector {} isn't a MiMa address", patch.address, i));
+				}
+			}
+		}
+
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		threadCount = std::max<size_t>(std::min(threadCount, inputs.size()), 1);
+		MIMA_LOG_INFO("Running {} input vectors on {} threads", inputs.size(), threadCount);
+
+		std::vector<BatchResult> results(inputs.size());
+		std::vector<std::exception_ptr> workerErrors(threadCount);
+		std::vector<std::thread> workers;
+		//the workers log like the calling thread
+		Logger* logger = &currentLog();
+
+		//every worker runs every threadCount-th input vector on its own machine
+		for (size_t worker = 0; worker < threadCount; ++worker) {
+			workers.emplace_back([this, &inputs, &results, &workerErrors, logger, worker, threadCount]() {
+				MIMA_LOG_SCOPE(logger);
+				try {
+					MinimalMachine mima(instructionDecoder, std::make_shared<MiMaMemory>(*image));
+
+					for (size_t i = worker; i < inputs.size(); i += threadCount) {
+						results[i] = run(mima, inputs[i]);
+					}
+				}
+				catch (...) {
+					workerErrors[worker] = std::current_exception();
+				}
+			});
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		for (const std::exception_ptr& workerError : workerErrors) {
+			if (workerError) {
+				std::rethrow_exception(workerError);
+			}
+		}
+
+		return results;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//internal classes
+#include "MinimalMachine.h"
+
+
+namespace MiMa {
+	//a single cell of a program input, written over the memory image before running
+	struct MemoryPatch {
+		size_t address;
+		uint32_t data;
+	};
+	typedef std::vector<MemoryPatch> InputVector;
+
+	//the addresses [lower, upper) holding (part of) the output of a program
+	struct AddressRange {
+		size_t lower;
+		size_t upper;
+	};
+
+	struct BatchResult {
+		std::vector<uint32_t> outputs; //the cells of all output ranges, one range after the other
+		uint64_t cycles;
+		bool halted; //false if the cycle limit was reached first
+	};
+
+
+	// ------------------------------------------------
+	// Batch executor
+	//
+	// Runs one program against many input vectors,
+	// only keeping the output ranges and cycle counts
+	// of each run. Every worker thread reuses a single
+	// machine, resetting it to the shared memory image
+	// between runs, so only the blocks a run dirtied
+	// are copied back and no memory is allocated per
+	// input vector.
+	// ------------------------------------------------
+
+	class BatchExecutor {
+	public:
+		static constexpr uint64_t DEFAULT_CYCLE_LIMIT = 1000000;
+
+	private:
+		std::shared_ptr<const MicroProgram> instructionDecoder;
+		std::shared_ptr<const MemoryImage> image;
+		std::vector<AddressRange> outputRanges;
+		uint64_t cycleLimit;
+
+		BatchResult run(MinimalMachine& mima, const InputVector& input) const;
+
+	public:
+		BatchExecutor(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<const MemoryImage>& image, const std::vector<AddressRange>& outputRanges, const uint64_t& cycleLimit = DEFAULT_CYCLE_LIMIT);
+
+		//runs the program for every input vector on threadCount threads (0 = one per hardware thread), results are in input order
+		//throws before running anything if a patch or an output range lies outside of the 20 bit address space
+		std::vector<BatchResult> run(const std::vector<InputVector>& inputs, size_t threadCount = 0) const;
+	};
+}
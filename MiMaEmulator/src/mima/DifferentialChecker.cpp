@@ -0,0 +1,224 @@
+#include "mimapch.h"
+#include "DifferentialChecker.h"
+
+//std library
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//internal utility
+#include "util/SPSCQueue.h"
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+	// ---------------
+	// Utility methods
+	// ---------------
+
+	//Utility: FNV-1a over the fields of every state, so the digest depends on their order
+	constexpr uint64_t DIGEST_OFFSET = 0xCBF29CE484222325;
+	constexpr uint64_t DIGEST_PRIME = 0x100000001B3;
+
+	static uint64_t addToDigest(const uint64_t& digest, const ArchitecturalState& state) {
+		return ((((digest ^ state.address) * DIGEST_PRIME) ^ state.instruction) * DIGEST_PRIME ^ state.accumulator) * DIGEST_PRIME;
+	}
+
+
+	static std::string formatState(const ArchitecturalState& state, const bool& halted) {
+		if (halted) {
+			return "halted";
+		}
+		return fmt::format("executed 0x{:06X} at 0x{:05X}, accumulator 0x{:06X}", state.instruction, state.address, state.accumulator);
+	}
+
+
+
+	// ---------------------
+	// Differential result
+	// ---------------------
+
+	void DifferentialResult::writeReport(std::ostream& output, const ExecutionEngine& primary, const ExecutionEngine& secondary) const {
+		fmt::memory_buffer report;
+
+		if (diverged) {
+			fmt::format_to(std::back_inserter(report), "'{}' and '{}' diverged at instruction {}:\n", primary.getName(), secondary.getName(), instructions + 1);
+			fmt::format_to(std::back_inserter(report), "  {}: {}\n", primary.getName(), formatState(primaryState, primaryHalted));
+			fmt::format_to(std::back_inserter(report), "  {}: {}\n", secondary.getName(), formatState(secondaryState, secondaryHalted));
+		}
+		else {
+			fmt::format_to(std::back_inserter(report), "'{}' and '{}' agreed on {} instructions{}\n", primary.getName(), secondary.getName(), instructions, halted ? " until both halted" : ", the instruction limit");
+		}
+
+		for (const MemoryDifference& difference : memoryDifferences) {
+			fmt::format_to(std::back_inserter(report), "memory 0x{:05X}: {} in '{}', {} in '{}'\n", difference.address, difference.left, primary.getName(), difference.right, secondary.getName());
+		}
+		fmt::format_to(std::back_inserter(report), "cycles: {} in '{}', {} in '{}'\n", primary.getCycleCount(), primary.getName(), secondary.getCycleCount(), secondary.getName());
+
+		output.write(report.data(), report.size());
+	}
+
+
+
+	// ---------------------
+	// Differential checker
+	// ---------------------
+
+	DifferentialChecker::DifferentialChecker(std::unique_ptr<ExecutionEngine> primary, std::unique_ptr<ExecutionEngine> secondary, const std::shared_ptr<const MemoryImage>& image, const uint64_t& checkInterval) :
+		primary(std::move(primary)),
+		secondary(std::move(secondary)),
+		image(image),
+		checkInterval(checkInterval)
+	{
+		if (checkInterval == 0) {
+			MIMA_LOG_ERROR("Failed to create a differential checker with a check interval of 0 instructions");
+			throw std::invalid_argument("failed to create a differential checker with a check interval of 0 instructions");
+		}
+	}
+
+
+	DifferentialResult DifferentialChecker::replay(const uint64_t& instructionLimit) {
+		MIMA_LOG_INFO("Replaying '{}' and '{}' in lockstep for up to {} instructions", primary->getName(), secondary->getName(), instructionLimit);
+		primary->reset(*image);
+		secondary->reset(*image);
+
+		DifferentialResult result;
+		while (result.instructions < instructionLimit) {
+			result.primaryHalted = !primary->emulateInstruction(result.primaryState);
+			result.secondaryHalted = !secondary->emulateInstruction(result.secondaryState);
+
+			if (result.primaryHalted != result.secondaryHalted || (!result.primaryHalted && result.primaryState != result.secondaryState)) {
+				result.diverged = true;
+				return result;
+			}
+			if (result.primaryHalted) {
+				result.halted = true;
+				return result;
+			}
+
+			result.instructions++;
+		}
+
+		return result;
+	}
+
+
+	DifferentialResult DifferentialChecker::run(const uint64_t& instructionLimit) {
+		MIMA_LOG_INFO("Checking '{}' against '{}' every {} instructions", primary->getName(), secondary->getName(), checkInterval);
+		primary->reset(*image);
+		secondary->reset(*image);
+
+		SPSCQueue<Checkpoint> checkpoints(QUEUE_CAPACITY);
+		std::atomic<bool> workerDone(false);
+		//only written by the worker before it is done
+		bool mismatch = false;
+		uint64_t mismatchInstructions = 0;
+		std::exception_ptr workerError;
+
+		//the secondary engine follows the checkpoints of the primary one, until one of them doesn't match
+		std::thread worker([this, &checkpoints, &workerDone, &mismatch, &mismatchInstructions, &workerError]() {
+			try {
+				uint64_t instructions = 0;
+				uint64_t digest = DIGEST_OFFSET;
+				bool halted = false;
+				ArchitecturalState state;
+				Checkpoint checkpoint;
+
+				do {
+					while (!checkpoints.tryPop(checkpoint)) {
+						std::this_thread::yield();
+					}
+
+					while (!halted && instructions < checkpoint.instructions) {
+						if (secondary->emulateInstruction(state)) {
+							digest = addToDigest(digest, state);
+							instructions++;
+						}
+						else {
+							halted = true;
+						}
+					}
+
+					//the primary engine halted right after the checkpoint, so has to the secondary one
+					if (checkpoint.halted && !halted) {
+						halted = !secondary->emulateInstruction(state);
+						instructions += !halted;
+					}
+
+					if (instructions != checkpoint.instructions || halted != checkpoint.halted || digest != checkpoint.digest) {
+						mismatch = true;
+						mismatchInstructions = checkpoint.instructions;
+						break;
+					}
+				} while (!checkpoint.last);
+			}
+			catch (...) {
+				workerError = std::current_exception();
+			}
+
+			workerDone.store(true, std::memory_order_release);
+		});
+
+		//gives up on a full queue once the worker is done, since nothing will empty it anymore
+		auto pushCheckpoint = [&checkpoints, &workerDone](const Checkpoint& checkpoint) {
+			while (!checkpoints.tryPush(checkpoint)) {
+				if (workerDone.load(std::memory_order_acquire)) {
+					return;
+				}
+				std::this_thread::yield();
+			}
+		};
+
+		uint64_t instructions = 0;
+		uint64_t digest = DIGEST_OFFSET;
+		bool halted = false;
+		ArchitecturalState state;
+
+		while (!halted && instructions < instructionLimit) {
+			if (primary->emulateInstruction(state)) {
+				digest = addToDigest(digest, state);
+				instructions++;
+			}
+			else {
+				halted = true;
+			}
+
+			if (instructions % checkInterval == 0 && !halted) {
+				if (workerDone.load(std::memory_order_acquire)) {
+					break;
+				}
+				pushCheckpoint({ instructions, digest, false, false });
+			}
+		}
+		pushCheckpoint({ instructions, digest, halted, true });
+		worker.join();
+
+		if (workerError) {
+			std::rethrow_exception(workerError);
+		}
+
+		//the replay compares the instruction after the checkpoint as well, in case only one of the engines halted there
+		if (mismatch) {
+			MIMA_LOG_WARN("'{}' and '{}' diverged within the {} instructions up to instruction {}", primary->getName(), secondary->getName(), checkInterval, mismatchInstructions);
+			return replay(mismatchInstructions + 1);
+		}
+
+		DifferentialResult result;
+		result.instructions = instructions;
+		result.halted = halted;
+
+		//the states determine every store, so this only catches engines storing something else than they report
+		if (halted) {
+			result.memoryDifferences = diff(*primary->getMemory(), *secondary->getMemory());
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//internal classes
+#include "MinimalMachine.h"
+#include "PipelinedMachine.h"
+#include "mimaprogram/MiMaMemory.h"
+
+
+namespace MiMa {
+	//the architectural state of a MiMa after completing an instruction
+	struct ArchitecturalState {
+		uint32_t address;     //of the completed instruction
+		uint32_t instruction;
+		uint32_t accumulator;
+
+		inline bool operator==(const ArchitecturalState& other) const { return address == other.address && instruction == other.instruction && accumulator == other.accumulator; }
+		inline bool operator!=(const ArchitecturalState& other) const { return !(*this == other); }
+	};
+
+
+	// ------------------------------------------------
+	// Execution engine
+	//
+	// A MiMa implementation as seen by the differential
+	// checker, which steps it instruction by
+	// instruction. Any machine with the emulation and
+	// architectural state getters of MinimalMachine
+	// can be wrapped in a MachineEngine.
+	// ------------------------------------------------
+
+	class ExecutionEngine {
+	public:
+		virtual ~ExecutionEngine() {}
+
+		virtual const std::string& getName() const = 0;
+
+		//completes the next instruction and writes the state after it, returns false instead if the engine halted
+		virtual bool emulateInstruction(ArchitecturalState& state) = 0;
+
+		virtual void reset(const MemoryImage& image) = 0;
+		virtual uint64_t getCycleCount() const = 0;
+		virtual const std::shared_ptr<MiMaMemory>& getMemory() const = 0;
+	};
+
+
+	template<typename Machine>
+	class MachineEngine : public ExecutionEngine {
+	private:
+		std::string name;
+		std::shared_ptr<Machine> machine;
+
+	public:
+		MachineEngine(const std::string& name, const std::shared_ptr<Machine>& machine) :
+			name(name),
+			machine(machine)
+		{}
+
+		inline const std::string& getName() const override { return name; }
+
+		bool emulateInstruction(ArchitecturalState& state) override {
+			if (!machine->isRunning()) {
+				return false;
+			}
+
+			//a halt never completes an instruction
+			uint32_t address = machine->getInstructionAddress();
+			uint64_t instructions = machine->getInstructionCount();
+			machine->emulateInstructionCycle();
+
+			if (machine->getInstructionCount() == instructions) {
+				return false;
+			}
+
+			state = { address, (uint32_t)machine->getInstructionRegister(), (uint32_t)machine->getAccumulator() };
+			return true;
+		}
+
+		inline void reset(const MemoryImage& image) override { machine->reset(image); }
+		inline uint64_t getCycleCount() const override { return machine->getCycleCount(); }
+		inline const std::shared_ptr<MiMaMemory>& getMemory() const override { return machine->getMemory(); }
+	};
+
+
+
+	//the first difference of two engines, in the instruction number counting from 1 or in their memories after both halted
+	struct DifferentialResult {
+		uint64_t instructions = 0; //instructions both engines completed identically
+		bool diverged = false;
+		bool halted = false;       //false if the instruction limit was reached first
+
+		//the states at the first diverging instruction, an engine which halted instead has no state
+		bool primaryHalted = false;
+		bool secondaryHalted = false;
+		ArchitecturalState primaryState = {};
+		ArchitecturalState secondaryState = {};
+
+		std::vector<MemoryDifference> memoryDifferences;
+
+		//writes whether and where the engines diverged, with their states and cycle counts
+		void writeReport(std::ostream& output, const ExecutionEngine& primary, const ExecutionEngine& secondary) const;
+	};
+
+
+	// ------------------------------------------------
+	// Differential checker
+	//
+	// Runs two engines on the same memory image and
+	// compares their architectural state after every
+	// instruction. The primary engine runs on the
+	// calling thread and only hands a digest of the
+	// states of every checkInterval instructions over
+	// a lock-free queue to a second thread, which runs
+	// the secondary engine and compares its own
+	// digests against them. On a mismatch both engines
+	// are reset and replayed in lockstep up to the
+	// mismatching digest to find the exact instruction.
+	//
+	// Both runs have to be deterministic, so devices
+	// depending on the cycle count (which differs
+	// between engines) must not be attached.
+	// ------------------------------------------------
+
+	class DifferentialChecker {
+	public:
+		static constexpr uint64_t DEFAULT_CHECK_INTERVAL = 64;
+		static constexpr size_t QUEUE_CAPACITY = 1024;
+
+	private:
+		//the digest of all states up to the given instruction count
+		struct Checkpoint {
+			uint64_t instructions;
+			uint64_t digest;
+			bool halted;
+			bool last;
+		};
+
+	private:
+		std::unique_ptr<ExecutionEngine> primary;
+		std::unique_ptr<ExecutionEngine> secondary;
+		std::shared_ptr<const MemoryImage> image;
+		uint64_t checkInterval;
+
+		//compares the engines instruction by instruction from the start, up to the given instruction count
+		DifferentialResult replay(const uint64_t& instructionLimit);
+
+	public:
+		DifferentialChecker(std::unique_ptr<ExecutionEngine> primary, std::unique_ptr<ExecutionEngine> secondary, const std::shared_ptr<const MemoryImage>& image, const uint64_t& checkInterval = DEFAULT_CHECK_INTERVAL);
+
+		inline const ExecutionEngine& getPrimary() const { return *primary; }
+		inline const ExecutionEngine& getSecondary() const { return *secondary; }
+
+		//resets both engines and runs them until they halt, diverge or complete the given number of instructions
+		DifferentialResult run(const uint64_t& instructionLimit);
+	};
+}
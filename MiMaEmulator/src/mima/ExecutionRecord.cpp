@@ -0,0 +1,564 @@
+#include "mimapch.h"
+#include "ExecutionRecord.h"
+
+//std library
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+	// ---------------
+	// Utility methods
+	// ---------------
+
+	static const char RECORD_MAGIC[] = "MIMAREC";
+
+	//Utility: FNV-1a over the architectural state and the cycle count after every instruction, since replayed reads depend on the cycle
+	constexpr uint64_t DIGEST_OFFSET = 0xCBF29CE484222325;
+	constexpr uint64_t DIGEST_PRIME = 0x100000001B3;
+
+	static uint64_t addToDigest(const uint64_t& digest, const uint64_t& value) {
+		return (digest ^ value) * DIGEST_PRIME;
+	}
+
+	static uint64_t addToDigest(const uint64_t& digest, const MinimalMachine& mima) {
+		uint64_t result = addToDigest(digest, mima.getInstructionAddress());
+		result = addToDigest(result, mima.getInstructionRegister());
+		result = addToDigest(result, mima.getAccumulator());
+		return addToDigest(result, mima.getCycleCount());
+	}
+
+	static uint64_t getMemoryDigest(const MiMaMemory& memory) {
+		uint64_t digest = DIGEST_OFFSET;
+		for (const MemoryDifference& cell : diff(memory, MiMaMemory())) {
+			digest = addToDigest(addToDigest(digest, cell.address), cell.left.data);
+		}
+		return digest;
+	}
+
+
+	//Utility: the encodings of the record file
+	static void writeNumber(std::string& buffer, uint64_t number) {
+		while (number >= 0x80) {
+			buffer.push_back((char)(number | 0x80));
+			number >>= 7;
+		}
+		buffer.push_back((char)number);
+	}
+
+	static void writeFixed(std::string& buffer, const uint64_t& number) {
+		for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+			buffer.push_back((char)(number >> (8 * byte)));
+		}
+	}
+
+	//maps small negative and positive differences to small numbers
+	static uint64_t toZigZag(const int64_t& number) {
+		return ((uint64_t)number << 1) ^ (uint64_t)(number >> 63);
+	}
+
+	static int64_t fromZigZag(const uint64_t& number) {
+		return (int64_t)(number >> 1) ^ -(int64_t)(number & 1);
+	}
+
+
+	static std::string describe(const RecordEvent& event) {
+		switch (event.type) {
+		case RecordEventType::INPUT:
+			return fmt::format("a read of 0x{:06X} from 0x{:05X} in cycle {}", event.value, event.argument, event.cycle);
+		case RecordEventType::DIGEST:
+			return fmt::format("the digest of instruction {} in cycle {}", event.argument, event.cycle);
+		case RecordEventType::END:
+		default:
+			return fmt::format("the end after instruction {} in cycle {}", event.argument, event.cycle);
+		}
+	}
+
+
+
+	// ------------------
+	// Execution recorder
+	// ------------------
+
+	class ExecutionRecorder::RecordingDevice : public Device {
+	private:
+		ExecutionRecorder& recorder;
+		size_t lower;
+		std::shared_ptr<Device> device;
+
+	public:
+		RecordingDevice(ExecutionRecorder& recorder, const size_t& lower, const std::shared_ptr<Device>& device) : recorder(recorder), lower(lower), device(device) {}
+
+		uint32_t read(const size_t& offset, const uint64_t& cycle) override {
+			uint32_t data = device->read(offset, cycle);
+			recorder.push({ RecordEventType::INPUT, cycle, lower + offset, data, 0, false });
+			recorder.inputCount++;
+			return data;
+		}
+		void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) override { device->write(offset, data, cycle); }
+
+		void connect(EventScheduler& scheduler, MiMaMemory& memory) override { device->connect(scheduler, memory); }
+		void flush() override { device->flush(); }
+	};
+
+
+	//ends the record on every way out of record, even if the emulation throws: pushes the end event,
+	//joins the writer thread and attaches the original devices again, which must not refer to the recorder any longer
+	class ExecutionRecorder::RecordingSession {
+	private:
+		ExecutionRecorder& recorder;
+		MinimalMachine& mima;
+		std::shared_ptr<DeviceBus> bus;
+		const uint64_t& digest;
+		std::thread writer;
+
+	public:
+		RecordingSession(ExecutionRecorder& recorder, MinimalMachine& mima, const std::shared_ptr<DeviceBus>& bus, const uint64_t& digest, std::thread&& writer) :
+			recorder(recorder), mima(mima), bus(bus), digest(digest), writer(std::move(writer)) {}
+		~RecordingSession() { end(); }
+		RecordingSession(const RecordingSession&) = delete;
+		RecordingSession& operator=(const RecordingSession&) = delete;
+
+		void end() {
+			if (!writer.joinable()) {
+				return;
+			}
+
+			recorder.push({ RecordEventType::END, mima.getCycleCount(), mima.getInstructionCount(), digest, getMemoryDigest(*mima.getMemory()), mima.isRunning() });
+			writer.join();
+
+			if (bus) {
+				mima.getDeviceBus()->flush();
+				mima.setDeviceBus(bus);
+			}
+		}
+	};
+
+
+	ExecutionRecorder::ExecutionRecorder(const std::string& fileName, const uint64_t& digestInterval) :
+		fileName(fileName),
+		digestInterval(digestInterval),
+		events(QUEUE_CAPACITY)
+	{
+		if (digestInterval == 0) {
+			MIMA_LOG_ERROR("Failed to create an execution recorder with a digest interval of 0 instructions");
+			throw std::invalid_argument("failed to create an execution recorder with a digest interval of 0 instructions");
+		}
+	}
+
+
+	void ExecutionRecorder::push(const RecordEvent& event) {
+		//only waits for the writer thread to encode the queued events, never for the file
+		while (!events.tryPush(event)) {
+			stallCount++;
+			std::this_thread::yield();
+		}
+	}
+
+
+	void ExecutionRecorder::write(std::ofstream& output, const MemoryImage& image, const std::vector<std::pair<size_t, size_t>>& ranges, uint64_t& bytes, bool& failed) {
+		std::string buffer;
+		buffer.reserve(2 * WRITE_BUFFER_SIZE);
+
+		auto writeBuffer = [&output, &buffer, &bytes, &failed]() {
+			output.write(buffer.data(), buffer.size());
+			failed |= !output.good();
+			bytes += buffer.size();
+			buffer.clear();
+		};
+
+		//header, devices and image
+		buffer.append(RECORD_MAGIC, sizeof(RECORD_MAGIC) - 1);
+		buffer.push_back((char)VERSION);
+		writeNumber(buffer, digestInterval);
+
+		size_t previousUpper = 0;
+		writeNumber(buffer, ranges.size());
+		for (const std::pair<size_t, size_t>& range : ranges) {
+			writeNumber(buffer, range.first - previousUpper);
+			writeNumber(buffer, range.second - range.first);
+			previousUpper = range.second;
+		}
+
+		std::vector<MemoryDifference> cells = diff(image, MiMaMemory());
+		size_t previousAddress = 0;
+		writeNumber(buffer, cells.size());
+		for (const MemoryDifference& cell : cells) {
+			writeNumber(buffer, cell.address - previousAddress);
+			writeNumber(buffer, cell.left.data);
+			previousAddress = cell.address;
+
+			if (buffer.size() >= WRITE_BUFFER_SIZE) {
+				writeBuffer();
+			}
+		}
+
+		//events, until the end event
+		uint64_t lastCycle = 0;
+		uint64_t lastInstructions = 0;
+		uint64_t lastAddress = 0;
+		RecordEvent event;
+
+		do {
+			if (!events.tryPop(event)) {
+				//the queue holds far more than the events of a millisecond, so sleeping leaves the core to the emulation
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			writeNumber(buffer, ((event.cycle - lastCycle) << 2) | (uint64_t)event.type);
+			lastCycle = event.cycle;
+
+			if (event.type == RecordEventType::INPUT) {
+				writeNumber(buffer, toZigZag((int64_t)(event.argument - lastAddress)));
+				writeNumber(buffer, event.value);
+				lastAddress = event.argument;
+			}
+			else {
+				writeNumber(buffer, event.argument - lastInstructions);
+				writeFixed(buffer, event.value);
+				lastInstructions = event.argument;
+
+				if (event.type == RecordEventType::END) {
+					writeFixed(buffer, event.memoryDigest);
+					buffer.push_back((char)event.running);
+				}
+			}
+
+			if (buffer.size() >= WRITE_BUFFER_SIZE) {
+				writeBuffer();
+			}
+		} while (event.type != RecordEventType::END);
+
+		writeBuffer();
+		output.flush();
+		failed |= !output.good();
+	}
+
+
+	RecordSummary ExecutionRecorder::record(MinimalMachine& mima, const uint64_t& cycleLimit) {
+		std::ofstream output(fileName, std::ios::binary);
+		if (!output.good()) {
+			MIMA_LOG_ERROR("Failed to open record file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to open record file '{}'", fileName));
+		}
+
+		//the run starts over on a copy of the current memory, which is the recorded image
+		std::shared_ptr<const MemoryImage> image = std::make_shared<MemoryImage>(*mima.getMemory());
+
+		std::shared_ptr<DeviceBus> bus = mima.getDeviceBus();
+		std::vector<std::pair<size_t, size_t>> ranges;
+		if (bus) {
+			mima.setDeviceBus(bus->wrap([this, &ranges](const size_t& lower, const size_t& upper, const std::shared_ptr<Device>& device) {
+				ranges.push_back({ lower, upper });
+				return std::make_shared<RecordingDevice>(*this, lower, device);
+			}));
+		}
+		mima.reset(*image);
+		MIMA_LOG_INFO("Recording MiMa to '{}' with a digest every {} instructions", fileName, digestInterval);
+
+		inputCount = 0;
+		stallCount = 0;
+		uint64_t bytes = 0;
+		bool failed = false;
+		RecordSummary summary;
+		uint64_t digest = DIGEST_OFFSET;
+
+		RecordingSession session(*this, mima, bus, digest, std::thread([this, &output, &image, &ranges, &bytes, &failed]() {
+			write(output, *image, ranges, bytes, failed);
+		}));
+
+		//steps cycles instead of instructions, so a microprogram which never completes an instruction still ends at the cycle limit
+		while (mima.isRunning() && mima.getCycleCount() < cycleLimit) {
+			uint64_t instructions = mima.getInstructionCount();
+			mima.emulateClockCycle();
+
+			if (mima.getInstructionCount() != instructions) {
+				digest = addToDigest(digest, mima);
+
+				if (mima.getInstructionCount() % digestInterval == 0) {
+					push({ RecordEventType::DIGEST, mima.getCycleCount(), mima.getInstructionCount(), digest, 0, false });
+					summary.digests++;
+				}
+			}
+		}
+
+		session.end();
+
+		if (failed) {
+			MIMA_LOG_ERROR("Failed to write record file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to write record file '{}'", fileName));
+		}
+
+		summary.cycles = mima.getCycleCount();
+		summary.instructions = mima.getInstructionCount();
+		summary.inputs = inputCount;
+		summary.bytes = bytes;
+		summary.queueStalls = stallCount;
+		summary.halted = !mima.isRunning();
+		return summary;
+	}
+
+
+
+	// ------------------
+	// Execution replayer
+	// ------------------
+
+	class ExecutionReplayer::ReplayingDevice : public Device {
+	private:
+		ExecutionReplayer& replayer;
+		size_t lower;
+		Device* device; //the device of the replaying MiMa attached at the same address, if any
+
+	public:
+		ReplayingDevice(ExecutionReplayer& replayer, const size_t& lower, Device* device) : replayer(replayer), lower(lower), device(device) {}
+
+		uint32_t read(const size_t& offset, const uint64_t& cycle) override { return replayer.replayInput(lower + offset, cycle); }
+		void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) override {
+			if (device) {
+				device->write(offset, data, cycle);
+			}
+		}
+
+		void connect(EventScheduler& scheduler, MiMaMemory& memory) override {
+			if (device) {
+				device->connect(scheduler, memory);
+			}
+		}
+		void flush() override {
+			if (device) {
+				device->flush();
+			}
+		}
+	};
+
+
+	ExecutionReplayer::ExecutionReplayer(const std::string& fileName) : fileName(fileName), input(fileName, std::ios::binary), image(std::make_shared<MemoryImage>()) {
+		if (!input.good()) {
+			MIMA_LOG_ERROR("Failed to open record file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to open record file '{}'", fileName));
+		}
+
+		char magic[sizeof(RECORD_MAGIC)] = {};
+		input.read(magic, sizeof(magic));
+		if (!input.good() || std::memcmp(magic, RECORD_MAGIC, sizeof(RECORD_MAGIC) - 1) != 0 || (uint8_t)magic[sizeof(RECORD_MAGIC) - 1] != ExecutionRecorder::VERSION) {
+			MIMA_LOG_ERROR("'{}' is no MiMa record of version {}", fileName, ExecutionRecorder::VERSION);
+			throw std::runtime_error(fmt::format("'{}' is no MiMa record of version {}", fileName, ExecutionRecorder::VERSION));
+		}
+
+		digestInterval = readHeaderNumber();
+
+		size_t previousUpper = 0;
+		for (uint64_t rangeCount = readHeaderNumber(); rangeCount > 0; --rangeCount) {
+			size_t lower = previousUpper + readHeaderNumber();
+			previousUpper = lower + readHeaderNumber();
+			ranges.push_back({ lower, previousUpper });
+		}
+
+		size_t address = 0;
+		for (uint64_t cellCount = readHeaderNumber(); cellCount > 0; --cellCount) {
+			address += readHeaderNumber();
+			uint64_t data = readHeaderNumber();
+
+			if (address >= DEFAULT_MEMORY_CAPACITY || data > 0xFFFFFFFF) {
+				MIMA_LOG_ERROR("The image of record '{}' stores 0x{:X} at 0x{:X}, outside of the memory", fileName, data, address);
+				throw std::runtime_error(fmt::format("the image of record '{}' stores 0x{:X} at 0x{:X}, outside of the memory", fileName, data, address));
+			}
+			image->store(address, (uint32_t)data);
+		}
+
+		next = { RecordEventType::END, 0, 0, 0, 0, false };
+	}
+
+
+	bool ExecutionReplayer::readNumber(uint64_t& number) {
+		number = 0;
+		for (size_t shift = 0; shift < 64; shift += 7) {
+			int byte = input.get();
+			if (byte == std::char_traits<char>::eof()) {
+				return false;
+			}
+
+			number |= (uint64_t)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ExecutionReplayer::readFixed(uint64_t& number) {
+		unsigned char bytes[sizeof(uint64_t)];
+		if (!input.read((char*)bytes, sizeof(bytes))) {
+			return false;
+		}
+
+		number = 0;
+		for (size_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+			number |= (uint64_t)bytes[byte] << (8 * byte);
+		}
+		return true;
+	}
+
+	//the header has to be complete, unlike the events which end wherever the recording was interrupted
+	uint64_t ExecutionReplayer::readHeaderNumber() {
+		uint64_t number;
+		if (!readNumber(number)) {
+			MIMA_LOG_ERROR("The header of record '{}' is incomplete", fileName);
+			throw std::runtime_error(fmt::format("the header of record '{}' is incomplete", fileName));
+		}
+		return number;
+	}
+
+
+	void ExecutionReplayer::readEvent() {
+		uint64_t header = 0;
+		uint64_t argument = 0;
+		uint64_t value = 0;
+		uint64_t memoryDigest = 0;
+		int running = 0;
+
+		bool complete = readNumber(header);
+		RecordEventType type = (RecordEventType)(header & 3);
+
+		if (complete && type == RecordEventType::INPUT) {
+			complete = readNumber(argument) && readNumber(value);
+			argument = lastAddress + (uint64_t)fromZigZag(argument);
+		}
+		else if (complete && (type == RecordEventType::DIGEST || type == RecordEventType::END)) {
+			complete = readNumber(argument) && readFixed(value);
+			argument += lastInstructions;
+
+			if (complete && type == RecordEventType::END) {
+				complete = readFixed(memoryDigest) && (running = input.get()) != std::char_traits<char>::eof();
+			}
+		}
+		else {
+			complete = false;
+		}
+
+		//a record interrupted while recording, for example by a crash, ends with its last complete event
+		if (!complete) {
+			truncated = true;
+			next = { RecordEventType::END, next.cycle, lastInstructions, 0, 0, false };
+			return;
+		}
+
+		if (type == RecordEventType::INPUT) {
+			lastAddress = argument;
+		}
+		else {
+			lastInstructions = argument;
+		}
+		next = { type, next.cycle + (header >> 2), argument, value, memoryDigest, running != 0 };
+	}
+
+
+	uint32_t ExecutionReplayer::replayInput(const size_t& address, const uint64_t& cycle) {
+		if (next.type != RecordEventType::INPUT || next.cycle != cycle || next.argument != address) {
+			diverge(fmt::format("read from 0x{:05X} in cycle {}, but the record continues with {}", address, cycle, describe(next)));
+			return 0;
+		}
+
+		uint32_t data = (uint32_t)next.value;
+		summary.inputs++;
+		readEvent();
+		return data;
+	}
+
+	void ExecutionReplayer::diverge(const std::string& divergence) {
+		//only the first difference is reported, everything after it may follow from it
+		if (!summary.diverged) {
+			summary.diverged = true;
+			summary.divergence = divergence;
+			MIMA_LOG_WARN("Replay of '{}' diverged: {}", fileName, divergence);
+		}
+	}
+
+
+	ReplaySummary ExecutionReplayer::replay(MinimalMachine& mima) {
+		//writes still reach the devices of the MiMa at the recorded addresses, reads are answered from the record
+		std::shared_ptr<DeviceBus> bus = mima.getDeviceBus();
+		std::shared_ptr<DeviceBus> replayingBus;
+		if (!ranges.empty()) {
+			replayingBus = std::make_shared<DeviceBus>();
+
+			for (const std::pair<size_t, size_t>& range : ranges) {
+				size_t offset = 0;
+				Device* device = bus ? bus->find(range.first, offset) : nullptr;
+				replayingBus->attach(range.first, range.second, std::make_shared<ReplayingDevice>(*this, range.first, offset == 0 ? device : nullptr));
+			}
+		}
+		mima.setDeviceBus(replayingBus);
+		mima.reset(*image);
+		MIMA_LOG_INFO("Replaying '{}' with a digest every {} instructions", fileName, digestInterval);
+
+		summary = ReplaySummary();
+		uint64_t digest = DIGEST_OFFSET;
+		readEvent();
+
+		while (!summary.diverged && mima.isRunning() && !(next.type == RecordEventType::END && mima.getCycleCount() >= next.cycle)) {
+			uint64_t instructions = mima.getInstructionCount();
+			mima.emulateClockCycle();
+
+			if (mima.getInstructionCount() != instructions) {
+				digest = addToDigest(digest, mima);
+
+				if (mima.getInstructionCount() % digestInterval == 0 && !summary.diverged) {
+					if (next.type != RecordEventType::DIGEST || next.cycle != mima.getCycleCount() || next.argument != mima.getInstructionCount()) {
+						diverge(fmt::format("completed instruction {} in cycle {}, but the record continues with {}", mima.getInstructionCount(), mima.getCycleCount(), describe(next)));
+					}
+					else if (next.value != digest) {
+						diverge(fmt::format("the state after instruction {} in cycle {} differs from the record", mima.getInstructionCount(), mima.getCycleCount()));
+					}
+					else {
+						summary.digests++;
+						readEvent();
+					}
+				}
+			}
+
+			//a recorded event which should have happened by now
+			if (!summary.diverged && next.type != RecordEventType::END && next.cycle <= mima.getCycleCount()) {
+				diverge(fmt::format("the record continues with {}, which didn't happen", describe(next)));
+			}
+		}
+
+		if (truncated) {
+			summary.complete = false;
+		}
+		else if (!summary.diverged) {
+			if (next.type != RecordEventType::END) {
+				diverge(fmt::format("halted in cycle {}, but the record continues with {}", mima.getCycleCount(), describe(next)));
+			}
+			else if (next.cycle != mima.getCycleCount() || next.argument != mima.getInstructionCount() || next.running != mima.isRunning()) {
+				diverge(fmt::format("{} after instruction {} in cycle {}, but the recording {} after instruction {} in cycle {}", mima.isRunning() ? "stopped" : "halted",
+					mima.getInstructionCount(), mima.getCycleCount(), next.running ? "stopped" : "halted", next.argument, next.cycle));
+			}
+			else if (next.value != digest) {
+				diverge(fmt::format("the state after the last instruction {} differs from the record", mima.getInstructionCount()));
+			}
+			else if (next.memoryDigest != getMemoryDigest(*mima.getMemory())) {
+				diverge("the memory at the end differs from the record");
+			}
+		}
+
+		if (replayingBus) {
+			replayingBus->flush();
+		}
+		mima.setDeviceBus(bus);
+
+		summary.cycles = mima.getCycleCount();
+		summary.instructions = mima.getInstructionCount();
+		return summary;
+	}
+}
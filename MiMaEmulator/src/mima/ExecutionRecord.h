@@ -0,0 +1,166 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+//internal classes
+#include "MinimalMachine.h"
+#include "mimaprogram/MiMaMemory.h"
+
+//internal utility
+#include "util/SPSCQueue.h"
+
+
+namespace MiMa {
+	//the kinds of recorded events, stored in the lowest bits of the cycle delta every event starts with
+	enum class RecordEventType : uint8_t {
+		INPUT = 0,  //a device read
+		DIGEST = 1, //the digest of all instructions completed so far
+		END = 2     //the state the recording ended in
+	};
+
+	struct RecordEvent {
+		RecordEventType type;
+		uint64_t cycle;
+		uint64_t argument;     //INPUT: the address read, DIGEST and END: the instructions completed
+		uint64_t value;        //INPUT: the data read, DIGEST and END: the digest of the completed instructions
+		uint64_t memoryDigest; //END: the digest of the memory
+		bool running;          //END: whether the MiMa was stopped by the cycle limit instead of halting
+	};
+
+
+	struct RecordSummary {
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+		uint64_t inputs = 0;
+		uint64_t digests = 0;
+		uint64_t bytes = 0;       //the size of the record file
+		uint64_t queueStalls = 0; //events waiting for the writer thread to empty the queue
+		bool halted = false;
+	};
+
+	struct ReplaySummary {
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+		uint64_t inputs = 0;
+		uint64_t digests = 0;
+		bool diverged = false;
+		bool complete = true;   //false if the record ends without its end event, for example after a crash
+		std::string divergence; //the first difference to the record
+	};
+
+
+	// ------------------------------------------------
+	// Execution recorder
+	//
+	// Records a run of a MiMa so it can be replayed
+	// exactly: the initial memory, the address ranges
+	// of its devices, every value read from them and
+	// a digest of the architectural state every
+	// digestInterval instructions. The emulation only
+	// pushes raw events into a queue, a writer thread
+	// delta encodes them and writes the file, so the
+	// emulation never waits for I/O.
+	//
+	// File format, all numbers unsigned LEB128 unless
+	// marked as fixed (8 bytes little endian):
+	//   "MIMAREC" version, digestInterval
+	//   range count, per range: lower - previous upper, size
+	//   cell count, per cell: address - previous address, data
+	//   events, each starting with (cycle delta << 2) | type:
+	//     INPUT:  zig-zag address delta, data
+	//     DIGEST: instruction delta, fixed digest
+	//     END:    instruction delta, fixed digest, fixed memory digest, running byte
+	// ------------------------------------------------
+
+	class ExecutionRecorder {
+	public:
+		static constexpr uint8_t VERSION = 1;
+		static constexpr uint64_t DEFAULT_DIGEST_INTERVAL = 4096;
+		static constexpr size_t QUEUE_CAPACITY = 0x10000;
+		static constexpr size_t WRITE_BUFFER_SIZE = 0x10000;
+
+	private:
+		class RecordingDevice;
+		class RecordingSession;
+
+	private:
+		std::string fileName;
+		uint64_t digestInterval;
+
+		//from the emulation thread to the writer thread
+		SPSCQueue<RecordEvent> events;
+		//only touched by the emulation thread
+		uint64_t inputCount = 0;
+		uint64_t stallCount = 0;
+
+		void push(const RecordEvent& event);
+		void write(std::ofstream& output, const MemoryImage& image, const std::vector<std::pair<size_t, size_t>>& ranges, uint64_t& bytes, bool& failed);
+
+	public:
+		ExecutionRecorder(const std::string& fileName, const uint64_t& digestInterval = DEFAULT_DIGEST_INTERVAL);
+
+		//restarts the MiMa on its current memory and records the run until it halts or reaches the cycle limit,
+		//the devices are attached again afterwards, which resets them
+		RecordSummary record(MinimalMachine& mima, const uint64_t& cycleLimit = std::numeric_limits<uint64_t>::max());
+	};
+
+
+
+	// ------------------------------------------------
+	// Execution replayer
+	//
+	// Replays a record on a MiMa with the microprogram
+	// of the recorded one. Every device read is
+	// answered from the record, while writes still
+	// reach the devices of the MiMa attached at the
+	// recorded addresses. The replay stops at the
+	// first read, digest or end state not matching
+	// the record. A record can be replayed once.
+	// ------------------------------------------------
+
+	class ExecutionReplayer {
+	private:
+		class ReplayingDevice;
+
+	private:
+		std::string fileName;
+		std::ifstream input;
+
+		uint64_t digestInterval;
+		std::vector<std::pair<size_t, size_t>> ranges;
+		std::shared_ptr<MemoryImage> image;
+
+		//decoding state of the events
+		RecordEvent next;
+		bool truncated = false;
+		uint64_t lastAddress = 0;
+		uint64_t lastInstructions = 0;
+
+		ReplaySummary summary;
+
+		bool readNumber(uint64_t& number);
+		bool readFixed(uint64_t& number);
+		uint64_t readHeaderNumber();
+		void readEvent();
+
+		uint32_t replayInput(const size_t& address, const uint64_t& cycle);
+		void diverge(const std::string& divergence);
+
+	public:
+		//reads the header and image of the record
+		ExecutionReplayer(const std::string& fileName);
+
+		inline const std::shared_ptr<MemoryImage>& getImage() const { return image; }
+		inline uint64_t getDigestInterval() const { return digestInterval; }
+
+		//resets the MiMa to the recorded image and replays the record on it, the devices are attached again afterwards
+		ReplaySummary replay(MinimalMachine& mima);
+	};
+}
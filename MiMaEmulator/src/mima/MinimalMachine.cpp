@@ -1,5 +1,6 @@
 #include "mimapch.h"
 #include "MinimalMachine.h"
+#include "Profiler.h"
 
 //external vendor libraries
 #include <fmt/format.h>
@@ -17,7 +18,8 @@
 
 
 namespace MiMa {
-	MinimalMachine::MinimalMachine(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<MiMaMemory>& memory) :
+	template<typename MemoryTiming>
+	BasicMinimalMachine<MemoryTiming>::BasicMinimalMachine(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<MiMaMemory>& memory, const MemoryTiming& memoryTiming) :
 		//registers
 		accumulator({ 0 }),
 		instructionAddressRegister(0),
@@ -30,17 +32,79 @@ namespace MiMa {
 		//components
 		instructionDecoder(instructionDecoder),
 		memory(memory),
+		memoryTiming(memoryTiming),
 		//state
 		running(true),
 		instructionDecoderState(0),
-		memoryState({ 0, 0 })
+		memoryState({ 0, 0 }),
+		accessLatency(0),
+		stallCount(0),
+		cycleCount(0),
+		instructionCount(0),
+		instructionStartAddress(0),
+		instructionStartCycle(0)
 	{
 		MIMA_LOG_INFO("Initialized MiMa");
 	}
 
 
-	void MinimalMachine::emulateClockCycle() {
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::reset(const MemoryImage& image) {
+		MIMA_LOG_SCOPE(logger.get());
+		//registers
+		accumulator.value = 0;
+		instructionAddressRegister = 0;
+		instructionRegister.value = 0;
+		X = 0;
+		Y = 0;
+		Z = 0;
+		storageAddressRegister = 0;
+		storageDataRegister = 0;
+		//state
+		running = true;
+		instructionDecoderState = 0;
+		memoryState = { 0, 0 };
+		accessLatency = 0;
+		stallCount = 0;
+		cycleCount = 0;
+		instructionCount = 0;
+		instructionStartAddress = 0;
+		instructionStartCycle = 0;
+
+		//pending events and cached lines belong to the previous run
+		memoryTiming.reset();
+		scheduler.clear();
+		if (deviceBus) {
+			deviceBus->connect(scheduler, *memory);
+		}
+
+		memory->restore(image);
+		MIMA_LOG_INFO("Reset MiMa");
+	}
+
+
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::setDeviceBus(const std::shared_ptr<DeviceBus>& bus) {
+		//events of the previous devices must not outlive them
+		scheduler.clear();
+		deviceBus = bus;
+
+		if (deviceBus) {
+			deviceBus->connect(scheduler, *memory);
+		}
+	}
+
+
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::emulateClockCycle() {
+		MIMA_LOG_SCOPE(logger.get());
 		MIMA_LOG_TRACE("Starting MiMa clock cycle emulation");
+		cycleCount++;
+
+		//the only per cycle cost of timed devices
+		if (cycleCount >= scheduler.getNextEventCycle()) {
+			scheduler.run(cycleCount);
+		}
 
 		//get microcode for current register transfer
 		StatusBitMap statusBits;
@@ -48,6 +112,27 @@ namespace MiMa {
 		statusBits.insert({ "accumulator_negative", accumulator.negative.value });
 		MicroProgramCode microCode = instructionDecoder->getMicroCode(instructionDecoderState, statusBits);
 
+		//with a stalling timing model, an access the microcode doesn't continue although it hasn't completed yet
+		//holds the decoder in its state, the cycle only continues the access
+		bool stalled = false;
+		if (MemoryTiming::STALLS && memoryState.accessDuration != 0 && memoryState.accessDuration < accessLatency) {
+			bool continued = memoryState.access == 1 ? microCode.isReadingFromMemory() : microCode.isWritingToMemory();
+			if (!continued) {
+				MIMA_LOG_TRACE("Stalled MiMa decoder in 0x{:02X} for a memory access of {} cycles", instructionDecoderState, accessLatency);
+				stalled = true;
+				stallCount++;
+
+				microCode = MicroProgramCode();
+				if (memoryState.access == 1) {
+					microCode.enableMemoryRead();
+				}
+				else {
+					microCode.enableMemoryWrite();
+				}
+				microCode.setJump(instructionDecoderState);
+			}
+		}
+
 		MIMA_LOG_TRACE("Found microprogram instruction {}", microCode);
 
 		//put data on the data bus
@@ -97,6 +182,7 @@ namespace MiMa {
 			break;
 		case 0b110: //not
 			Z = ~X;
+			break;
 		case 0b111: //equals
 			Z = 0;
 			if (X == Y) {
@@ -125,9 +211,22 @@ namespace MiMa {
 			}
 			else {
 				memoryState.accessDuration++;
+			}
+
+			if (memoryState.accessDuration == 1) {
+				accessLatency = memoryTiming.startAccess(storageAddressRegister, true);
+			}
 
-				if (memoryState.accessDuration >= 3) {
-					(*memory)[storageAddressRegister].data = storageDataRegister;
+			if (memoryState.accessDuration >= accessLatency) {
+				size_t offset;
+				Device* device = deviceBus ? deviceBus->find(storageAddressRegister, offset) : nullptr;
+
+				//devices only see the cycle completing the access, repeating it must not repeat its side effects
+				if (device == nullptr) {
+					memory->store(storageAddressRegister, storageDataRegister);
+				}
+				else if (memoryState.accessDuration == accessLatency) {
+					device->write(offset, storageDataRegister, cycleCount);
 				}
 			}
 			break;
@@ -143,10 +242,22 @@ namespace MiMa {
 			}
 			else {
 				memoryState.accessDuration++;
+			}
 
-				if (memoryState.accessDuration >= 3) {
+			if (memoryState.accessDuration == 1) {
+				accessLatency = memoryTiming.startAccess(storageAddressRegister, false);
+			}
+
+			if (memoryState.accessDuration >= accessLatency) {
+				size_t offset;
+				Device* device = deviceBus ? deviceBus->find(storageAddressRegister, offset) : nullptr;
+
+				if (device == nullptr) {
 					storageDataRegister = (*memory)[storageAddressRegister].data;
 				}
+				else if (memoryState.accessDuration == accessLatency) {
+					storageDataRegister = device->read(offset, cycleCount);
+				}
 			}
 			break;
 		case 3:
@@ -154,17 +265,38 @@ namespace MiMa {
 			break;
 		}
 
+		//the decoder keeps its state until the access completed
+		if (stalled) {
+			return;
+		}
+
 		//step to next register transfer
 		uint8_t nextInstructionDecoderState = microCode.getNextInstructionDecoderState();
 		if (nextInstructionDecoderState == instructionDecoderState) {
 			MIMA_LOG_TRACE("Halted MiMa due to instruction repitition");
 			running = false;
+
+			if (deviceBus) {
+				deviceBus->flush();
+			}
+		}
+		else if (nextInstructionDecoderState == 0) {
+			//returning to the fetch completes the current instruction
+			instructionCount++;
+
+			if (profiler) {
+				profiler->record(instructionStartAddress, instructionAddressRegister, cycleCount - instructionStartCycle);
+			}
+			instructionStartAddress = instructionAddressRegister;
+			instructionStartCycle = cycleCount;
 		}
 		instructionDecoderState = nextInstructionDecoderState;
 		MIMA_LOG_TRACE("MiMa decoder now reading instruction 0x{:02X}", instructionDecoderState);
 	}
 
-	void MinimalMachine::emulateInstructionCycle() {
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::emulateInstructionCycle() {
+		MIMA_LOG_SCOPE(logger.get());
 		if (!running) {
 			MIMA_LOG_WARN("Failed to start instruction cycle emulation on a stopped MiMa");
 			return;
@@ -178,7 +310,9 @@ namespace MiMa {
 		} while (instructionDecoderState != 0 && running);
 	}
 
-	void MinimalMachine::emulateLifeTime() {
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::emulateLifeTime() {
+		MIMA_LOG_SCOPE(logger.get());
 		MIMA_LOG_TRACE("Starting MiMa lifetime cycle emulation");
 		MIMA_ASSERT_WARN(running, "MiMa is stopped, lifetime emulation terminated");
 
@@ -187,4 +321,26 @@ namespace MiMa {
 			emulateClockCycle();
 		}
 	}
+
+	template<typename MemoryTiming>
+	void BasicMinimalMachine<MemoryTiming>::emulateLifeTime(const uint64_t& cycleLimit) {
+		MIMA_LOG_SCOPE(logger.get());
+		MIMA_LOG_TRACE("Starting MiMa lifetime cycle emulation limited to {} cycles", cycleLimit);
+		MIMA_ASSERT_WARN(running, "MiMa is stopped, lifetime emulation terminated");
+
+		//keep emulating clock cycles until the MiMa is halted or out of cycles
+		while (running && cycleCount < cycleLimit) {
+			emulateClockCycle();
+		}
+
+		if (deviceBus) {
+			deviceBus->flush();
+		}
+	}
+
+
+	//the timing models a MiMa can be emulated with
+	template class BasicMinimalMachine<FixedMemoryTiming>;
+	template class BasicMinimalMachine<RegionMemoryTiming>;
+	template class BasicMinimalMachine<CachedMemoryTiming>;
 }
@@ -10,6 +10,9 @@
 //internal classes
 #include "mimaprogram/MiMaMemory.h"
 #include "microprogram/MicroProgram.h"
+#include "devices/DeviceBus.h"
+#include "devices/EventScheduler.h"
+#include "timing/MemoryTiming.h"
 
 //internal utility
 #include "util/MinType.h"
@@ -22,6 +25,9 @@
 
 
 namespace MiMa {
+	class Profiler;
+
+
 	// --------------------------------------
 	// Emulatable minimal machine abstraction
 	//
@@ -30,10 +36,17 @@ namespace MiMa {
 	// exchange some of these, for example
 	// the instruction decoder program or the
 	// initial main memory.
+	//
+	// The memory timing model is a policy
+	// (see MemoryTiming.h), so the default
+	// fixed latency compiles to a constant.
+	// Models are instantiated at the end of
+	// MinimalMachine.cpp.
 	// --------------------------------------
 
-	class MinimalMachine {
-		friend struct fmt::formatter<MiMa::MinimalMachine>;
+	template<typename MemoryTiming>
+	class BasicMinimalMachine {
+		friend struct fmt::formatter<MiMa::BasicMinimalMachine<MemoryTiming>>;
 
 	public:
 		//define data sizes for the MiMa
@@ -49,7 +62,7 @@ namespace MiMa {
 		struct MemoryState {
 			uint32_t address : 20;
 			uint32_t access : 1;
-			uint32_t accessDuration : 11;
+			uint32_t accessDuration : 11; //never exceeds MAX_MEMORY_LATENCY while the decoder stalls
 		};
 
 	private:
@@ -82,31 +95,82 @@ namespace MiMa {
 		//exchangable MiMa components
 		std::shared_ptr<const MicroProgram> instructionDecoder;
 		std::shared_ptr<MiMaMemory> memory;
+		std::shared_ptr<DeviceBus> deviceBus;
+		EventScheduler scheduler;
+		std::shared_ptr<Profiler> profiler;
+		std::shared_ptr<Logger> logger;
+		MemoryTiming memoryTiming;
 
 		//MiMa state
 		bool running;
 		uint8_t instructionDecoderState;
 		MemoryState memoryState;
+		uint32_t accessLatency;                         //cycles the current memory access takes
+		uint64_t stallCount;                            //cycles the decoder stalled for memory accesses
+		uint64_t cycleCount;
+		uint64_t instructionCount;
+		Address instructionStartAddress : ADDRESS_SIZE; //address of the current instruction
+		uint64_t instructionStartCycle;                 //cycle count before the current instruction
 	public:
-		MinimalMachine(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<MiMaMemory>& memory);
-		~MinimalMachine() { MIMA_LOG_INFO("Destructed MiMa"); }
+		BasicMinimalMachine(const std::shared_ptr<const MicroProgram>& instructionDecoder, const std::shared_ptr<MiMaMemory>& memory, const MemoryTiming& memoryTiming = MemoryTiming());
+		~BasicMinimalMachine() { MIMA_LOG_SCOPE(logger.get()); MIMA_LOG_INFO("Destructed MiMa"); }
+
+		inline const std::shared_ptr<MiMaMemory>& getMemory() const { return memory; }
+		inline const std::shared_ptr<DeviceBus>& getDeviceBus() const { return deviceBus; }
+		//routes all memory accesses to the address ranges of the bus devices to them, nullptr detaches the current bus
+		void setDeviceBus(const std::shared_ptr<DeviceBus>& bus);
+		inline EventScheduler& getScheduler() { return scheduler; }
+		//records every completed instruction in the profiler, nullptr stops profiling
+		inline void setProfiler(const std::shared_ptr<Profiler>& profiler) { this->profiler = profiler; }
+		inline const std::shared_ptr<Profiler>& getProfiler() const { return profiler; }
+		//logs everything emulated on this MiMa, including its memory timing, nullptr logs to the logger of the emulating thread
+		inline void setLogger(const std::shared_ptr<Logger>& logger) { this->logger = logger; }
+		inline const std::shared_ptr<Logger>& getLogger() const { return logger; }
+		//the timing model, for example to configure it or read its statistics
+		inline MemoryTiming& getMemoryTiming() { return memoryTiming; }
+		inline const MemoryTiming& getMemoryTiming() const { return memoryTiming; }
+		inline bool isRunning() const { return running; }
+		//architectural state, at an instruction boundary the instruction register holds the completed instruction and the instruction address the next one
+		inline Data getAccumulator() const { return accumulator.value; }
+		inline Data getInstructionRegister() const { return instructionRegister.value; }
+		inline Address getInstructionAddress() const { return instructionStartAddress; }
+		//clock cycles emulated since construction or the last reset
+		inline uint64_t getCycleCount() const { return cycleCount; }
+		//cycles spent waiting for memory accesses outlasting the access cycles of the microcode, 0 unless MemoryTiming::STALLS
+		inline uint64_t getStallCount() const { return stallCount; }
+		//instructions completed since construction or the last reset
+		inline uint64_t getInstructionCount() const { return instructionCount; }
+
+		//restores the initial state with the given memory content, reusing the current memory
+		void reset(const MemoryImage& image);
 
 		//emulate minimal machine
 		void emulateClockCycle();
 		void emulateInstructionCycle();
 		void emulateLifeTime();
+		//emulates clock cycles until the MiMa halts or the given total cycle count is reached
+		void emulateLifeTime(const uint64_t& cycleLimit);
 	};
+
+
+	typedef BasicMinimalMachine<FixedMemoryTiming> MinimalMachine;
+	typedef BasicMinimalMachine<RegionMemoryTiming> RegionTimedMinimalMachine;
+	typedef BasicMinimalMachine<CachedMemoryTiming> CachedMinimalMachine;
+
+	extern template class BasicMinimalMachine<FixedMemoryTiming>;
+	extern template class BasicMinimalMachine<RegionMemoryTiming>;
+	extern template class BasicMinimalMachine<CachedMemoryTiming>;
 }
 
 
 
 //minimal machine fmt formatting definition
-template<>
-struct fmt::formatter<MiMa::MinimalMachine> {
+template<typename MemoryTiming>
+struct fmt::formatter<MiMa::BasicMinimalMachine<MemoryTiming>> {
 	constexpr auto parse(format_parse_context& ctx) { return ctx.end(); }
 
 	template<typename FormatContext>
-	auto format(const MiMa::MinimalMachine& mima, FormatContext& ctx) {
+	auto format(const MiMa::BasicMinimalMachine<MemoryTiming>& mima, FormatContext& ctx) {
 		Tree<std::string> hierarchy("MinimalMachine state");
 		DataNode<std::string>& root = hierarchy.getRoot();
 
@@ -0,0 +1,367 @@
+#include "mimapch.h"
+#include "PipelinedMachine.h"
+
+//std library
+#include <iterator>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+
+namespace MiMa {
+	// ---------------
+	// Utility methods
+	// ---------------
+
+	//Utility: register widths of the MiMa
+	constexpr uint32_t DATA_MASK = 0xFFFFFF;
+	constexpr uint32_t ADDRESS_MASK = 0xFFFFF;
+	constexpr uint32_t NEGATIVE_BIT = 0x800000;
+
+	//Utility: operation codes of the instruction set, long operations keep their full eight bits
+	namespace Operation {
+		constexpr uint8_t LDC = 0x0;
+		constexpr uint8_t LDV = 0x1;
+		constexpr uint8_t STV = 0x2;
+		constexpr uint8_t ADD = 0x3;
+		constexpr uint8_t AND = 0x4;
+		constexpr uint8_t OR = 0x5;
+		constexpr uint8_t XOR = 0x6;
+		constexpr uint8_t EQL = 0x7;
+		constexpr uint8_t JMP = 0x8;
+		constexpr uint8_t JMN = 0x9;
+		constexpr uint8_t LONG = 0xF;
+		constexpr uint8_t HALT = 0xF0;
+		constexpr uint8_t NOT = 0xF1;
+		constexpr uint8_t RAR = 0xF2;
+	}
+
+	static uint8_t getOperation(const uint32_t& instruction) {
+		uint8_t operation = (instruction >> 20) & 0xF;
+		return operation == Operation::LONG ? (instruction >> 16) & 0xFF : operation;
+	}
+
+	static bool isAccessingMemory(const uint8_t& operation) {
+		return operation >= Operation::LDV && operation <= Operation::EQL;
+	}
+
+
+
+	// -----------------------------
+	// Pipelined machine statistics
+	// -----------------------------
+
+	void PipelineStatistics::writeReport(std::ostream& output) const {
+		fmt::memory_buffer report;
+		fmt::format_to(std::back_inserter(report), "{} cycles for {} instructions, {:.3f} cycles per instruction\n", cycles, instructions, getCyclesPerInstruction());
+		fmt::format_to(std::back_inserter(report), "stalls: {} memory, {} fetch, {} branch, {} hazard\n", memoryStalls, fetchStalls, branchStalls, hazardStalls);
+		fmt::format_to(std::back_inserter(report), "flushes: {} branch, {} hazard, discarding {} instructions\n", branchFlushes, hazardFlushes, flushedInstructions);
+		output.write(report.data(), report.size());
+	}
+
+
+
+	// ------------------
+	// Pipelined machine
+	// ------------------
+
+	PipelinedMachine::PipelinedMachine(const std::shared_ptr<MiMaMemory>& memory) :
+		//architectural state
+		accumulator(0),
+		instructionAddressRegister(0),
+		instructionRegister(0),
+		//pipeline state
+		epoch(0),
+		refill(Refill::NONE),
+		//components
+		memory(memory),
+		running(true)
+	{
+		MIMA_LOG_INFO("Initialized pipelined MiMa");
+	}
+
+
+	void PipelinedMachine::reset(const MemoryImage& image) {
+		MIMA_LOG_SCOPE(logger.get());
+		accumulator = 0;
+		instructionAddressRegister = 0;
+		instructionRegister = 0;
+		fetchStage = StageLatch();
+		decodeStage = StageLatch();
+		executeStage = StageLatch();
+		epoch = 0;
+		refill = Refill::NONE;
+		running = true;
+		statistics = PipelineStatistics();
+
+		//pending events belong to the previous run
+		scheduler.clear();
+		if (deviceBus) {
+			deviceBus->connect(scheduler, *memory);
+		}
+
+		memory->restore(image);
+		MIMA_LOG_INFO("Reset pipelined MiMa");
+	}
+
+
+	uint32_t PipelinedMachine::getInstructionAddress() const {
+		//the oldest instruction in the pipeline is the next one to complete, all younger ones may still be flushed
+		if (executeStage.valid) {
+			return executeStage.address;
+		}
+		if (decodeStage.valid) {
+			return decodeStage.address;
+		}
+		return fetchStage.valid ? fetchStage.address : instructionAddressRegister;
+	}
+
+
+	void PipelinedMachine::setDeviceBus(const std::shared_ptr<DeviceBus>& bus) {
+		//events of the previous devices must not outlive them
+		scheduler.clear();
+		deviceBus = bus;
+
+		if (deviceBus) {
+			deviceBus->connect(scheduler, *memory);
+		}
+	}
+
+
+	uint32_t PipelinedMachine::load(const uint32_t& address) {
+		size_t offset;
+		Device* device = deviceBus ? deviceBus->find(address, offset) : nullptr;
+
+		return (device == nullptr ? (*memory)[address].data : device->read(offset, statistics.cycles)) & DATA_MASK;
+	}
+
+	void PipelinedMachine::store(const uint32_t& address, const uint32_t& data) {
+		size_t offset;
+		Device* device = deviceBus ? deviceBus->find(address, offset) : nullptr;
+
+		if (device == nullptr) {
+			memory->store(address, data);
+		}
+		else {
+			device->write(offset, data, statistics.cycles);
+		}
+	}
+
+
+	void PipelinedMachine::flush(const uint32_t& address, const Refill& reason, const bool& includingDecode) {
+		//a fetch which didn't start yet discards no instruction
+		statistics.flushedInstructions += (fetchStage.valid && fetchStage.progress != 0) + (includingDecode && decodeStage.valid);
+		(reason == Refill::BRANCH ? statistics.branchFlushes : statistics.hazardFlushes)++;
+
+		fetchStage = StageLatch();
+		if (includingDecode) {
+			decodeStage = StageLatch();
+		}
+
+		instructionAddressRegister = address & ADDRESS_MASK;
+		epoch++;
+		refill = reason;
+		MIMA_LOG_TRACE("Flushed the pipeline, continuing at 0x{:05X}", instructionAddressRegister);
+	}
+
+
+	bool PipelinedMachine::execute() {
+		uint8_t operation = getOperation(executeStage.instruction);
+		uint32_t address = executeStage.instruction & ADDRESS_MASK;
+
+		executeStage.progress++;
+		if (isAccessingMemory(operation) && executeStage.progress < MEMORY_LATENCY) {
+			return false;
+		}
+
+		//the first instruction fetched after the last flush ends the refill
+		executeStage.valid = false;
+		instructionRegister = executeStage.instruction;
+		if (executeStage.epoch == epoch) {
+			refill = Refill::NONE;
+		}
+
+		switch (operation) {
+		case Operation::LDC:
+			accumulator = executeStage.instruction & DATA_MASK;
+			break;
+		case Operation::LDV:
+			accumulator = load(address);
+			break;
+		case Operation::STV:
+			store(address, accumulator);
+
+			//fetches read the memory when they complete, so only instructions fetched before the store are stale
+			if ((decodeStage.valid && decodeStage.address == address) || (fetchStage.valid && fetchStage.progress == MEMORY_LATENCY && fetchStage.address == address)) {
+				flush(decodeStage.valid ? decodeStage.address : fetchStage.address, Refill::HAZARD, true);
+			}
+			break;
+		case Operation::ADD:
+			accumulator = (accumulator + load(address)) & DATA_MASK;
+			break;
+		case Operation::AND:
+			accumulator &= load(address);
+			break;
+		case Operation::OR:
+			accumulator |= load(address);
+			break;
+		case Operation::XOR:
+			accumulator ^= load(address);
+			break;
+		case Operation::EQL:
+			accumulator = accumulator == load(address) ? DATA_MASK : 0;
+			break;
+		case Operation::JMP:
+			//the fetch was redirected when decoding
+			break;
+		case Operation::JMN:
+			if (accumulator & NEGATIVE_BIT) {
+				flush(address, Refill::BRANCH, true);
+			}
+			break;
+		case Operation::NOT:
+			accumulator = ~accumulator & DATA_MASK;
+			break;
+		case Operation::RAR:
+			accumulator = (accumulator >> 1) | ((accumulator & 1) << 23);
+			break;
+		case Operation::HALT:
+		default:
+			//like the microcoded decoder, every unknown operation halts
+			MIMA_LOG_TRACE("Halted pipelined MiMa at 0x{:05X}", executeStage.address);
+			running = false;
+
+			if (deviceBus) {
+				deviceBus->flush();
+			}
+			return true;
+		}
+
+		statistics.instructions++;
+		return true;
+	}
+
+	void PipelinedMachine::decode() {
+		//a jump is known as soon as it is decoded, only the fetch behind it is wasted
+		if (decodeStage.progress == 0 && getOperation(decodeStage.instruction) == Operation::JMP) {
+			flush(decodeStage.instruction, Refill::BRANCH, false);
+		}
+		decodeStage.progress++;
+
+		if (!executeStage.valid) {
+			executeStage = decodeStage;
+			executeStage.progress = 0;
+			decodeStage.valid = false;
+		}
+	}
+
+	void PipelinedMachine::fetch(const bool& memoryPortBusy) {
+		if (!fetchStage.valid) {
+			fetchStage = StageLatch();
+			fetchStage.valid = true;
+			fetchStage.address = instructionAddressRegister;
+			fetchStage.epoch = epoch;
+			instructionAddressRegister = (instructionAddressRegister + 1) & ADDRESS_MASK;
+		}
+
+		//a flush can't undo reading a device, so instructions are only fetched from devices once no older one is left
+		size_t offset;
+		bool speculative = (decodeStage.valid || executeStage.valid) && deviceBus && deviceBus->find(fetchStage.address, offset) != nullptr;
+
+		//the execute stage has the memory port first
+		if (fetchStage.progress < MEMORY_LATENCY && !memoryPortBusy && !speculative) {
+			fetchStage.progress++;
+
+			if (fetchStage.progress == MEMORY_LATENCY) {
+				fetchStage.instruction = load(fetchStage.address);
+			}
+		}
+
+		if (fetchStage.progress == MEMORY_LATENCY && !decodeStage.valid) {
+			decodeStage = fetchStage;
+			decodeStage.progress = 0;
+			fetchStage.valid = false;
+		}
+	}
+
+
+	void PipelinedMachine::emulateClockCycle() {
+		MIMA_LOG_SCOPE(logger.get());
+		MIMA_LOG_TRACE("Starting pipelined MiMa clock cycle emulation");
+		statistics.cycles++;
+
+		if (statistics.cycles >= scheduler.getNextEventCycle()) {
+			scheduler.run(statistics.cycles);
+		}
+
+		//stages work from the oldest instruction to the youngest, so every stage sees the one in front of it already moved on
+		bool memoryPortBusy = false;
+		if (executeStage.valid) {
+			memoryPortBusy = isAccessingMemory(getOperation(executeStage.instruction));
+
+			if (!execute()) {
+				statistics.memoryStalls++;
+			}
+			if (!running) {
+				return;
+			}
+		}
+		else {
+			switch (refill) {
+			case Refill::BRANCH:
+				statistics.branchStalls++;
+				break;
+			case Refill::HAZARD:
+				statistics.hazardStalls++;
+				break;
+			case Refill::NONE:
+				statistics.fetchStalls++;
+				break;
+			}
+		}
+
+		if (decodeStage.valid) {
+			decode();
+		}
+		fetch(memoryPortBusy);
+	}
+
+	void PipelinedMachine::emulateInstructionCycle() {
+		MIMA_LOG_SCOPE(logger.get());
+		if (!running) {
+			MIMA_LOG_WARN("Failed to start instruction cycle emulation on a stopped pipelined MiMa");
+			return;
+		}
+
+		MIMA_LOG_TRACE("Starting pipelined MiMa instruction cycle emulation");
+
+		uint64_t instructions = statistics.instructions;
+		do {
+			emulateClockCycle();
+		} while (statistics.instructions == instructions && running);
+	}
+
+	void PipelinedMachine::emulateLifeTime() {
+		MIMA_LOG_SCOPE(logger.get());
+		MIMA_LOG_TRACE("Starting pipelined MiMa lifetime cycle emulation");
+		MIMA_ASSERT_WARN(running, "Pipelined MiMa is stopped, lifetime emulation terminated");
+
+		while (running) {
+			emulateClockCycle();
+		}
+	}
+
+	void PipelinedMachine::emulateLifeTime(const uint64_t& cycleLimit) {
+		MIMA_LOG_SCOPE(logger.get());
+		MIMA_LOG_TRACE("Starting pipelined MiMa lifetime cycle emulation limited to {} cycles", cycleLimit);
+		MIMA_ASSERT_WARN(running, "Pipelined MiMa is stopped, lifetime emulation terminated");
+
+		while (running && statistics.cycles < cycleLimit) {
+			emulateClockCycle();
+		}
+
+		if (deviceBus) {
+			deviceBus->flush();
+		}
+	}
+}
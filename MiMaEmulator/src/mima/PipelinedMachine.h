@@ -0,0 +1,180 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//internal classes
+#include "mimaprogram/MiMaMemory.h"
+#include "devices/DeviceBus.h"
+#include "devices/EventScheduler.h"
+#include "timing/MemoryTiming.h"
+
+//internal utility
+#include "util/Tree.h"
+
+//debugging utility
+#include "debug/Log.h"
+#include "debug/LogFormat.h"
+
+
+namespace MiMa {
+	//where the cycles of a pipelined MiMa went, every cycle completing no instruction is counted as a stall by its cause
+	struct PipelineStatistics {
+		uint64_t cycles = 0;
+		uint64_t instructions = 0;
+
+		uint64_t memoryStalls = 0; //the execute stage waited for its memory access
+		uint64_t fetchStalls = 0;  //the execute stage waited for the next instruction to be fetched
+		uint64_t branchStalls = 0; //the pipeline refilled after a taken jump
+		uint64_t hazardStalls = 0; //the pipeline refilled after a store overwrote an instruction already fetched
+
+		uint64_t branchFlushes = 0;
+		uint64_t hazardFlushes = 0;
+		uint64_t flushedInstructions = 0;
+
+		inline double getCyclesPerInstruction() const { return instructions == 0 ? 0.0 : (double)cycles / instructions; }
+
+		//writes the CPI, the stall breakdown and the flush counts
+		void writeReport(std::ostream& output) const;
+	};
+
+
+
+	// ------------------------------------------------
+	// Pipelined minimal machine
+	//
+	// Executes the MiMa instruction set directly, in
+	// a fetch, decode and execute stage overlapping
+	// three consecutive instructions. Both the fetch
+	// and the execute stage access the memory through
+	// its single port with the latency of the
+	// microcoded MiMa, the execute stage first.
+	//
+	// Jumps are predicted as not taken: JMP redirects
+	// the fetch when decoded, a taken JMN flushes the
+	// decode and fetch stage when executed. A store to
+	// an instruction already fetched flushes it, so
+	// self modifying programs stay correct. Fetches go
+	// through the device bus like all other accesses,
+	// but wait for the older instructions to complete
+	// before reading a device.
+	// ------------------------------------------------
+
+	class PipelinedMachine {
+		friend struct fmt::formatter<MiMa::PipelinedMachine>;
+
+	public:
+		static constexpr uint32_t MEMORY_LATENCY = FixedMemoryTiming::LATENCY;
+
+	private:
+		//an instruction in one of the stages, tagged with the flush epoch it was fetched in
+		struct StageLatch {
+			bool valid = false;
+			uint32_t address = 0;
+			uint32_t instruction = 0;
+			uint32_t progress = 0; //cycles spent in the stage
+			uint64_t epoch = 0;
+		};
+
+		enum class Refill {
+			NONE,
+			BRANCH,
+			HAZARD
+		};
+
+	private:
+		//architectural state
+		uint32_t accumulator;
+		uint32_t instructionAddressRegister; //address of the next instruction to fetch
+		uint32_t instructionRegister;        //the last instruction executed
+
+		//pipeline state
+		StageLatch fetchStage;
+		StageLatch decodeStage;
+		StageLatch executeStage;
+		uint64_t epoch;
+		Refill refill;
+
+		//exchangable components
+		std::shared_ptr<MiMaMemory> memory;
+		std::shared_ptr<DeviceBus> deviceBus;
+		EventScheduler scheduler;
+		std::shared_ptr<Logger> logger;
+
+		bool running;
+		PipelineStatistics statistics;
+
+		uint32_t load(const uint32_t& address);
+		void store(const uint32_t& address, const uint32_t& data);
+
+		//executes the instruction in the execute stage once its memory access is done, returns false while waiting for it
+		bool execute();
+		void decode();
+		void fetch(const bool& memoryPortBusy);
+		//discards the fetch stage, and the decode stage if it holds a younger instruction than the flushing one, and continues fetching at the given address
+		void flush(const uint32_t& address, const Refill& reason, const bool& includingDecode);
+
+	public:
+		PipelinedMachine(const std::shared_ptr<MiMaMemory>& memory);
+
+		inline const std::shared_ptr<MiMaMemory>& getMemory() const { return memory; }
+		inline const std::shared_ptr<DeviceBus>& getDeviceBus() const { return deviceBus; }
+		//routes all data accesses to the address ranges of the bus devices to them, nullptr detaches the current bus
+		void setDeviceBus(const std::shared_ptr<DeviceBus>& bus);
+		inline EventScheduler& getScheduler() { return scheduler; }
+		//logs everything emulated on this MiMa, nullptr logs to the logger of the emulating thread
+		inline void setLogger(const std::shared_ptr<Logger>& logger) { this->logger = logger; }
+		inline const std::shared_ptr<Logger>& getLogger() const { return logger; }
+		inline bool isRunning() const { return running; }
+		//architectural state like the one of the microcoded MiMa, at an instruction boundary the instruction register holds the completed instruction and the instruction address the next one
+		inline uint32_t getAccumulator() const { return accumulator; }
+		inline uint32_t getInstructionRegister() const { return instructionRegister; }
+		uint32_t getInstructionAddress() const;
+		inline uint64_t getCycleCount() const { return statistics.cycles; }
+		inline uint64_t getInstructionCount() const { return statistics.instructions; }
+		inline const PipelineStatistics& getStatistics() const { return statistics; }
+
+		//restores the initial state with the given memory content, reusing the current memory
+		void reset(const MemoryImage& image);
+
+		void emulateClockCycle();
+		//emulates clock cycles until the next instruction is completed or the MiMa is halted
+		void emulateInstructionCycle();
+		void emulateLifeTime();
+		//emulates clock cycles until the MiMa halts or the given total cycle count is reached
+		void emulateLifeTime(const uint64_t& cycleLimit);
+	};
+}
+
+
+
+//pipelined minimal machine fmt formatting definition
+template<>
+struct fmt::formatter<MiMa::PipelinedMachine> {
+	constexpr auto parse(format_parse_context& ctx) { return ctx.end(); }
+
+	template<typename FormatContext>
+	auto format(const MiMa::PipelinedMachine& mima, FormatContext& ctx) {
+		Tree<std::string> hierarchy("PipelinedMachine state");
+		DataNode<std::string>& root = hierarchy.getRoot();
+
+		root.addChild(fmt::format("running: {}", mima.running));
+
+		DataNode<std::string>& stagesRoot = root.addChild("Pipeline stages");
+		const std::pair<const char*, const MiMa::PipelinedMachine::StageLatch*> stages[] = { { "fetch", &mima.fetchStage }, { "decode", &mima.decodeStage }, { "execute", &mima.executeStage } };
+		for (const std::pair<const char*, const MiMa::PipelinedMachine::StageLatch*>& stage : stages) {
+			stagesRoot.addChild(stage.second->valid ? fmt::format("{}: 0x{:06X} from 0x{:05X}", stage.first, stage.second->instruction, stage.second->address) : fmt::format("{}: empty", stage.first));
+		}
+
+		DataNode<std::string>& registersRoot = root.addChild("Register states");
+		registersRoot.addChild(fmt::format("IAR: 0x{:05X}", mima.instructionAddressRegister));
+		registersRoot.addChild(fmt::format("Accumulator: 0x{:06X}", mima.accumulator));
+
+		return fmt::format_to(ctx.out(), MiMa::formatHierarchy(hierarchy));
+	}
+};
@@ -0,0 +1,131 @@
+#include "mimapch.h"
+#include "Profiler.h"
+
+//std library
+#include <iterator>
+#include <map>
+#include <numeric>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+
+namespace MiMa {
+	Profiler::Profiler() :
+		executions(ADDRESS_COUNT, 0),
+		cycles(ADDRESS_COUNT, 0),
+		jumpTargets(ADDRESS_COUNT, false)
+	{}
+
+
+	void Profiler::clear() {
+		std::fill(executions.begin(), executions.end(), 0);
+		std::fill(cycles.begin(), cycles.end(), 0);
+		std::fill(jumpTargets.begin(), jumpTargets.end(), false);
+	}
+
+
+	std::vector<Hotspot> Profiler::getHotspots() const {
+		std::vector<Hotspot> hotspots;
+		for (size_t address = 0; address < ADDRESS_COUNT; ++address) {
+			if (executions[address] != 0) {
+				hotspots.push_back({ address, executions[address], cycles[address] });
+			}
+		}
+
+		std::stable_sort(hotspots.begin(), hotspots.end(), [](const Hotspot& left, const Hotspot& right) {
+			return left.cycles > right.cycles;
+		});
+		return hotspots;
+	}
+
+
+	std::vector<std::pair<size_t, std::string>> Profiler::getFunctions(const MiMaSymbolTable* symbolTable) const {
+		//the alphabetically first symbol naming an address, constants might share the value of a label
+		std::map<size_t, std::string> labels;
+		if (symbolTable) {
+			for (const std::pair<const std::string, uint32_t>& symbol : *symbolTable) {
+				std::map<size_t, std::string>::iterator label = labels.find(symbol.second);
+				if (label == labels.end() || symbol.first < label->second) {
+					labels[symbol.second] = symbol.first;
+				}
+			}
+		}
+
+		std::vector<std::pair<size_t, std::string>> functions;
+		for (size_t address = 0; address < ADDRESS_COUNT; ++address) {
+			if (jumpTargets[address]) {
+				std::map<size_t, std::string>::const_iterator label = labels.find(address);
+				functions.push_back({ address, label != labels.end() ? label->second : fmt::format("0x{:05X}", address) });
+			}
+		}
+		return functions;
+	}
+
+
+	void Profiler::writeReport(std::ostream& output, const MiMaSourceMap* sourceMap, const size_t& limit) const {
+		std::vector<Hotspot> hotspots = getHotspots();
+
+		uint64_t totalCycles = 0;
+		for (const Hotspot& hotspot : hotspots) {
+			totalCycles += hotspot.cycles;
+		}
+
+		fmt::memory_buffer report;
+		fmt::format_to(std::back_inserter(report), "{:>12} {:>7} {:>12}  {:<7}  {}\n", "cycles", "share", "executions", "address", "source");
+
+		size_t count = (limit == 0) ? hotspots.size() : std::min(limit, hotspots.size());
+		for (size_t i = 0; i < count; ++i) {
+			const Hotspot& hotspot = hotspots[i];
+
+			std::string source;
+			if (sourceMap) {
+				MiMaSourceMap::const_iterator sourceLine = sourceMap->find((uint32_t)hotspot.address);
+				if (sourceLine != sourceMap->end()) {
+					source = fmt::format("{}: {}", sourceLine->second.lineNumber, sourceLine->second.code);
+				}
+			}
+
+			double share = totalCycles == 0 ? 0.0 : 100.0 * hotspot.cycles / totalCycles;
+			fmt::format_to(std::back_inserter(report), "{:>12} {:>6.2f}% {:>12}  0x{:05X}  {}\n", hotspot.cycles, share, hotspot.executions, hotspot.address, source);
+		}
+
+		fmt::format_to(std::back_inserter(report), "{:>12} cycles in {} executed instructions at {} addresses\n", totalCycles, std::accumulate(executions.begin(), executions.end(), (uint64_t)0), hotspots.size());
+		output.write(report.data(), report.size());
+	}
+
+
+	void Profiler::writeFoldedStacks(std::ostream& output, const MiMaSourceMap* sourceMap, const MiMaSymbolTable* symbolTable) const {
+		std::vector<std::pair<size_t, std::string>> functions = getFunctions(symbolTable);
+
+		fmt::memory_buffer stacks;
+		std::vector<std::pair<size_t, std::string>>::const_iterator function = functions.begin();
+		std::string functionName = "entry";
+
+		//addresses ascend, so the enclosing function only ever moves forward
+		for (size_t address = 0; address < ADDRESS_COUNT; ++address) {
+			if (cycles[address] == 0) {
+				continue;
+			}
+
+			while (function != functions.end() && function->first <= address) {
+				functionName = function->second;
+				++function;
+			}
+
+			std::string instruction = fmt::format("0x{:05X}", address);
+			if (sourceMap) {
+				MiMaSourceMap::const_iterator sourceLine = sourceMap->find((uint32_t)address);
+				if (sourceLine != sourceMap->end()) {
+					instruction = fmt::format("{} {}", instruction, sourceLine->second.code);
+				}
+			}
+
+			//semicolons separate the frames of a stack
+			std::replace(instruction.begin(), instruction.end(), ';', ',');
+			fmt::format_to(std::back_inserter(stacks), "{};{} {}\n", functionName, instruction, cycles[address]);
+		}
+
+		output.write(stacks.data(), stacks.size());
+	}
+}
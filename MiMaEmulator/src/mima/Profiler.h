@@ -0,0 +1,70 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//internal classes
+#include "mimaprogram/MiMaCompiler.h"
+#include "mimaprogram/MiMaMemory.h"
+
+
+namespace MiMa {
+	//the totals of a single instruction address
+	struct Hotspot {
+		size_t address;
+		uint64_t executions;
+		uint64_t cycles;
+	};
+
+
+	// ------------------------------------------------
+	// Instruction profiler
+	//
+	// Counts the executions and clock cycles of every
+	// instruction address in flat arrays over the whole
+	// address space, so recording a completed
+	// instruction is a pair of array increments. Taken
+	// jumps are recorded by their target, which the
+	// folded stacks use as function entries, since the
+	// MiMa has no calls to tell them apart.
+	// ------------------------------------------------
+
+	class Profiler {
+	public:
+		static constexpr size_t ADDRESS_COUNT = DEFAULT_MEMORY_CAPACITY + 1;
+
+	private:
+		std::vector<uint64_t> executions;
+		std::vector<uint64_t> cycles;
+		std::vector<bool> jumpTargets;
+
+		//the name of the function an address belongs to: the label or address of the nearest jump target at or before it
+		std::vector<std::pair<size_t, std::string>> getFunctions(const MiMaSymbolTable* symbolTable) const;
+
+	public:
+		Profiler();
+
+		//called by the MiMa for every completed instruction with the address the next instruction is fetched from
+		inline void record(const size_t& address, const size_t& nextAddress, const uint64_t& instructionCycles) {
+			executions[address]++;
+			cycles[address] += instructionCycles;
+
+			if (nextAddress != address + 1) {
+				jumpTargets[nextAddress] = true;
+			}
+		}
+
+		void clear();
+
+		//all executed addresses, the most cycles first
+		std::vector<Hotspot> getHotspots() const;
+
+		//writes a table of the hottest (at most limit, 0 = all) instructions with their share of all cycles and their source lines
+		void writeReport(std::ostream& output, const MiMaSourceMap* sourceMap = nullptr, const size_t& limit = 0) const;
+		//writes the cycles in the folded stack format of flamegraph tools: function;instruction cycles
+		void writeFoldedStacks(std::ostream& output, const MiMaSourceMap* sourceMap = nullptr, const MiMaSymbolTable* symbolTable = nullptr) const;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+//std library
+#include <cstddef>
+#include <cstdint>
+
+//internal classes
+#include "EventScheduler.h"
+
+
+namespace MiMa {
+	class MiMaMemory;
+
+
+	// ------------------------------------------------
+	// Memory mapped device
+	//
+	// A host side device attached to a range of MiMa
+	// addresses. Every completed memory access to one
+	// of its addresses is passed to the device instead
+	// of the main memory, together with the address
+	// offset into its range and the current clock
+	// cycle of the accessing MiMa. Timed devices get
+	// the event scheduler of the MiMa on connection,
+	// devices accessing the main memory its memory.
+	// ------------------------------------------------
+
+	class Device {
+	public:
+		virtual ~Device() {}
+
+		virtual uint32_t read(const size_t& offset, const uint64_t& cycle) = 0;
+		virtual void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) = 0;
+
+		//called when the MiMa the device is attached to is set up or reset, with a fresh scheduler for its future events and the memory of the MiMa
+		virtual void connect(EventScheduler&, MiMaMemory&) {}
+
+		//hands all buffered host I/O over to the host
+		virtual void flush() {}
+	};
+}
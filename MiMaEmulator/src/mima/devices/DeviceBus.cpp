@@ -0,0 +1,81 @@
+#include "mimapch.h"
+#include "DeviceBus.h"
+
+//std library
+#include <stdexcept>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+	void DeviceBus::attach(const size_t& lower, const size_t& upper, const std::shared_ptr<Device>& device) {
+		if (lower >= upper || device == nullptr) {
+			MIMA_LOG_ERROR("Failed to attach device to the empty address range [0x{:05X}, 0x{:05X})", lower, upper);
+			throw std::invalid_argument(fmt::format("failed to attach device to the empty address range [0x{:05X}, 0x{:05X})", lower, upper));
+		}
+
+		auto position = std::lower_bound(attachments.begin(), attachments.end(), lower, [](const Attachment& attachment, const size_t& address) {
+			return attachment.lower < address;
+		});
+
+		//only the direct neighbours can overlap the new range
+		if ((position != attachments.end() && position->lower < upper) || (position != attachments.begin() && std::prev(position)->upper > lower)) {
+			MIMA_LOG_ERROR("Failed to attach device to [0x{:05X}, 0x{:05X}), the range is already in use", lower, upper);
+			throw std::invalid_argument(fmt::format("failed to attach device to [0x{:05X}, 0x{:05X}), the range is already in use", lower, upper));
+		}
+
+		attachments.insert(position, { lower, upper, device });
+		lowestAddress = std::min(lowestAddress, lower);
+		MIMA_LOG_INFO("Attached device to [0x{:05X}, 0x{:05X})", lower, upper);
+	}
+
+
+	Device* DeviceBus::findAttached(const size_t& address, size_t& offset) const {
+		//find the last range starting at or before the address
+		auto position = std::upper_bound(attachments.begin(), attachments.end(), address, [](const size_t& address, const Attachment& attachment) {
+			return address < attachment.lower;
+		});
+		if (position == attachments.begin()) {
+			return nullptr;
+		}
+
+		const Attachment& attachment = *std::prev(position);
+		if (address >= attachment.upper) {
+			return nullptr;
+		}
+
+		offset = address - attachment.lower;
+		return attachment.device.get();
+	}
+
+
+	std::shared_ptr<DeviceBus> DeviceBus::wrap(const DeviceWrapper& wrapper) const {
+		std::shared_ptr<DeviceBus> bus = std::make_shared<DeviceBus>();
+
+		//the ranges are already sorted and disjoint
+		for (const Attachment& attachment : attachments) {
+			bus->attachments.push_back({ attachment.lower, attachment.upper, wrapper(attachment.lower, attachment.upper, attachment.device) });
+		}
+		bus->lowestAddress = lowestAddress;
+
+		return bus;
+	}
+
+
+	void DeviceBus::connect(EventScheduler& scheduler, MiMaMemory& memory) {
+		for (Attachment& attachment : attachments) {
+			attachment.device->connect(scheduler, memory);
+		}
+	}
+
+
+	void DeviceBus::flush() {
+		for (Attachment& attachment : attachments) {
+			attachment.device->flush();
+		}
+	}
+}
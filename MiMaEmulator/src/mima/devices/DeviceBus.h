@@ -0,0 +1,64 @@
+#pragma once
+
+//std library
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//internal classes
+#include "Device.h"
+
+
+namespace MiMa {
+	//creates the device standing in for the given one, attached to the addresses [lower, upper)
+	typedef std::function<std::shared_ptr<Device>(const size_t& lower, const size_t& upper, const std::shared_ptr<Device>& device)> DeviceWrapper;
+
+
+	// ------------------------------------------------
+	// Device bus
+	//
+	// Maps disjoint address ranges to devices. Every
+	// memory access of a MiMa with an attached bus is
+	// first looked up here, so addresses below the
+	// lowest attached device are rejected with a single
+	// comparison and everything else with a binary
+	// search over the (few) attached ranges.
+	// ------------------------------------------------
+
+	class DeviceBus {
+	private:
+		struct Attachment {
+			size_t lower;
+			size_t upper;
+			std::shared_ptr<Device> device;
+		};
+
+	private:
+		std::vector<Attachment> attachments; //sorted by address
+		size_t lowestAddress = std::numeric_limits<size_t>::max();
+
+		Device* findAttached(const size_t& address, size_t& offset) const;
+
+	public:
+		//attaches the device to the addresses [lower, upper), which may not overlap any other device
+		void attach(const size_t& lower, const size_t& upper, const std::shared_ptr<Device>& device);
+
+		//returns the device the address is mapped to and the offset into its range, nullptr for main memory addresses
+		inline Device* find(const size_t& address, size_t& offset) const {
+			return address < lowestAddress ? nullptr : findAttached(address, offset);
+		}
+
+		inline bool isEmpty() const { return attachments.empty(); }
+
+		//creates a bus with the same address ranges, each attached to the device the wrapper creates for the one attached here
+		std::shared_ptr<DeviceBus> wrap(const DeviceWrapper& wrapper) const;
+
+		//connects all devices to the event scheduler and the memory of a MiMa
+		void connect(EventScheduler& scheduler, MiMaMemory& memory);
+
+		//flushes the buffered host I/O of all devices
+		void flush();
+	};
+}
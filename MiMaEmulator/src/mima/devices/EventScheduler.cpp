@@ -0,0 +1,32 @@
+#include "mimapch.h"
+#include "EventScheduler.h"
+
+
+namespace MiMa {
+	void EventScheduler::schedule(const uint64_t& cycle, const ScheduledAction& action) {
+		events.push_back({ cycle, nextSequence++, action });
+		std::push_heap(events.begin(), events.end());
+
+		nextEventCycle = events.front().cycle;
+	}
+
+
+	void EventScheduler::run(const uint64_t& cycle) {
+		while (!events.empty() && events.front().cycle <= cycle) {
+			//take the event off the heap first, its action may schedule new events
+			std::pop_heap(events.begin(), events.end());
+			ScheduledAction action = std::move(events.back().action);
+			events.pop_back();
+
+			action(cycle);
+		}
+
+		nextEventCycle = events.empty() ? NO_EVENT : events.front().cycle;
+	}
+
+
+	void EventScheduler::clear() {
+		events.clear();
+		nextEventCycle = NO_EVENT;
+	}
+}
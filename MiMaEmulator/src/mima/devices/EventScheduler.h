@@ -0,0 +1,57 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+
+namespace MiMa {
+	typedef std::function<void(const uint64_t&)> ScheduledAction;
+
+
+	// ------------------------------------------------
+	// Event scheduler
+	//
+	// Keeps the future events of timed devices in a
+	// binary heap ordered by the clock cycle they are
+	// due in, so the emulation only has to compare its
+	// cycle count against the cycle of the earliest
+	// event instead of polling every device. Events
+	// due in the same cycle run in scheduling order.
+	// ------------------------------------------------
+
+	class EventScheduler {
+	public:
+		static constexpr uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max();
+
+	private:
+		struct Event {
+			uint64_t cycle;
+			uint64_t sequence;
+			ScheduledAction action;
+
+			//orders the heap so the earliest (and first scheduled) event is on top
+			inline bool operator<(const Event& other) const { return cycle != other.cycle ? cycle > other.cycle : sequence > other.sequence; }
+		};
+
+	private:
+		std::vector<Event> events;
+		uint64_t nextSequence = 0;
+		uint64_t nextEventCycle = NO_EVENT;
+
+	public:
+		//the action is run with the current cycle at the start of the given cycle, or the next emulated one if it already passed
+		void schedule(const uint64_t& cycle, const ScheduledAction& action);
+
+		//runs all events due up to the given cycle, including the ones scheduled by them
+		void run(const uint64_t& cycle);
+
+		//drops all pending events
+		void clear();
+
+		inline uint64_t getNextEventCycle() const { return nextEventCycle; }
+		inline size_t getPendingEventCount() const { return events.size(); }
+	};
+}
@@ -0,0 +1,208 @@
+#include "mimapch.h"
+#include "StandardDevices.h"
+
+//std library
+#include <stdexcept>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//internal classes
+#include "mima/mimaprogram/MiMaMemory.h"
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+	// --- ConsoleOutputDevice ---
+
+	ConsoleOutputDevice::ConsoleOutputDevice(std::ostream& output) : output(output) {
+		buffer.reserve(BUFFER_SIZE);
+	}
+
+	void ConsoleOutputDevice::write(const size_t& offset, const uint32_t& data, const uint64_t&) {
+		if (offset == 0) {
+			buffer.push_back((char)(data & 0xFF));
+		}
+		else {
+			//print the word as a signed 24 bit number
+			int32_t number = (data & 0x800000) ? (int32_t)data - 0x1000000 : (int32_t)data;
+			fmt::format_to(std::back_inserter(buffer), "{}\n", number);
+		}
+
+		if (buffer.size() >= BUFFER_SIZE) {
+			output.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+
+	void ConsoleOutputDevice::flush() {
+		if (!buffer.empty()) {
+			output.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+		output.flush();
+	}
+
+
+
+	// --- InputStreamDevice ---
+
+	InputStreamDevice::InputStreamDevice(const std::string& fileName, const uint64_t& deliveryLatency) : input(fileName, std::ios::binary), buffer(BUFFER_SIZE), deliveryLatency(deliveryLatency) {
+		if (!input) {
+			MIMA_LOG_ERROR("Failed to open input file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to open input file '{}'", fileName));
+		}
+	}
+
+	uint32_t InputStreamDevice::readByte() {
+		if (position == size) {
+			input.read(buffer.data(), buffer.size());
+			size = (size_t)input.gcount();
+			position = 0;
+
+			if (size == 0) {
+				return END_OF_INPUT;
+			}
+		}
+
+		return (uint8_t)buffer[position++];
+	}
+
+	void InputStreamDevice::deliver(const uint64_t& cycle) {
+		delivered = false;
+		scheduler->schedule(cycle + deliveryLatency, [this](const uint64_t&) { delivered = true; });
+	}
+
+	uint32_t InputStreamDevice::read(const size_t&, const uint64_t& cycle) {
+		if (!delivered) {
+			return NOT_READY;
+		}
+
+		uint32_t data = readByte();
+		//the end of the input stays readable
+		if (deliveryLatency != 0 && data != END_OF_INPUT) {
+			deliver(cycle);
+		}
+		return data;
+	}
+
+	void InputStreamDevice::connect(EventScheduler& scheduler, MiMaMemory&) {
+		//rewind, so a reset MiMa reads the same input again
+		input.clear();
+		input.seekg(0);
+		position = 0;
+		size = 0;
+
+		this->scheduler = &scheduler;
+		delivered = true;
+		if (deliveryLatency != 0) {
+			deliver(0);
+		}
+	}
+
+
+
+	// --- TimerDevice ---
+
+	void TimerDevice::arm(const uint64_t& cycle) {
+		scheduler->schedule(cycle, [this, cycle, armed = generation](const uint64_t&) {
+			if (armed != generation) {
+				return;
+			}
+
+			ticks = (ticks + 1) & 0xFFFFFF;
+			arm(cycle + interval);
+		});
+	}
+
+	void TimerDevice::write(const size_t&, const uint32_t& data, const uint64_t& cycle) {
+		interval = data;
+		ticks = 0;
+		generation++;
+
+		if (interval != 0 && scheduler != nullptr) {
+			arm(cycle + interval);
+		}
+	}
+
+	void TimerDevice::connect(EventScheduler& scheduler, MiMaMemory&) {
+		this->scheduler = &scheduler;
+		interval = 0;
+		ticks = 0;
+		generation++;
+	}
+
+
+
+	// --- BulkCopyDevice ---
+
+	uint32_t BulkCopyDevice::read(const size_t& offset, const uint64_t&) {
+		switch (offset) {
+		case 0:
+			return source;
+		case 1:
+			return destination;
+		default:
+			return remaining;
+		}
+	}
+
+	void BulkCopyDevice::write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) {
+		if (offset == 0) {
+			source = data;
+			return;
+		}
+		if (offset == 1) {
+			destination = data;
+			return;
+		}
+
+		remaining = data;
+		generation++;
+		if (remaining == 0 || memory == nullptr) {
+			remaining = 0;
+			return;
+		}
+
+		//the addresses are taken when the copy starts, later stores only prepare the next copy
+		scheduler->schedule(cycle + remaining * CYCLES_PER_CELL, [this, from = source, to = destination, count = remaining, started = generation](const uint64_t&) {
+			if (started != generation) {
+				return;
+			}
+
+			for (uint32_t i = 0; i < count; ++i) {
+				memory->store(to + i, memory->get(from + i).data);
+			}
+			remaining = 0;
+		});
+	}
+
+	void BulkCopyDevice::connect(EventScheduler& scheduler, MiMaMemory& memory) {
+		this->scheduler = &scheduler;
+		this->memory = &memory;
+		source = 0;
+		destination = 0;
+		remaining = 0;
+		generation++;
+	}
+
+
+
+	// --- standard bus ---
+
+	std::shared_ptr<DeviceBus> createStandardDeviceBus(std::ostream& output, const std::string& inputFileName, const uint64_t& inputLatency) {
+		std::shared_ptr<DeviceBus> bus = std::make_shared<DeviceBus>();
+
+		bus->attach(ConsoleOutputDevice::DEFAULT_ADDRESS, ConsoleOutputDevice::DEFAULT_ADDRESS + ConsoleOutputDevice::PORT_COUNT, std::make_shared<ConsoleOutputDevice>(output));
+		if (!inputFileName.empty()) {
+			bus->attach(InputStreamDevice::DEFAULT_ADDRESS, InputStreamDevice::DEFAULT_ADDRESS + InputStreamDevice::PORT_COUNT, std::make_shared<InputStreamDevice>(inputFileName, inputLatency));
+		}
+		bus->attach(CycleCounterDevice::DEFAULT_ADDRESS, CycleCounterDevice::DEFAULT_ADDRESS + CycleCounterDevice::PORT_COUNT, std::make_shared<CycleCounterDevice>());
+		bus->attach(TimerDevice::DEFAULT_ADDRESS, TimerDevice::DEFAULT_ADDRESS + TimerDevice::PORT_COUNT, std::make_shared<TimerDevice>());
+		bus->attach(BulkCopyDevice::DEFAULT_ADDRESS, BulkCopyDevice::DEFAULT_ADDRESS + BulkCopyDevice::PORT_COUNT, std::make_shared<BulkCopyDevice>());
+
+		return bus;
+	}
+}
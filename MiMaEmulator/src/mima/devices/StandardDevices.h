@@ -0,0 +1,195 @@
+#pragma once
+
+//std library
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//internal classes
+#include "Device.h"
+#include "DeviceBus.h"
+
+
+namespace MiMa {
+	// ------------------------------------------------
+	// Console output device
+	//
+	// Two write only ports: the first prints the lowest
+	// byte of every stored cell as a character, the
+	// second prints the cell as a decimal number on its
+	// own line. Output is collected and only written to
+	// the host stream once the buffer is full or on a
+	// flush.
+	// ------------------------------------------------
+
+	class ConsoleOutputDevice : public Device {
+	public:
+		static constexpr size_t DEFAULT_ADDRESS = 0xFFFF0;
+		static constexpr size_t PORT_COUNT = 2;
+		static constexpr size_t BUFFER_SIZE = 0x10000;
+
+	private:
+		std::ostream& output;
+		std::string buffer;
+
+	public:
+		ConsoleOutputDevice(std::ostream& output);
+		~ConsoleOutputDevice() { flush(); }
+
+		uint32_t read(const size_t&, const uint64_t&) override { return 0; }
+		void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) override;
+
+		void flush() override;
+	};
+
+
+
+	// ------------------------------------------------
+	// Input stream device
+	//
+	// A single read only port returning the next byte
+	// of a host file on every load, or END_OF_INPUT
+	// once the file is exhausted. The file is read in
+	// chunks of BUFFER_SIZE bytes and starts over from
+	// its beginning whenever the MiMa is reset.
+	//
+	// With a delivery latency, every byte arrives that
+	// many cycles after the previous one was loaded
+	// (the first one after the start) like on a slow
+	// serial line, loads before read NOT_READY.
+	// ------------------------------------------------
+
+	class InputStreamDevice : public Device {
+	public:
+		static constexpr size_t DEFAULT_ADDRESS = 0xFFFF2;
+		static constexpr size_t PORT_COUNT = 1;
+		static constexpr size_t BUFFER_SIZE = 0x10000;
+		static constexpr uint32_t END_OF_INPUT = 0xFFFFFF; //-1 as a 24 bit MiMa word
+		static constexpr uint32_t NOT_READY = 0xFFFFFE; //-2 as a 24 bit MiMa word
+
+	private:
+		std::ifstream input;
+		std::vector<char> buffer;
+		size_t position = 0;
+		size_t size = 0;
+
+		EventScheduler* scheduler = nullptr;
+		uint64_t deliveryLatency;
+		bool delivered = true;
+
+		uint32_t readByte();
+		void deliver(const uint64_t& cycle);
+
+	public:
+		InputStreamDevice(const std::string& fileName, const uint64_t& deliveryLatency = 0);
+
+		uint32_t read(const size_t& offset, const uint64_t& cycle) override;
+		void write(const size_t&, const uint32_t&, const uint64_t&) override {}
+
+		void connect(EventScheduler& scheduler, MiMaMemory& memory) override;
+	};
+
+
+
+	// ------------------------------------------------
+	// Cycle counter device
+	//
+	// A single port reading the clock cycles passed
+	// since the last store to it (or since the start),
+	// truncated to a MiMa word.
+	// ------------------------------------------------
+
+	class CycleCounterDevice : public Device {
+	public:
+		static constexpr size_t DEFAULT_ADDRESS = 0xFFFF3;
+		static constexpr size_t PORT_COUNT = 1;
+
+	private:
+		uint64_t startCycle = 0;
+
+	public:
+		uint32_t read(const size_t&, const uint64_t& cycle) override { return (uint32_t)((cycle - startCycle) & 0xFFFFFF); }
+		void write(const size_t&, const uint32_t&, const uint64_t& cycle) override { startCycle = cycle; }
+
+		void connect(EventScheduler&, MiMaMemory&) override { startCycle = 0; }
+	};
+
+
+
+	// ------------------------------------------------
+	// Timer device
+	//
+	// A single port arming a periodic timer with the
+	// stored cell as its interval in clock cycles (0
+	// disarms it). Loads read the number of periods
+	// passed since it was armed. Periods are counted
+	// by scheduled events, not on every clock cycle.
+	// ------------------------------------------------
+
+	class TimerDevice : public Device {
+	public:
+		static constexpr size_t DEFAULT_ADDRESS = 0xFFFF4;
+		static constexpr size_t PORT_COUNT = 1;
+
+	private:
+		EventScheduler* scheduler = nullptr;
+		uint32_t interval = 0;
+		uint32_t ticks = 0;
+		uint64_t generation = 0; //invalidates the pending event of a previous arming
+
+		void arm(const uint64_t& cycle);
+
+	public:
+		uint32_t read(const size_t&, const uint64_t&) override { return ticks; }
+		void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) override;
+
+		void connect(EventScheduler& scheduler, MiMaMemory& memory) override;
+	};
+
+
+
+	// ------------------------------------------------
+	// Bulk copy device
+	//
+	// Copies ranges of the main memory without the
+	// MiMa, like a DMA controller. The first two ports
+	// take the source and destination address, storing
+	// a count to the third one starts copying that many
+	// cells, which takes CYCLES_PER_CELL cycles each.
+	// The copy is done in a single scheduled event when
+	// the time is up: until then loads of the third
+	// port read the count, afterwards 0. Cells are
+	// copied in ascending order, starting a copy while
+	// another one is running cancels the running one.
+	// ------------------------------------------------
+
+	class BulkCopyDevice : public Device {
+	public:
+		static constexpr size_t DEFAULT_ADDRESS = 0xFFFF5;
+		static constexpr size_t PORT_COUNT = 3;
+		static constexpr uint64_t CYCLES_PER_CELL = 1;
+
+	private:
+		EventScheduler* scheduler = nullptr;
+		MiMaMemory* memory = nullptr;
+		uint32_t source = 0;
+		uint32_t destination = 0;
+		uint32_t remaining = 0;
+		uint64_t generation = 0; //invalidates the pending event of a cancelled copy
+
+	public:
+		uint32_t read(const size_t& offset, const uint64_t& cycle) override;
+		void write(const size_t& offset, const uint32_t& data, const uint64_t& cycle) override;
+
+		void connect(EventScheduler& scheduler, MiMaMemory& memory) override;
+	};
+
+
+
+	//creates a bus with a console output device on the given stream, a cycle counter, a timer, a bulk copy device and, for a non empty file name, an input stream device delivering its bytes with the given latency, all at their default addresses
+	std::shared_ptr<DeviceBus> createStandardDeviceBus(std::ostream& output, const std::string& inputFileName = "", const uint64_t& inputLatency = 0);
+}
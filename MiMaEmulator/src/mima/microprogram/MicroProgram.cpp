@@ -7,33 +7,12 @@ namespace MiMa {
 	// Microprogram code list
 	// ----------------------
 
-	// --- List nodes ---
-
-	MicroProgramCodeNode::MicroProgramCodeNode(const size_t& upperConditionLimit, MicroProgramCodeNode* next, MicroProgramCode code) :
-		next(next),
-		code(code),
-		upperConditionLimit(upperConditionLimit)
-	{}
-
-	MicroProgramCodeNode::~MicroProgramCodeNode() {
-		//the nodes of the singly linked list recursively delete the next one
-		if (next != nullptr) delete next;
-	}
-
-
-	// --- List class ---
-
 	MicroProgramCodeList::MicroProgramCodeList(const std::string& conditionName, const size_t& conditionMax) :
+		intervals(1, { conditionMax, MicroProgramCode() }),
 		conditionName(conditionName),
-		conditionMax(conditionMax),
-		head(new MicroProgramCodeNode(conditionMax))
+		conditionMax(conditionMax)
 	{}
 
-	MicroProgramCodeList::~MicroProgramCodeList() {
-		//delete the head node, which results in recursive deletion of all nodes
-		delete head;
-	}
-
 
 	void MicroProgramCodeList::reset() {
 		//default: reset the list to a single code with no condition
@@ -45,74 +24,48 @@ namespace MiMa {
 		this->conditionName = conditionName;
 		this->conditionMax = conditionMax;
 
-		//delete and reset list head
-		delete head;
-		head = new MicroProgramCodeNode(conditionMax);
+		//reset to a single interval covering the whole condition range
+		intervals.assign(1, { conditionMax, MicroProgramCode() });
 	}
 
 
-	void MicroProgramCodeList::apply(const std::function<void(MicroProgramCode&)>& func, const size_t& lowerLimit, size_t upperLimit) {
-		upperLimit = std::min(upperLimit, conditionMax);
-		if (lowerLimit > upperLimit) {
-			return;
-		}
-
-		MicroProgramCodeNode* prev = nullptr;
-		MicroProgramCodeNode* current = head;
+	size_t MicroProgramCodeList::split(const size_t& limit) {
+		//find the first interval which has an upper limit equal or above the given limit
+		std::vector<MicroProgramCodeInterval>::iterator containing = std::lower_bound(intervals.begin(), intervals.end(), limit,
+			[](const MicroProgramCodeInterval& interval, const size_t& limit) { return interval.upperConditionLimit < limit; });
 
-		//find the first node which is affected by the application of the microprogram code function,
-		//i.e. the first node which has an upper limit equal or above the lower limit of the effect
-		//=> the previous node has an upper limit equal or below the lower limit
-		while (current->upperConditionLimit < lowerLimit) {
-			prev = current;
-			current = current->next;
+		//if it doesn't end at the given limit, split off its lower part with a copy of its code
+		if (containing->upperConditionLimit != limit) {
+			containing = intervals.insert(containing, { limit, containing->code });
 		}
 
-		//in case the previous node has an upper limit below the lower limit
-		if (prev == nullptr) {
-			if (lowerLimit != 0) {
-				size_t limitingNodeLimit = lowerLimit - 1;
+		return containing - intervals.begin();
+	}
 
-				head = new MicroProgramCodeNode(limitingNodeLimit, head, head->code);
-				prev = head;
-			}
-		}
-		else {
-			if (prev->upperConditionLimit + 1 != lowerLimit) {
-				size_t limitingNodeLimit = lowerLimit - 1;
+	void MicroProgramCodeList::coalesce(size_t first, size_t last) {
+		last = std::min(last, intervals.size() - 1);
 
-				prev->next = new MicroProgramCodeNode(limitingNodeLimit, current, current->code);
-				prev = prev->next;
+		//shift all intervals which differ from their upper neighbour down, dropping the others
+		size_t kept = first;
+		for (size_t i = first; i <= last; ++i) {
+			if (i < last && intervals[i].code == intervals[i + 1].code) {
+				continue;
 			}
-		}
 
-		//apply function to all nodes with an upper limit under the given upper limit
-		while (current->upperConditionLimit < upperLimit) {
-			func(current->code);
-
-			prev = current;
-			current = current->next;
+			intervals[kept++] = intervals[i];
 		}
 
-		//if there is a node matching the given upper limit, apply the function to it as well and return
-		if (current->upperConditionLimit == upperLimit) {
-			func(current->code);
-			return;
-		}
+		//remove the gap left behind by the dropped intervals in one go
+		intervals.erase(intervals.begin() + kept, intervals.begin() + last + 1);
+	}
 
-		//if there is no node matching the given upper limit, create one and apply the function to it as well
-		MicroProgramCodeNode* upperLimitNode = new MicroProgramCodeNode(upperLimit, current, current->code);
 
-		if (prev == nullptr) {
-			head = upperLimitNode;
-		}
-		else {
-			prev->next = upperLimitNode;
+	MicroProgramCode MicroProgramCodeList::get(const StatusBitMap& statusBits) const {
+		//unconditional microprogram code doesn't need to look up its condition
+		if (intervals.size() == 1) {
+			return intervals.front().code;
 		}
-		func(upperLimitNode->code);
-	}
 
-	MicroProgramCode MicroProgramCodeList::get(const StatusBitMap& statusBits) const {
 		//find the value of the given condition
 		//if it is not in the map, it defaults to zero
 		StatusBitMap::const_iterator conditionLocation = statusBits.find(conditionName);
@@ -122,12 +75,8 @@ namespace MiMa {
 			condition = std::min(conditionLocation->second, conditionMax);
 		}
 
-		//return microprogram code dependent on the condition value
-		MicroProgramCodeNode* current = head;
-		while (current->upperConditionLimit < condition) {
-			current = current->next;
-		}
-
-		return current->code;
+		//return microprogram code of the interval containing the condition value
+		return std::lower_bound(intervals.begin(), intervals.end(), condition,
+			[](const MicroProgramCodeInterval& interval, const size_t& condition) { return interval.upperConditionLimit < condition; })->code;
 	}
 }
@@ -7,6 +7,7 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 //external vendor libraries
 #include <fmt/format.h>
@@ -35,6 +36,7 @@ namespace MiMa {
 
 	class MicroProgramCode {
 		friend struct fmt::formatter<MiMa::MicroProgramCode>;
+		friend class MicroProgramOptimizer;
 
 	private:
 		static const uint32_t JUMP_MASK = 0xFF;
@@ -88,6 +90,9 @@ namespace MiMa {
 
 		//does nothing
 		inline void pass() {}
+
+		inline bool operator==(const MicroProgramCode& other) const { return bits == other.bits; }
+		inline bool operator!=(const MicroProgramCode& other) const { return bits != other.bits; }
 	};
 
 	typedef void(MicroProgramCode::* MicroProgramCodeSetFunction)();
@@ -95,66 +100,60 @@ namespace MiMa {
 	
 
 
-	// ------------------------------------
-	// Singly linked microprogram code list
+	// ---------------------------------------
+	// Conditional microprogram code list
 	// 
 	// A conditional line of microprogram
-	// code, represented using a singly
-	// linked, non-circular list.
-	// ------------------------------------
-
-	// --- Nodes of the singly linked list ---
-
-	class MicroProgramCodeNode {
-		friend class MicroProgramCodeList;
-		friend struct fmt::formatter<MiMa::MicroProgramCodeList>;
+	// code, represented as a flat interval
+	// map sorted by the upper condition
+	// limit of each interval.
+	// ---------------------------------------
 
-	private:
-		//next node in the singly linked list (nullptr if this is the last element)
-		MicroProgramCodeNode* next;
+	// --- Intervals of the interval map ---
 
-		//contents of this node (lowerLimit is implicitly the upperLimit + 1 of the previous node, or 0 if this is the head node)
+	struct MicroProgramCodeInterval {
+		//lowerLimit is implicitly the upperLimit + 1 of the previous interval, or 0 if this is the first interval
 		size_t upperConditionLimit;
 		MicroProgramCode code;
-
-		//private constructor so only MicroProgramCodeLists can create instances
-		MicroProgramCodeNode(const size_t& upperConditionLimit, MicroProgramCodeNode* next = nullptr, MicroProgramCode code = MicroProgramCode());
-
-	public:
-		~MicroProgramCodeNode();
 	};
 
 
-	// --- Singly linked list representation ---
+	// --- Interval map representation ---
 
 	class MicroProgramCodeList {
 		friend struct fmt::formatter<MiMa::MicroProgramCodeList>;
+		friend class MicroProgramOptimizer;
 	private:
-		MicroProgramCodeNode* head;
+		//the intervals covering [0, conditionMax], never empty
+		std::vector<MicroProgramCodeInterval> intervals;
 
 		std::string conditionName;
 		size_t conditionMax;
 
+	private:
+		//makes sure an interval ends at the given limit, returns the index of that interval
+		size_t split(const size_t& limit);
+		//merges neighbouring intervals with equal code in the given index range
+		void coalesce(size_t first, size_t last);
+
 	public:
 		MicroProgramCodeList(const std::string& conditionName = "", const size_t& conditionMax = 0);
-		~MicroProgramCodeList();
 
 		void reset();
 		void reset(const std::string& conditionName, const size_t& conditionMax);
 
 
-		inline void apply(const std::function<void(MicroProgramCode&)>& func) { apply(func, 0, conditionMax); }
-		void apply(const std::function<void(MicroProgramCode&)>& func, const size_t& lowerLimit, size_t upperLimit);
-
-		inline void apply(const MicroProgramCodeSetFunction& func, const size_t& lowerLimit, size_t upperLimit) {
-			apply([func](MicroProgramCode& microProgramCode) { std::invoke(func, microProgramCode); }, lowerLimit, upperLimit);
-		}
+		//apply a modifier (any callable, including MicroProgramCode member functions) to all code in a condition range
+		template<typename Modifier>
+		inline void apply(const Modifier& func) { apply(func, 0, conditionMax); }
+		template<typename Modifier>
+		void apply(const Modifier& func, const size_t& lowerLimit, size_t upperLimit);
 
 		inline void apply(const MicroProgramCodeSet8BitFunction& func, const uint8_t& value) {
-			apply([func, value](MicroProgramCode& microProgramCode) { std::invoke(std::bind(func, std::placeholders::_1, value), microProgramCode); }, 0, conditionMax);
+			apply(func, value, 0, conditionMax);
 		}
 		inline void apply(const MicroProgramCodeSet8BitFunction& func, const uint8_t& value, const size_t& lowerLimit, const size_t& upperLimit) {
-			apply([func, value](MicroProgramCode& microProgramCode) { std::invoke(std::bind(func, std::placeholders::_1, value), microProgramCode); }, lowerLimit, upperLimit);
+			apply([func, value](MicroProgramCode& microProgramCode) { (microProgramCode.*func)(value); }, lowerLimit, upperLimit);
 		}
 
 
@@ -162,6 +161,27 @@ namespace MiMa {
 	};
 
 
+	template<typename Modifier>
+	void MicroProgramCodeList::apply(const Modifier& func, const size_t& lowerLimit, size_t upperLimit) {
+		upperLimit = std::min(upperLimit, conditionMax);
+		if (lowerLimit > upperLimit) {
+			return;
+		}
+
+		//split the intervals so that the affected range starts and ends on interval borders
+		size_t first = (lowerLimit == 0) ? 0 : split(lowerLimit - 1) + 1;
+		size_t last = split(upperLimit);
+
+		//apply function to all intervals in the range at once
+		for (size_t i = first; i <= last; ++i) {
+			std::invoke(func, intervals[i].code);
+		}
+
+		//the modified range might now equal its neighbours, including the ones just split off
+		coalesce(first == 0 ? 0 : first - 1, last + 1);
+	}
+
+
 
 	// ------------------------------------------------
 	// A microprogram that can run on a minimal machine
@@ -201,28 +221,23 @@ struct fmt::formatter<MiMa::MicroProgramCodeList> {
 	template<typename FormatContext>
 	auto format(const MiMa::MicroProgramCodeList& codeList, FormatContext& ctx) {
 		if (codeList.conditionMax == 0) {
-			return fmt::format_to(ctx.out(), "Unconditional microcode: {}", codeList.head->code);
+			return fmt::format_to(ctx.out(), "Unconditional microcode: {}", codeList.intervals.front().code);
 		}
 
-		//if the microprogram code list has only one element, print it in one line
-		if (codeList.head->upperConditionLimit == codeList.conditionMax) {
-			return fmt::format_to(ctx.out(), "Conditional microcode for {} up to max 0x{:X}: {}", codeList.conditionName, codeList.conditionMax, codeList.head->code);
+		//if the microprogram code list has only one interval, print it in one line
+		if (codeList.intervals.size() == 1) {
+			return fmt::format_to(ctx.out(), "Conditional microcode for {} up to max 0x{:X}: {}", codeList.conditionName, codeList.conditionMax, codeList.intervals.front().code);
 		}
 
 
-		//otherwise, format each node into a separate line
-		std::string listOutput = fmt::format("Conditional microcode for {} up to max 0x{:X}:\n{{}}", codeList.conditionName, codeList.conditionMax);
-		std::string nodeFormat = "up to 0x{:X}: {}\n{{}}";
-
-		MiMa::MicroProgramCodeNode* current = codeList.head;
-		while (current != nullptr) {
-			std::string node = fmt::format(nodeFormat, current->upperConditionLimit, current->code);
-			listOutput = fmt::format(listOutput, node);
+		//otherwise, format each interval into a separate line
+		auto out = fmt::format_to(ctx.out(), "Conditional microcode for {} up to max 0x{:X}:\n", codeList.conditionName, codeList.conditionMax);
 
-			current = current->next;
+		for (const MiMa::MicroProgramCodeInterval& interval : codeList.intervals) {
+			out = fmt::format_to(out, "up to 0x{:X}: {}\n", interval.upperConditionLimit, interval.code);
 		}
 
-		return fmt::format_to(ctx.out(), listOutput, "");
+		return out;
 	}
 };
 
@@ -240,7 +255,7 @@ public:
 		auto it = ctx.begin();
 		auto end = ctx.end();
 
-		if (it == end && *it == '}') {
+		if (it == end || *it == '}') {
 			return it;
 		}
 
@@ -290,13 +305,11 @@ public:
 			return fmt::format_to(ctx.out(), "at 0x{:X}: {}", lowerLimit, program.memory[lowerLimit]);
 		}
 
-		std::string listOutput = "\n{}";
-		std::string nodeFormat = "at 0x{:X}: {}\n{{}}";
+		auto out = fmt::format_to(ctx.out(), "\n");
 		for (size_t i = lowerLimit; i < upperLimit; ++i) {
-			std::string node = fmt::format(nodeFormat, i, program.memory[i]);
-			listOutput = fmt::format(listOutput, node);
+			out = fmt::format_to(out, "at 0x{:X}: {}\n", i, program.memory[i]);
 		}
 
-		return fmt::format_to(ctx.out(), listOutput, "");
+		return out;
 	}
 };
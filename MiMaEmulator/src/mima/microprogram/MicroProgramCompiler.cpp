@@ -1,6 +1,10 @@
 #include "mimapch.h"
 #include "MicroProgramCompiler.h"
 
+//std library
+#include <algorithm>
+#include <limits>
+
 //internal classes
 #include "mima/CompilerException.h"
 #include "StatusBit.h"
@@ -39,186 +43,138 @@ namespace MiMa {
 	constexpr char char_COMPILER_DIRECTIVE = '!';
 
 	//Utility: ALU codes
-	uint32_t getALUCode(const std::string& input) {
-		if (input == "RETURN")
-			return 0;
-		if (input == "ADD")
-			return 1;
-		if (input == "RAR")
-			return 2;
-		if (input == "AND")
-			return 3;
-		if (input == "OR")
-			return 4;
-		if (input == "XOR")
-			return 5;
-		if (input == "NOT")
-			return 6;
-		if (input == "EQL")
-			return 7;
+	uint32_t getALUCode(const std::string_view& input) {
+		static const std::unordered_map<std::string_view, uint32_t> aluCodes = {
+			{ "RETURN", 0 },
+			{ "ADD", 1 },
+			{ "RAR", 2 },
+			{ "AND", 3 },
+			{ "OR", 4 },
+			{ "XOR", 5 },
+			{ "NOT", 6 },
+			{ "EQL", 7 }
+		};
+
+		std::unordered_map<std::string_view, uint32_t>::const_iterator aluCode = aluCodes.find(input);
+		if (aluCode != aluCodes.end())
+			return aluCode->second;
 
 		throw CompilerException(fmt::format("unknown ALU state '{}'", input));
 	}
 
 
 	//Utility: convert register write identifiers to corresponding control bits
-	MicroProgramCodeSetFunction getWriteBit(const std::string& identifier) {
-		if (identifier == "SDR")
-			return &MicroProgramCode::setStorageDataRegisterWriting;
-		if (identifier == "IR")
-			return &MicroProgramCode::setInstructionRegisterWriting;
-		if (identifier == "IAR")
-			return &MicroProgramCode::setInstructionAddressRegisterWriting;
-		if (identifier == "ONE")
-			return &MicroProgramCode::setConstantOneWriting;
-		if (identifier == "Z")
-			return &MicroProgramCode::setALUResultWriting;
-		if (identifier == "ACCU")
-			return &MicroProgramCode::setAccumulatorRegisterWriting;
+	MicroProgramCodeSetFunction getWriteBit(const std::string_view& identifier) {
+		static const std::unordered_map<std::string_view, MicroProgramCodeSetFunction> writeBits = {
+			{ "SDR", &MicroProgramCode::setStorageDataRegisterWriting },
+			{ "IR", &MicroProgramCode::setInstructionRegisterWriting },
+			{ "IAR", &MicroProgramCode::setInstructionAddressRegisterWriting },
+			{ "ONE", &MicroProgramCode::setConstantOneWriting },
+			{ "Z", &MicroProgramCode::setALUResultWriting },
+			{ "ACCU", &MicroProgramCode::setAccumulatorRegisterWriting }
+		};
+
+		std::unordered_map<std::string_view, MicroProgramCodeSetFunction>::const_iterator writeBit = writeBits.find(identifier);
+		if (writeBit != writeBits.end())
+			return writeBit->second;
 
 		throw CompilerException(fmt::format("unknown writing register '{}'", identifier));
 	}
 
 	//Utility: convert register read identifiers to corresponding control bits
-	MicroProgramCodeSetFunction getReadBit(const std::string& identifier) {
-		if (identifier == "SAR")
-			return &MicroProgramCode::setStorageAddressRegisterReading;
-		if (identifier == "SDR")
-			return &MicroProgramCode::setStorageDataRegisterReading;
-		if (identifier == "IR")
-			return &MicroProgramCode::setInstructionRegisterReading;
-		if (identifier == "IAR")
-			return &MicroProgramCode::setInstructionAddressRegisterReading;
-		if (identifier == "X")
-			return &MicroProgramCode::setLeftALUOperandReading;
-		if (identifier == "Y")
-			return &MicroProgramCode::setRightALUOperandReading;
-		if (identifier == "ACCU")
-			return &MicroProgramCode::setAccumulatorRegisterReading;
+	MicroProgramCodeSetFunction getReadBit(const std::string_view& identifier) {
+		static const std::unordered_map<std::string_view, MicroProgramCodeSetFunction> readBits = {
+			{ "SAR", &MicroProgramCode::setStorageAddressRegisterReading },
+			{ "SDR", &MicroProgramCode::setStorageDataRegisterReading },
+			{ "IR", &MicroProgramCode::setInstructionRegisterReading },
+			{ "IAR", &MicroProgramCode::setInstructionAddressRegisterReading },
+			{ "X", &MicroProgramCode::setLeftALUOperandReading },
+			{ "Y", &MicroProgramCode::setRightALUOperandReading },
+			{ "ACCU", &MicroProgramCode::setAccumulatorRegisterReading }
+		};
+
+		std::unordered_map<std::string_view, MicroProgramCodeSetFunction>::const_iterator readBit = readBits.find(identifier);
+		if (readBit != readBits.end())
+			return readBit->second;
 
 		throw CompilerException(fmt::format("unknown reading register '{}'", identifier));
 	}
 
+	//Utility: convert the right operand of a storage access assignment (R = 1, W = 0, ...) to the corresponding setter
+	MicroProgramCodeSetFunction getStorageAccessSetter(const std::string_view& value, const MicroProgramCodeSetFunction& enable, const MicroProgramCodeSetFunction& disable) {
+		if (value == "1")
+			return enable;
+		if (value == "0")
+			return disable;
+
+		throw CompilerException(fmt::format("storage access can only be set to 0 or 1, found '{}'", value));
+	}
+
 
 
 	// ------------------------------
 	// Compile mode utility functions
 	// ------------------------------
 
-	// --- Constants definitions
-
-	const std::regex MicroProgramCompiler::CompileMode::emptyLinePattern(R"(\s*)");
-
-
 	// --- Functions ---
 
 	void MicroProgramCompiler::CompileMode::addLabel(std::string label) {
-		MIMA_LOG_TRACE("Found label '{}' at address 0x{:02X}", label, compiler.firstFree);
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Found label '{}' at address 0x{:02X}", label, compiler.firstFree);
 
-		//add the label to the list of found labels
-		if (compiler.labels.find(label) != compiler.labels.end()) {
-			MIMA_LOG_ERROR("Found duplicate of label '{}'", label);
+		//define the label, jumps to it which were found before are resolved once compilation finishes
+		Label& definition = compiler.labels[compiler.internLabel(label)];
+		if (definition.address != UNDEFINED_LABEL) {
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Found duplicate of label '{}'", label);
 			throw CompilerException(fmt::format("found duplicate of label '{}'", label));
 		}
-		compiler.labels.insert({ label, compiler.firstFree });
-
-		//call all listeners waiting for this label to be added
-		std::multimap<std::string, std::function<bool(const uint8_t&)>>::iterator labelAddListener = compiler.labelAddListeners.find(label);
-		std::multimap<std::string, std::function<bool(const uint8_t&)>>::iterator mapEnd = compiler.labelAddListeners.end();
-
-		//iterate over listeners
-		while (labelAddListener != mapEnd && labelAddListener->first == label) {
-			if ((labelAddListener->second)(compiler.firstFree)) {
-				//if calling the listener returns true, remove it from the listener list and move on to the next
-				labelAddListener = compiler.labelAddListeners.erase(labelAddListener++);
-			}
-			else {
-				//otherwise, just move on to the next
-				++labelAddListener;
-			}
-
-			MIMA_LOG_TRACE("Called listeners for label at 0x{:02X}", compiler.firstFree);
-		}
+		definition.address = compiler.firstFree;
+		definition.definitionIndex = compiler.definedLabels++;
 	}
 
 	void MicroProgramCompiler::CompileMode::addJump(std::string label, bool& fixedJump, MicroProgramCodeList& currentCode, bool overrideFixed) {
 		//confirm that this can jump instruction can be set
 		if (fixedJump && !overrideFixed) {
-			MIMA_LOG_WARN("Attempted to override fixed jump at position 0x{:02X}", compiler.firstFree);
+			MIMA_CHANNEL_LOG_WARN(MICROCOMPILER, "Attempted to override fixed jump at position 0x{:02X}", compiler.firstFree);
 			return;
 		}
-		MIMA_ASSERT_TRACE(!fixedJump, "Overriding fixed jump at 0x{:02X}", compiler.firstFree);
-
-		//find label location (ignoring the jump marker)
-		std::unordered_map<std::string, uint8_t>::iterator labelLocation = compiler.labels.find(label);
-
-		if (labelLocation != compiler.labels.end()) { //label found
-			MIMA_LOG_TRACE("Found microprogram jump instruction from 0x{:02X} to 0x{:02X}", compiler.firstFree, labelLocation->second);
-			currentCode.apply(&MicroProgramCode::setJump, labelLocation->second, 0, 0xFF);
-		}
-		else { //label not found, add this to unresolved references
-			MIMA_LOG_TRACE("Found unresolved microprogram jump from 0x{:02X}", compiler.firstFree);
+		MIMA_CHANNEL_ASSERT_TRACE(!fixedJump, MICROCOMPILER, "Overriding fixed jump at 0x{:02X}", compiler.firstFree);
 
-			//create a listener adding a jump once this label is found
-			uint8_t firstFreeCopy = compiler.firstFree;
-			std::shared_ptr<MicroProgramCodeList[]>& memoryReference = compiler.memory;
-
-			std::function<bool(const uint8_t&)> labelAddListener = [firstFreeCopy, memoryReference](const uint8_t& labelAddress) {
-				memoryReference[firstFreeCopy].apply(&MicroProgramCode::setJump, labelAddress, 0, 0xFF);
-				
-				return true;
-			};
-
-			//add the listener to the list of listeners
-			compiler.labelAddListeners.insert({ label, labelAddListener });
-		}
+		//jump across all conditions
+		addJump(label, currentCode, 0, std::numeric_limits<size_t>::max());
 
 		//mark this instruction as having a fixed jump location
 		fixedJump = true;
 	}
 
 	void MicroProgramCompiler::CompileMode::addJump(std::string label, MicroProgramCodeList& currentCode, const size_t& lowerLimit, const size_t& upperLimit) {
-		//find label location (ignoring the jump marker)
-		std::unordered_map<std::string, uint8_t>::iterator labelLocation = compiler.labels.find(label);
+		size_t labelId = compiler.internLabel(label);
+		uint16_t labelAddress = compiler.labels[labelId].address;
 
-		if (labelLocation != compiler.labels.end()) { //label found
-			MIMA_LOG_TRACE("Found microprogram jump instruction from 0x{:02X} to 0x{:02X} in range from 0x{:08X} to 0x{:08X}", compiler.firstFree, labelLocation->second, lowerLimit, upperLimit);
-			currentCode.apply(&MicroProgramCode::setJump, labelLocation->second, lowerLimit, upperLimit);
+		if (labelAddress != UNDEFINED_LABEL) { //label found
+			MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Found microprogram jump instruction from 0x{:02X} to 0x{:02X} in range from 0x{:08X} to 0x{:08X}", compiler.firstFree, labelAddress, lowerLimit, upperLimit);
+			currentCode.apply(&MicroProgramCode::setJump, (uint8_t)labelAddress, lowerLimit, upperLimit);
 		}
 		else { //label not found, add this to unresolved references
-			MIMA_LOG_TRACE("Found unresolved microprogram jump from 0x{:02X} for range from 0x{:08X} to 0x{:08X}", compiler.firstFree, lowerLimit, upperLimit);
-
-			//create a listener adding a jump once this label is found
-			uint8_t firstFreeCopy = compiler.firstFree;
-			std::shared_ptr<MicroProgramCodeList[]>& memoryReference = compiler.memory;
-
-			std::function<bool(const uint8_t&)> labelAddListener = [firstFreeCopy, memoryReference, lowerLimit, upperLimit](const uint8_t& labelAddress) {
-				memoryReference[firstFreeCopy].apply(&MicroProgramCode::setJump, labelAddress, lowerLimit, upperLimit);
-				MIMA_LOG_TRACE("Resolved label at 0x{:02X} to 0x{:02X} for range from 0x{:02X} to 0x{:02X}, current value: {}", firstFreeCopy, labelAddress, lowerLimit, upperLimit, memoryReference[firstFreeCopy]);
-
-				return true;
-			};
-
-			//add the listener to the list of listeners
-			compiler.labelAddListeners.insert({ label, labelAddListener });
+			MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Found unresolved microprogram jump from 0x{:02X} for range from 0x{:08X} to 0x{:08X}", compiler.firstFree, lowerLimit, upperLimit);
+			compiler.jumpFixups.push_back({ compiler.firstFree, lowerLimit, upperLimit, labelId });
 		}
 	}
 
 
 	void MicroProgramCompiler::CompileMode::endOfLine(MicroProgramCodeList& currentCode) {
-		MIMA_LOG_TRACE("Compiled at 0x{:02X}: microcode {}", compiler.firstFree, currentCode);
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Compiled at 0x{:02X}: microcode {}", compiler.firstFree, currentCode);
 
 		//increment location of the first free memory spot to write into
 		compiler.firstFree++;
 		compiler.firstFree %= 0x100;
-		MIMA_ASSERT_WARN(compiler.firstFree != 0, "Memory position overflow in compilation, continuing to compile at 0x00.");
+		MIMA_CHANNEL_ASSERT_WARN(compiler.firstFree != 0, MICROCOMPILER, "Memory position overflow in compilation, continuing to compile at 0x00.");
 	}
 
 	void MicroProgramCompiler::CompileMode::endOfLine(bool& fixedJump, MicroProgramCodeList& currentCode) {
 		//set jump to next if no fixed jump was given
 		if (!fixedJump) {
-			MIMA_LOG_TRACE("Setting automatic jump to next address 0x{:02X} for microprogram instruction {}", compiler.firstFree + 1, currentCode);
-			currentCode.apply(&MicroProgramCode::setJump, compiler.firstFree + 1, 0, 0xFF);
+			MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Setting automatic jump to next address 0x{:02X} for microprogram instruction {}", compiler.firstFree + 1, currentCode);
+			currentCode.apply(&MicroProgramCode::setJump, compiler.firstFree + 1);
 		}
 
 		//reset the fixedJump variable to false for the next line of code
@@ -240,16 +196,6 @@ namespace MiMa {
 	// Default (global) compile mode of the microprogram compiler
 	// ----------------------------------------------------------
 
-	// --- Constants definitions ---
-
-	const std::regex MicroProgramCompiler::DefaultCompileMode::labelMatcher(R"(\s*(.*?)\:(.*))");
-	const std::regex MicroProgramCompiler::DefaultCompileMode::instructionMatcher(R"((.*?);)");
-
-	const std::regex MicroProgramCompiler::DefaultCompileMode::registerTransferMatcher(R"(\s*(.*?)\s*\->\s*(.*?)\s*)");
-	const std::regex MicroProgramCompiler::DefaultCompileMode::assignmentMatcher(R"(\s*(.*?)\s*\=\s*(.*?)\s*)");
-	const std::regex MicroProgramCompiler::DefaultCompileMode::jumpMatcher(R"(\s*#(.*?)\s*)");
-
-
 	// --- Functions ---
 	
 	MicroProgramCompiler::DefaultCompileMode::DefaultCompileMode(MicroProgramCompiler& compiler) :
@@ -258,90 +204,108 @@ namespace MiMa {
 		//reset code memory where the program is written too
 		compiler.memory[compiler.firstFree].reset();
 
-		MIMA_LOG_TRACE("Opened default compiler mode");
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Opened default compiler mode");
 	}
 
-	void MicroProgramCompiler::DefaultCompileMode::addLine(const std::string& line) {
-		std::string codeLine = line;
-		std::smatch matches;
+	void MicroProgramCompiler::DefaultCompileMode::addLine(LineScanner& line) {
+		//a line may start with a label, which is a word followed by a colon
+		size_t lineStart = line.getPosition();
+		std::string_view label = line.readWord();
+
+		if (!label.empty() && line.consume(':')) {
+			CompileMode::addLabel(std::string(label));
+		}
+		else {
+			line.setPosition(lineStart);
+		}
 
-		if (std::regex_match(codeLine, matches, labelMatcher)) {
-			CompileMode::addLabel(matches[1]);
-			codeLine = matches[2];
+		//the rest of the line is a sequence of instructions, each terminated by a semicolon
+		while (!line.skipWhitespace()) {
+			addInstruction(line);
 		}
 
-		std::sregex_iterator instructionsStart(codeLine.begin(), codeLine.end(), instructionMatcher);
-		std::sregex_iterator instructionsEnd;
+		CompileMode::endOfLine(fixedJump, compiler.memory[compiler.firstFree]);
+	}
+
+	void MicroProgramCompiler::DefaultCompileMode::addInstruction(LineScanner& line) {
+		size_t instructionStart = line.getPosition();
+
+		//empty instruction
+		if (line.consume(';')) {
+			return;
+		}
 
-		for (std::sregex_iterator i = instructionsStart; i != instructionsEnd; ++i) {
-			std::string instruction = (*i)[1];
+		if (line.consume('#')) {
+			//jump to a label
+			std::string_view label = line.readWord();
 
-			if (std::regex_match(instruction, emptyLinePattern)) {
-				continue;
+			if (!label.empty() && line.consume(';')) {
+				CompileMode::addJump(std::string(label), fixedJump, compiler.memory[compiler.firstFree]);
+				return;
 			}
+		}
+		else {
+			std::string_view leftOperand = line.readWord();
 
-			if (std::regex_match(instruction, matches, registerTransferMatcher)) {
-				//get the read and write functions for the microprogram code modification
-				MicroProgramCodeSetFunction setWrite = getWriteBit(matches[1]);
-				MicroProgramCodeSetFunction setRead = getReadBit(matches[2]);
+			if (line.consume("->")) {
+				//register transfer, get the read and write functions for the microprogram code modification
+				std::string_view rightOperand = line.readWord();
 
-				//create a modifier executing both these functions
-				MicroProgramCodeModifier registerTransfer = [setWrite, setRead](MicroProgramCode& microProgramCode) {
-					(microProgramCode.*setWrite)();
-					(microProgramCode.*setRead)();
-				};
+				if (line.consume(';')) {
+					MicroProgramCodeSetFunction setWrite = getWriteBit(leftOperand);
+					MicroProgramCodeSetFunction setRead = getReadBit(rightOperand);
 
-				compiler.memory[compiler.firstFree].apply(registerTransfer);
+					//create a modifier executing both these functions
+					auto registerTransfer = [setWrite, setRead](MicroProgramCode& microProgramCode) {
+						(microProgramCode.*setWrite)();
+						(microProgramCode.*setRead)();
+					};
 
-				continue;
+					compiler.memory[compiler.firstFree].apply(registerTransfer);
+					return;
+				}
 			}
-
-			if (std::regex_match(instruction, matches, assignmentMatcher)) {
-				//the left operand "R" marks that storage read is being (un)set
-				if (matches[1] == "R") {
-					if (matches[2] == "1") {
-						compiler.memory[compiler.firstFree].apply(&MicroProgramCode::enableMemoryRead);
+			else if (line.consume('=')) {
+				//assignment to the storage access bits or the ALU code
+				std::string_view rightOperand = line.readWord();
+
+				if (line.consume(';')) {
+					//the left operand "R" marks that storage read is being (un)set
+					if (leftOperand == "R") {
+						compiler.memory[compiler.firstFree].apply(getStorageAccessSetter(rightOperand, &MicroProgramCode::enableMemoryRead, &MicroProgramCode::disableMemoryRead));
+						return;
 					}
-					if (matches[2] == "0") {
-						compiler.memory[compiler.firstFree].apply(&MicroProgramCode::disableMemoryRead);
-					}
-				}
 
-				//the left operand "R" marks that storage write is being (un)set
-				if (matches[1] == "W") {
-					if (matches[2] == "1") {
-						compiler.memory[compiler.firstFree].apply(&MicroProgramCode::enableMemoryWrite);
+					//the left operand "W" marks that storage write is being (un)set
+					if (leftOperand == "W") {
+						compiler.memory[compiler.firstFree].apply(getStorageAccessSetter(rightOperand, &MicroProgramCode::enableMemoryWrite, &MicroProgramCode::disableMemoryWrite));
+						return;
 					}
-					if (matches[2] == "0") {
-						compiler.memory[compiler.firstFree].apply(&MicroProgramCode::disableMemoryWrite);
+
+					//the left operand "ALU" marks that an ALU code (in [0, 7]) is being set
+					if (leftOperand == "ALU") {
+						compiler.memory[compiler.firstFree].apply(&MicroProgramCode::setALUCode, getALUCode(rightOperand));
+						return;
 					}
-				}
 
-				//the left operand "ALU" marks that an ALU code (in [0, 7]) is being set
-				if (matches[1] == "ALU") {
-					compiler.memory[compiler.firstFree].apply(&MicroProgramCode::setALUCode, getALUCode(matches[2]));
+					MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Found assignment to unknown target '{}'", leftOperand);
+					throw CompilerException(fmt::format("found assignment to unknown target '{}'", leftOperand));
 				}
-
-				continue;
-			}
-
-			if (std::regex_match(instruction, matches, jumpMatcher)) {
-				CompileMode::addJump(matches[1], fixedJump, compiler.memory[compiler.firstFree]);
-				continue;
 			}
-
-			//unknown instruction
-			MIMA_LOG_ERROR("Found unknown instruction '{}'", instruction);
-			throw CompilerException(fmt::format("found unknown instruction '{}'", instruction));
 		}
 
-		CompileMode::endOfLine(fixedJump, compiler.memory[compiler.firstFree]);
+		//unknown instruction, report everything up to the next instruction
+		line.setPosition(instructionStart);
+		std::string_view instruction = line.readUntil(";");
+
+		MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Found unknown instruction '{}'", instruction);
+		throw CompilerException(fmt::format("found unknown instruction '{}'", instruction));
 	}
 
 
 	void MicroProgramCompiler::DefaultCompileMode::closeCompileMode() {
 		//log closing of the default compiler mode
-		MIMA_LOG_TRACE("Closed default compiler mode");
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Closed default compiler mode");
 	}
 
 
@@ -350,11 +314,6 @@ namespace MiMa {
 	// Conditional jump compile mode of the microprogram compiler
 	// ----------------------------------------------------------
 
-	// --- Constants definitions ---
-
-	const std::regex MicroProgramCompiler::ConditionalCompileMode::conditionalJumpMatcher(R"(\s*\[\s*(.*?)\s*\,\s*(.*?)\s*\]\s*#(.*?)\s*(;?)\s*)");
-
-
 	// --- Functions ---
 
 	MicroProgramCompiler::ConditionalCompileMode::ConditionalCompileMode(MicroProgramCompiler& compiler, const std::string& conditionName, const size_t& conditionMax) :
@@ -363,31 +322,52 @@ namespace MiMa {
 		conditionMax(conditionMax)
 	{
 		compiler.memory[compiler.firstFree].reset(conditionName, conditionMax);
-		MIMA_LOG_TRACE("Opened conditional jump compiler mode for condition '{}' up to 0x{:X}", conditionName, conditionMax);
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Opened conditional jump compiler mode for condition '{}' up to 0x{:X}", conditionName, conditionMax);
 	}
 
 
-	void MicroProgramCompiler::ConditionalCompileMode::addLine(const std::string& line) {
-		std::smatch matches;
+	void MicroProgramCompiler::ConditionalCompileMode::addLine(LineScanner& line) {
+		//expected format: [lowerLimit, upperLimit] #label, optionally followed by a semicolon ending the line of code
+		size_t lowerLimit;
+		size_t upperLimit;
+		std::string_view label;
+
+		bool validLine = line.consume('[') && line.readDecimal(lowerLimit) && line.consume(',');
+		if (validLine) {
+			if (line.consume("max")) {
+				upperLimit = conditionMax;
+			}
+			else {
+				validLine = line.readDecimal(upperLimit);
+			}
+		}
 
-		if (!std::regex_match(line, matches, conditionalJumpMatcher)) {
-			throw CompilerException(fmt::format("can't parse line '{}' in conditional compile mode", line));
+		if (validLine && line.consume(']') && line.consume('#')) {
+			label = line.readWord();
 		}
 
-		const size_t lowerLimit = std::stoi(matches[1]);
-		const size_t upperLimit = (matches[2] == "max") ? conditionMax : std::stoi(matches[2]);
+		if (label.empty()) {
+			line.setPosition(0);
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Can't parse line '{}' in conditional compile mode", line.rest());
+			throw CompilerException(fmt::format("can't parse line '{}' in conditional compile mode", line.rest()));
+		}
 
-		CompileMode::addJump(matches[3], compiler.memory[compiler.firstFree], lowerLimit, upperLimit);
+		CompileMode::addJump(std::string(label), compiler.memory[compiler.firstFree], lowerLimit, upperLimit);
 
-		if (matches[4] == ";") {
+		if (line.consume(';')) {
 			CompileMode::endOfLine(compiler.memory[compiler.firstFree]);
 		}
+
+		if (!line.skipWhitespace()) {
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Unexpected '{}' after conditional jump", line.rest());
+			throw CompilerException(fmt::format("unexpected '{}' after conditional jump", line.rest()));
+		}
 	}
 
 
 	void MicroProgramCompiler::ConditionalCompileMode::closeCompileMode() {
 		//log closing of the conditional compiler mode
-		MIMA_LOG_TRACE("Closed conditional compiler mode");
+		MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Closed conditional compiler mode");
 	}
 
 
@@ -396,127 +376,172 @@ namespace MiMa {
 	// Microprogram compiler
 	// ---------------------
 
-	// --- Constants definitions ---
-
-	const std::regex MicroProgramCompiler::compilerDirectivePattern(R"(\s*\!(.*))");
-	const std::regex MicroProgramCompiler::compilerDirectiveFunctionMatcher(R"((?:(.*)\((.*)\)))");
-	const std::regex MicroProgramCompiler::compilerDirectiveParameterMatcher(R"((.+?)(?:$|,)\s*)");
-
-
 	// --- Functions ---
 
 	MicroProgramCompiler::MicroProgramCompiler() : memory(new MicroProgramCodeList[0x100]) {
 		currentCompileMode.reset(new DefaultCompileMode(*this));
 
 		//0xFF is reserved for halt
-		labels.insert({ "halt", HALT_RESERVED });
+		labels.push_back({ "halt", HALT_RESERVED, definedLabels++ });
+		labelIds.insert({ "halt", 0 });
 		memory[HALT_RESERVED].apply(&MicroProgramCode::setJump, HALT_RESERVED, 0, HALT_RESERVED);
 
-		MIMA_LOG_INFO("Initialized microcode compiler");
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Initialized microcode compiler");
 	};
 
 
-	void MicroProgramCompiler::addDirective(const std::string& directive) {
-		std::smatch matches;
+	size_t MicroProgramCompiler::internLabel(const std::string& label) {
+		std::pair<std::unordered_map<std::string, size_t>::iterator, bool> labelId = labelIds.insert({ label, labels.size() });
 
-		if (std::regex_match(directive, matches, compilerDirectiveFunctionMatcher)) {
-			//extract function name
-			std::string func = matches[1];
+		if (labelId.second) {
+			labels.push_back({ label });
+		}
+
+		return labelId.first->second;
+	}
 
-			//extract arguments
-			std::vector<std::string> arguments;
+	void MicroProgramCompiler::resolveJumps() {
+		for (const JumpFixup& jumpFixup : jumpFixups) {
+			const Label& label = labels[jumpFixup.labelId];
 
-			std::string argumentList = matches[2];
-			while (std::regex_search(argumentList, matches, compilerDirectiveParameterMatcher)) {
-				arguments.push_back(matches[1]);
-				argumentList = matches.suffix();
+			if (label.address == UNDEFINED_LABEL) {
+				MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Found jump from 0x{:02X} to undefined label '{}'", jumpFixup.site, label.name);
+				throw CompilerException(fmt::format("found jump from 0x{:02X} to undefined label '{}'", jumpFixup.site, label.name));
 			}
+		}
 
-			//compile mode function
-			if (func == "cm") {
+		//forward jumps overlapping in the same code take effect in the order their labels were defined in
+		std::stable_sort(jumpFixups.begin(), jumpFixups.end(), [this](const JumpFixup& left, const JumpFixup& right) {
+			return labels[left.labelId].definitionIndex < labels[right.labelId].definitionIndex;
+		});
 
-				//switch to default compile mode
-				if (arguments[0] == "default") {
-					//no other arguments are expected
-					if (arguments.size() != 1) {
-						MIMA_LOG_ERROR("Expected one argument for compiler directive function {}, found {}", func, arguments.size());
-						throw CompilerException(fmt::format("expected one argument for compiler directive function {}, found {}", func, arguments.size()));
-					}
+		//all labels are known now, so every jump can be written in a single pass
+		for (const JumpFixup& jumpFixup : jumpFixups) {
+			const Label& label = labels[jumpFixup.labelId];
+
+			memory[jumpFixup.site].apply(&MicroProgramCode::setJump, (uint8_t)label.address, jumpFixup.lowerLimit, jumpFixup.upperLimit);
+			MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Resolved label at 0x{:02X} to 0x{:02X} for range from 0x{:02X} to 0x{:02X}, current value: {}", jumpFixup.site, label.address, jumpFixup.lowerLimit, jumpFixup.upperLimit, memory[jumpFixup.site]);
+		}
 
-					//switch compile mode
-					currentCompileMode->closeCompileMode();
-					currentCompileMode.reset(new DefaultCompileMode(*this));
+		jumpFixups.clear();
+	}
 
-					MIMA_LOG_TRACE("Switched to a default compiler compile mode");
-					return;
+
+	void MicroProgramCompiler::addDirective(LineScanner& directive) {
+		//compiler directives are written like function calls: func(argument, argument, ...)
+		std::string_view func = directive.readWord();
+
+		if (func.empty() || !directive.consume('(')) {
+			directive.setPosition(0);
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Discarding unknown compiler directive '{}'", directive.rest());
+			throw CompilerException(fmt::format("discarding unknown compiler directive '{}'", directive.rest()));
+		}
+
+		//extract arguments
+		std::vector<std::string_view> arguments;
+
+		if (!directive.consume(')')) {
+			do {
+				arguments.push_back(directive.readUntil(",)"));
+			} while (directive.consume(','));
+
+			if (!directive.consume(')')) {
+				MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Expected ')' to close the arguments of compiler directive function {}", func);
+				throw CompilerException(fmt::format("expected ')' to close the arguments of compiler directive function {}", func));
+			}
+		}
+
+		if (!directive.skipWhitespace()) {
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Unexpected '{}' after compiler directive function {}", directive.rest(), func);
+			throw CompilerException(fmt::format("unexpected '{}' after compiler directive function {}", directive.rest(), func));
+		}
+
+		//compile mode function
+		if (func == "cm") {
+			if (arguments.empty()) {
+				MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Expected at least one argument for compiler directive function {}", func);
+				throw CompilerException(fmt::format("expected at least one argument for compiler directive function {}", func));
+			}
+
+			//switch to default compile mode
+			if (arguments[0] == "default") {
+				//no other arguments are expected
+				if (arguments.size() != 1) {
+					MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Expected one argument for compiler directive function {}, found {}", func, arguments.size());
+					throw CompilerException(fmt::format("expected one argument for compiler directive function {}, found {}", func, arguments.size()));
 				}
 
-				if (arguments[0] == "conditional") {
-					//two mode arguments are expected:
-					// 1 | name of condition
-					// 2 | max value of condtion
-					if (arguments.size() != 3) {
-						MIMA_LOG_ERROR("Expected three arguments for compiler directive function {}, only found {}", func, arguments.size());
-						throw CompilerException(fmt::format("expected three arguments for compiler directive function {}, only found {}", func, arguments.size()));
-					}
+				//switch compile mode
+				currentCompileMode->closeCompileMode();
+				currentCompileMode.reset(new DefaultCompileMode(*this));
 
-					//check if the maximal condition value is valid
-					size_t conditionMax;
-					try {
-						conditionMax = std::stoi(arguments[2]);
-					}
-					catch (const std::invalid_argument&) {
-						MIMA_LOG_ERROR("Couldn't convert {} into a condition maximum", arguments[2]);
-						throw CompilerException(fmt::format("couldn't convert {} into a condition maximum", arguments[2]));
-					}
+				MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Switched to a default compiler compile mode");
+				return;
+			}
 
-					//switch compile mode
-					currentCompileMode->closeCompileMode();
-					currentCompileMode.reset(new ConditionalCompileMode(*this, arguments[1], conditionMax));
+			if (arguments[0] == "conditional") {
+				//two mode arguments are expected:
+				// 1 | name of condition
+				// 2 | max value of condtion
+				if (arguments.size() != 3) {
+					MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Expected three arguments for compiler directive function {}, only found {}", func, arguments.size());
+					throw CompilerException(fmt::format("expected three arguments for compiler directive function {}, only found {}", func, arguments.size()));
+				}
 
-					MIMA_LOG_TRACE("Switched to a conditional decode compiler compile mode");
-					return;
+				//check if the maximal condition value is valid
+				size_t conditionMax;
+				LineScanner conditionMaxScanner(arguments[2]);
+				if (!conditionMaxScanner.readDecimal(conditionMax) || !conditionMaxScanner.atEnd()) {
+					MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Couldn't convert {} into a condition maximum", arguments[2]);
+					throw CompilerException(fmt::format("couldn't convert {} into a condition maximum", arguments[2]));
 				}
+
+				//switch compile mode
+				currentCompileMode->closeCompileMode();
+				currentCompileMode.reset(new ConditionalCompileMode(*this, std::string(arguments[1]), conditionMax));
+
+				MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Switched to a conditional decode compiler compile mode");
+				return;
 			}
 
-			MIMA_LOG_ERROR("Expected at least one argument for compiler directive function {}", func);
-			throw CompilerException(fmt::format("expected at least one argument for compiler directive function {}", func));
+			MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Unknown compile mode '{}'", arguments[0]);
+			throw CompilerException(fmt::format("unknown compile mode '{}'", arguments[0]));
 		}
 
-		MIMA_LOG_ERROR("Discarding unknwon compiler directive '{}'", directive);
-		throw CompilerException(fmt::format("discarding unknwon compiler directive '{}'", directive));
+		MIMA_CHANNEL_LOG_ERROR(MICROCOMPILER, "Discarding unknown compiler directive function '{}'", func);
+		throw CompilerException(fmt::format("discarding unknown compiler directive function '{}'", func));
 	}
 
 	void MicroProgramCompiler::addLine(const std::string& line) {
 		//remove comment at the start of the line
-		std::string codeLine = line.substr(0, line.find("//"));
+		LineScanner codeLine(std::string_view(line).substr(0, line.find("//")));
 
 		//don't add empty lines
-		if (std::regex_match(codeLine, CompileMode::emptyLinePattern)) {
+		if (codeLine.skipWhitespace()) {
 			return;
 		}
 
 		//if the line starts with a compiler directive symbol, treat it as such
-		std::smatch matches;
-		if (std::regex_match(codeLine, matches, MicroProgramCompiler::compilerDirectivePattern)) {
-			addDirective(matches[1]);
+		if (codeLine.consume(char_COMPILER_DIRECTIVE)) {
+			addDirective(codeLine);
 			return;
 		}
 		
 		//otherwise, pass it on to the current compile mode
-		currentCompileMode->addLine(line);
+		currentCompileMode->addLine(codeLine);
 	}
 
 
-	std::shared_ptr<const MicroProgram> MicroProgramCompiler::finish() {
+	std::shared_ptr<const MicroProgram> MicroProgramCompiler::finish(MicroProgramOptimization* optimization) {
 		currentCompileMode->finish();
+		resolveJumps();
 
-		for (auto unresolvedListener = labelAddListeners.begin(); unresolvedListener != labelAddListeners.end(); ++unresolvedListener) {
-			MIMA_LOG_WARN("Found label listener for {} after finishing compilation", unresolvedListener->first);
+		if (optimization) {
+			*optimization = MicroProgramOptimizer(memory).optimize();
 		}
 
 		//create microprogram
-		MIMA_LOG_INFO("Finished microprogram compilation at 0x{:02X}", firstFree);
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Finished microprogram compilation at 0x{:02X}", firstFree);
 
 		std::shared_ptr<const MicroProgram> program = std::make_shared<MicroProgram>(memory);
 		return program;
@@ -529,8 +554,8 @@ namespace MiMa {
 	// ---------------------
 
 	//Interface: read input from a pointer to a char array containing the code for the program.
-	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compile(const std::string& microProgramCode) {
-		MIMA_LOG_INFO("Compiling microprogram from given code string");
+	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compile(const std::string& microProgramCode, MicroProgramOptimization* optimization) {
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Compiling microprogram from given code string");
 
 		MicroProgramCompiler compiler;
 
@@ -540,12 +565,12 @@ namespace MiMa {
 			compiler.addLine(codeLine);
 		}
 
-		return compiler.finish();
+		return compiler.finish(optimization);
 	}
 
 	//Interface: read input from an input providing the code for the program.
-	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compile(std::istream& microProgramCode) {
-		MIMA_LOG_INFO("Compiling microprogram from given input");
+	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compile(std::istream& microProgramCode, MicroProgramOptimization* optimization) {
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Compiling microprogram from given input");
 
 		MicroProgramCompiler compiler;
 
@@ -554,20 +579,20 @@ namespace MiMa {
 			compiler.addLine(codeLine);
 		}
 
-		return compiler.finish();
+		return compiler.finish(optimization);
 	}
 
 
 	//Interface: read input from a file containing the code for the program.
-	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compileFile(const std::string& fileName) {
-		MIMA_LOG_INFO("Compiling microprogram from an input file");
+	std::shared_ptr<const MicroProgram> MicroProgramCompiler::compileFile(const std::string& fileName, MicroProgramOptimization* optimization) {
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Compiling microprogram from an input file");
 
 		std::ifstream fileInputStream(fileName);
 		if (!fileInputStream.good()) {
 			throw CompilerException(fmt::format("Failed to open microprogram code file '{}'", fileName));
 		}
 
-		std::shared_ptr<const MicroProgram> program = compile(fileInputStream);
+		std::shared_ptr<const MicroProgram> program = compile(fileInputStream, optimization);
 
 		fileInputStream.close();
 		return program;
@@ -4,39 +4,33 @@
 #include <cstdint>
 #include <cctype>
 #include <fstream>
-#include <functional>
 #include <istream>
-#include <map>
 #include <memory>
-#include <regex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 //internal classes
 #include "MicroProgram.h"
+#include "MicroProgramOptimizer.h"
 
 //internal utility
 #include "util/BinaryOperatorBuffer.h"
+#include "util/LineScanner.h"
 
 //debugging utility
 #include "debug/Log.h"
 
 
 namespace MiMa {
-	//Utility: binary operators understandable by the micro program compiler
-	typedef std::function<void(MicroProgramCode&)> MicroProgramCodeModifier;
-	typedef MicroProgramCodeModifier(*BinaryOperator)(const std::string&, const std::string&);
-
 	class MicroProgramCompiler {
 	private:
 		class CompileMode {
-		public:
-			static const std::regex emptyLinePattern;
-
 		protected:
 			MicroProgramCompiler& compiler;
 			CompileMode(MicroProgramCompiler& compiler) : compiler(compiler) {}
 
-			//adds a new label and resolves unresolved jumps to the given label
+			//adds a new label at the current address
 			void addLabel(std::string label);
 			//adds a jump instruction to the current microcode
 			void addJump(std::string label, bool& fixedJump, MicroProgramCodeList& currentCode, bool overrideFixed = false);
@@ -46,7 +40,7 @@ namespace MiMa {
 			void endOfLine(MicroProgramCodeList& currentCode);
 			void endOfLine(bool& fixedJump, MicroProgramCodeList& currentCode);
 		public:
-			virtual void addLine(const std::string& line) = 0;
+			virtual void addLine(LineScanner& line) = 0;
 
 			virtual void closeCompileMode() = 0;
 			virtual void finish();
@@ -55,46 +49,32 @@ namespace MiMa {
 
 	private:
 		class DefaultCompileMode : public CompileMode {
-		private:
-			static const std::regex labelMatcher;
-			static const std::regex instructionMatcher;
-
-			static const std::regex registerTransferMatcher;
-			static const std::regex assignmentMatcher;
-			static const std::regex jumpMatcher;
-
 		private:
 			//current line of code encoding
 			bool fixedJump = false;
+
+			void addInstruction(LineScanner& line);
 		public:
 			DefaultCompileMode(MicroProgramCompiler& compiler);
 
-			void addLine(const std::string& line) override;
+			void addLine(LineScanner& line) override;
 
 			void closeCompileMode() override;
 		};
 
 		class ConditionalCompileMode : public CompileMode {
-		private:
-			static const std::regex conditionalJumpMatcher;
-
 		private:
 			const std::string conditionName;
 			const size_t conditionMax;
 		public:
 			ConditionalCompileMode(MicroProgramCompiler& compiler, const std::string& conditionName, const size_t& conditionMax);
 
-			void addLine(const std::string& line) override;
+			void addLine(LineScanner& line) override;
 
 			void closeCompileMode() override;
 		};
 
 
-	private:
-		static const std::regex compilerDirectivePattern;
-		static const std::regex compilerDirectiveFunctionMatcher;
-		static const std::regex compilerDirectiveParameterMatcher;
-
 	private:
 		//current compile mode
 		std::unique_ptr<CompileMode> currentCompileMode;
@@ -103,28 +83,50 @@ namespace MiMa {
 		std::shared_ptr<MicroProgramCodeList[]> memory;
 		uint8_t firstFree = 0;
 
-		//label tracking
-		std::unordered_map<std::string, uint8_t> labels;
-		std::multimap<std::string, std::function<bool(const uint8_t&)>> labelAddListeners;
+		//label tracking, every label name is interned to an id indexing the label list
+		static const uint16_t UNDEFINED_LABEL = 0x100;
+
+		struct Label {
+			std::string name;
+			uint16_t address = UNDEFINED_LABEL;
+			size_t definitionIndex = 0; //labels are numbered in the order they are defined in
+		};
+
+		//a jump to a label which wasn't defined yet, written to the given condition range of the site once compilation finishes
+		struct JumpFixup {
+			uint8_t site;
+			size_t lowerLimit;
+			size_t upperLimit;
+			size_t labelId;
+		};
+
+		std::unordered_map<std::string, size_t> labelIds;
+		std::vector<Label> labels;
+		size_t definedLabels = 0;
+		std::vector<JumpFixup> jumpFixups;
+
+		size_t internLabel(const std::string& label);
+		void resolveJumps();
 
 
-		void addDirective(const std::string& directive);
+		void addDirective(LineScanner& directive);
 
 	public:
 		MicroProgramCompiler();
 
 		void addLine(const std::string& line);
 
-		std::shared_ptr<const MicroProgram> finish();
+		//optimizes the compiled microprogram if an optimization is given to describe the result in
+		std::shared_ptr<const MicroProgram> finish(MicroProgramOptimization* optimization = nullptr);
 
 
 		// ------------------------------------------------------
 		// Compilation utility methods
 		// Use these for simple compilation of common input types
 		// ------------------------------------------------------
-		static std::shared_ptr<const MicroProgram> compile(const std::string& microProgramCode);
-		static std::shared_ptr<const MicroProgram> compile(std::istream& microProgramCode);
+		static std::shared_ptr<const MicroProgram> compile(const std::string& microProgramCode, MicroProgramOptimization* optimization = nullptr);
+		static std::shared_ptr<const MicroProgram> compile(std::istream& microProgramCode, MicroProgramOptimization* optimization = nullptr);
 		
-		static std::shared_ptr<const MicroProgram> compileFile(const std::string& fileName);
+		static std::shared_ptr<const MicroProgram> compileFile(const std::string& fileName, MicroProgramOptimization* optimization = nullptr);
 	};
 }
@@ -0,0 +1,527 @@
+#include "mimapch.h"
+#include "MicroProgramOptimizer.h"
+
+//std library
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <utility>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//internal classes
+#include "StatusBit.h"
+
+
+namespace MiMa {
+	// ---------------
+	// Utility methods
+	// ---------------
+
+	//Utility: the registers connected to the data bus
+	namespace BusRegister {
+		constexpr uint16_t SDR = BIT(0);
+		constexpr uint16_t IR = BIT(1);
+		constexpr uint16_t IAR = BIT(2);
+		constexpr uint16_t ONE = BIT(3);
+		constexpr uint16_t Z = BIT(4);
+		constexpr uint16_t ACCU = BIT(5);
+		constexpr uint16_t X = BIT(6);
+		constexpr uint16_t Y = BIT(7);
+		constexpr uint16_t SAR = BIT(8);
+		constexpr uint16_t ALL = 0x1FF;
+	}
+
+	//Utility: the status bits the minimal machine provides as conditions
+	static const std::string OP_CODE_CONDITION = "op_code";
+	static const std::string ACCUMULATOR_NEGATIVE_CONDITION = "accumulator_negative";
+
+
+	//Utility: the registers put on the data bus
+	static uint16_t getSources(const MicroProgramCode& code) {
+		uint16_t sources = 0;
+		if (code.isStorageDataRegisterWriting()) sources |= BusRegister::SDR;
+		if (code.isInstructionRegisterWriting()) sources |= BusRegister::IR;
+		if (code.isInstructionAddressRegisterWriting()) sources |= BusRegister::IAR;
+		if (code.isConstantOneWriting()) sources |= BusRegister::ONE;
+		if (code.isALUResultWriting()) sources |= BusRegister::Z;
+		if (code.isAccumulatorRegisterWriting()) sources |= BusRegister::ACCU;
+		return sources;
+	}
+
+	//Utility: the registers loaded from the data bus
+	static uint16_t getDestinations(const MicroProgramCode& code) {
+		uint16_t destinations = 0;
+		if (code.isStorageDataRegisterReading()) destinations |= BusRegister::SDR;
+		if (code.isInstructionRegisterReading()) destinations |= BusRegister::IR;
+		if (code.isInstructionAddressRegisterReading()) destinations |= BusRegister::IAR;
+		if (code.isLeftALUOperandReading()) destinations |= BusRegister::X;
+		if (code.isRightALUOperandReading()) destinations |= BusRegister::Y;
+		if (code.isAccumulatorRegisterReading()) destinations |= BusRegister::ACCU;
+		if (code.isStorageAddressRegisterReading()) destinations |= BusRegister::SAR;
+		return destinations;
+	}
+
+	//Utility: all registers changed by the end of the cycle, including the ALU result and a completed memory read
+	static uint16_t getModified(const MicroProgramCode& code) {
+		uint16_t modified = getDestinations(code);
+		if (code.getALUCode() != 0) modified |= BusRegister::Z;
+		if (code.isReadingFromMemory()) modified |= BusRegister::SDR;
+		return modified;
+	}
+
+	static bool accessesMemory(const MicroProgramCode& code) {
+		return code.isReadingFromMemory() || code.isWritingToMemory();
+	}
+
+	//Utility: checks if the code of two consecutive cycles has the same effect when executed in a single cycle
+	static bool canShareCycle(const MicroProgramCode& first, const MicroProgramCode& second) {
+		//a single access per cycle, its duration counts cycles
+		if (accessesMemory(first) && accessesMemory(second)) {
+			return false;
+		}
+
+		uint16_t firstSources = getSources(first);
+		uint16_t firstDestinations = getDestinations(first);
+		uint16_t secondSources = getSources(second);
+		uint16_t secondDestinations = getDestinations(second);
+
+		//the data bus carries all sources at once, every load has to see the value it saw on its own
+		if (firstDestinations != 0 && secondDestinations != 0) {
+			if (firstSources != secondSources) {
+				return false;
+			}
+		}
+		else if (firstDestinations != 0) {
+			if (secondSources & ~firstSources) {
+				return false;
+			}
+		}
+		else if (secondDestinations != 0) {
+			if (firstSources & ~secondSources) {
+				return false;
+			}
+		}
+
+		//the bus is driven before any register changes, so the second code must not depend on the first one
+		if ((secondSources & getModified(first)) || (firstDestinations & secondDestinations)) {
+			return false;
+		}
+
+		//the ALU computes once at the end of the cycle, from the operands loaded in it
+		if (first.getALUCode() != 0 && (second.getALUCode() != 0 || (secondDestinations & (BusRegister::X | BusRegister::Y)))) {
+			return false;
+		}
+
+		//a memory access of the first code uses the address and data register of the end of the cycle
+		if (accessesMemory(first) && (secondDestinations & (BusRegister::SAR | BusRegister::SDR))) {
+			return false;
+		}
+
+		return true;
+	}
+
+	//Utility: the registers a condition is derived from, unknown conditions might depend on any register
+	static uint16_t getConditionRegisters(const std::string& conditionName) {
+		if (conditionName == OP_CODE_CONDITION) {
+			return BusRegister::IR;
+		}
+		if (conditionName == ACCUMULATOR_NEGATIVE_CONDITION) {
+			return BusRegister::ACCU;
+		}
+		return BusRegister::ALL;
+	}
+
+
+
+	// ------------------------------------
+	// Microprogram optimization reporting
+	// ------------------------------------
+
+	static std::string formatCycleCost(const MicroProgramCycleCost& cost) {
+		if (cost.maximum == MicroProgramCycleCost::UNBOUNDED) {
+			return cost.minimum == MicroProgramCycleCost::UNBOUNDED ? "unbounded" : fmt::format("{}-unbounded", cost.minimum);
+		}
+		return cost.minimum == cost.maximum ? fmt::format("{}", cost.minimum) : fmt::format("{}-{}", cost.minimum, cost.maximum);
+	}
+
+
+	void MicroProgramOptimization::writeReport(std::ostream& output) const {
+		fmt::memory_buffer report;
+		fmt::format_to(std::back_inserter(report), "Hoisted {} ALU operations, fused {} states, merged {} equivalent states and removed {} unreachable states\n", hoistedOperations, fusedStates, mergedStates, removedStates);
+		fmt::format_to(std::back_inserter(report), "{:<9}  {:>9}  {:>9}\n", "op codes", "before", "after");
+
+		for (const MicroProgramOpCodeCost& cost : costs) {
+			std::string opCodes = cost.lowerOpCode == cost.upperOpCode ? fmt::format("0x{:02X}", cost.lowerOpCode) : fmt::format("0x{:02X}-0x{:02X}", cost.lowerOpCode, cost.upperOpCode);
+			fmt::format_to(std::back_inserter(report), "{:<9}  {:>9}  {:>9}\n", opCodes, formatCycleCost(cost.before), formatCycleCost(cost.after));
+		}
+
+		output.write(report.data(), report.size());
+	}
+
+
+
+	// ----------------------
+	// Microprogram optimizer
+	// ----------------------
+
+	MicroProgramOptimizer::MicroProgramOptimizer(const std::shared_ptr<MicroProgramCodeList[]>& memory) : memory(memory) {}
+
+
+	void MicroProgramOptimizer::analyze() {
+		reachable.assign(STATE_COUNT, false);
+		predecessors.assign(STATE_COUNT, {});
+
+		std::vector<uint8_t> pending = { START_STATE };
+		reachable[START_STATE] = true;
+
+		while (!pending.empty()) {
+			uint8_t state = pending.back();
+			pending.pop_back();
+
+			for (const MicroProgramCodeInterval& interval : memory[state].intervals) {
+				uint8_t next = interval.code.getNextInstructionDecoderState();
+				predecessors[next].push_back(state);
+
+				if (!reachable[next]) {
+					reachable[next] = true;
+					pending.push_back(next);
+				}
+			}
+		}
+	}
+
+
+	bool MicroProgramOptimizer::isAccessingMemory(const uint8_t& state) const {
+		for (const MicroProgramCodeInterval& interval : memory[state].intervals) {
+			if (accessesMemory(interval.code)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool MicroProgramOptimizer::isFusable(const uint8_t& state, const MicroProgramCode& code, const uint8_t& following) const {
+		//the start state begins every instruction, and jumping to itself halts
+		if (following == START_STATE || following == state) {
+			return false;
+		}
+
+		const MicroProgramCodeList& followingCode = memory[following];
+
+		//a code list has a single condition, so only one of both may be conditional
+		if (memory[state].intervals.size() > 1 && followingCode.intervals.size() > 1) {
+			return false;
+		}
+
+		//the condition is now evaluated at the start of the fused cycle, before the transfers of the first code
+		if (followingCode.intervals.size() > 1 && (getDestinations(code) & getConditionRegisters(followingCode.conditionName))) {
+			return false;
+		}
+
+		bool followingAccessesMemory = false;
+		for (const MicroProgramCodeInterval& interval : followingCode.intervals) {
+			uint8_t next = interval.code.getNextInstructionDecoderState();
+
+			//a halting state has to stay on its own, and a jump back would halt the fused state
+			if (next == following || next == state || !canShareCycle(code, interval.code)) {
+				return false;
+			}
+
+			//an access ends in the cycle without access after it, which is the following state
+			if (accessesMemory(code) && isAccessingMemory(next)) {
+				return false;
+			}
+
+			followingAccessesMemory |= accessesMemory(interval.code);
+		}
+
+		//an access starts after a cycle without access, which was this state
+		if (followingAccessesMemory) {
+			for (const uint8_t& predecessor : predecessors[state]) {
+				if (isAccessingMemory(predecessor)) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+
+	size_t MicroProgramOptimizer::hoistALUOperations() {
+		size_t hoisted = 0;
+
+		for (size_t state = 0; state < STATE_COUNT; ++state) {
+			if (!reachable[state] || memory[state].intervals.size() != 1) {
+				continue;
+			}
+
+			const MicroProgramCode& code = memory[state].intervals.front().code;
+			uint8_t following = code.getNextInstructionDecoderState();
+			if (following == START_STATE || following == state || memory[following].intervals.size() != 1 || predecessors[following].size() != 1) {
+				continue;
+			}
+
+			//the operation computes the same result one cycle earlier if its operands are already loaded and nothing reads Z in between
+			const MicroProgramCode& followingCode = memory[following].intervals.front().code;
+			if (code.getALUCode() != 0 || followingCode.getALUCode() == 0 || followingCode.getNextInstructionDecoderState() == following
+				|| (getDestinations(followingCode) & (BusRegister::X | BusRegister::Y)) || (getSources(followingCode) & BusRegister::Z)) {
+				continue;
+			}
+
+			uint8_t aluCode = followingCode.getALUCode();
+			memory[state].apply(&MicroProgramCode::setALUCode, aluCode);
+			memory[following].apply(&MicroProgramCode::setALUCode, 0);
+
+			MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Hoisted ALU operation {} from 0x{:02X} to 0x{:02X}", aluCode, following, state);
+			hoisted++;
+		}
+
+		return hoisted;
+	}
+
+
+	size_t MicroProgramOptimizer::fuseStates() {
+		size_t fused = 0;
+
+		for (size_t state = 0; state < STATE_COUNT; ++state) {
+			if (!reachable[state]) {
+				continue;
+			}
+
+			//a fused state is tried again with its new following states, bounded over all passes in case they loop without ever reaching the start,
+			//since every pass would unroll such a loop further
+			bool fusing = true;
+			while (fusing && fusionCounts[state] < STATE_COUNT) {
+				fusing = false;
+
+				size_t lowerLimit = 0;
+				for (const MicroProgramCodeInterval& interval : memory[state].intervals) {
+					MicroProgramCode code = interval.code;
+					size_t upperLimit = interval.upperConditionLimit;
+					uint8_t following = code.getNextInstructionDecoderState();
+
+					if (isFusable((uint8_t)state, code, following)) {
+						uint32_t operations = code.bits & ~StatusBit::FOLLOWING_ADDRESS;
+
+						if (memory[state].intervals.size() == 1) {
+							//an unconditional state takes over the whole, possibly conditional, following code
+							memory[state] = memory[following];
+							memory[state].apply([operations](MicroProgramCode& fusedCode) { fusedCode.bits |= operations; });
+						}
+						else {
+							MicroProgramCode fusedCode = memory[following].intervals.front().code;
+							fusedCode.bits |= operations;
+							memory[state].apply([fusedCode](MicroProgramCode& intervalCode) { intervalCode = fusedCode; }, lowerLimit, upperLimit);
+						}
+
+						MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Fused 0x{:02X} into 0x{:02X} for condition range from 0x{:X} to 0x{:X}", following, state, lowerLimit, upperLimit);
+						analyze();
+						fusionCounts[state]++;
+						fused++;
+						fusing = true;
+						break;
+					}
+
+					lowerLimit = upperLimit + 1;
+				}
+			}
+		}
+
+		return fused;
+	}
+
+
+	size_t MicroProgramOptimizer::mergeEquivalentStates() {
+		//a state is identified by its condition, its code and the classes of the states it jumps to
+		typedef std::pair<std::string, std::vector<size_t>> Signature;
+		constexpr size_t SELF = STATE_COUNT;
+
+		std::vector<size_t> classes(STATE_COUNT, 0);
+		size_t classCount = 0;
+
+		//refine the classes until no class splits anymore
+		while (true) {
+			std::map<Signature, size_t> signatures;
+			std::vector<size_t> refined(STATE_COUNT, 0);
+
+			for (size_t state = 0; state < STATE_COUNT; ++state) {
+				if (!reachable[state]) {
+					continue;
+				}
+
+				const MicroProgramCodeList& codeList = memory[state];
+
+				//the start state stays on its own, it marks the end of every instruction
+				Signature signature = { codeList.conditionName, { state == START_STATE, codeList.conditionMax } };
+				for (const MicroProgramCodeInterval& interval : codeList.intervals) {
+					uint8_t next = interval.code.getNextInstructionDecoderState();
+					signature.second.push_back(interval.upperConditionLimit);
+					signature.second.push_back(interval.code.bits & ~StatusBit::FOLLOWING_ADDRESS);
+					signature.second.push_back(next == state ? SELF : classes[next]);
+				}
+
+				refined[state] = signatures.insert({ signature, signatures.size() }).first->second;
+			}
+
+			if (signatures.size() == classCount) {
+				break;
+			}
+
+			classCount = signatures.size();
+			classes = refined;
+		}
+
+		//the lowest state of a class represents it
+		std::vector<size_t> representatives(classCount, STATE_COUNT);
+		for (size_t state = STATE_COUNT; state-- > 0;) {
+			if (reachable[state]) {
+				representatives[classes[state]] = state;
+			}
+		}
+
+		size_t merged = 0;
+		for (size_t state = 0; state < STATE_COUNT; ++state) {
+			if (!reachable[state]) {
+				continue;
+			}
+			if (representatives[classes[state]] != state) {
+				MIMA_CHANNEL_LOG_TRACE(MICROCOMPILER, "Merged 0x{:02X} into the equivalent 0x{:02X}", state, representatives[classes[state]]);
+				merged++;
+				continue;
+			}
+
+			//redirect all jumps to the representatives
+			std::vector<std::pair<size_t, size_t>> ranges;
+			size_t lowerLimit = 0;
+			for (const MicroProgramCodeInterval& interval : memory[state].intervals) {
+				ranges.push_back({ lowerLimit, interval.upperConditionLimit });
+				lowerLimit = interval.upperConditionLimit + 1;
+			}
+
+			for (const std::pair<size_t, size_t>& range : ranges) {
+				memory[state].apply([&classes, &representatives](MicroProgramCode& code) {
+					code.setJump((uint8_t)representatives[classes[code.getNextInstructionDecoderState()]]);
+				}, range.first, range.second);
+			}
+		}
+
+		analyze();
+		return merged;
+	}
+
+
+	size_t MicroProgramOptimizer::removeUnreachableStates() {
+		const MicroProgramCodeList unused;
+		size_t removed = 0;
+
+		for (size_t state = 0; state < STATE_COUNT; ++state) {
+			const MicroProgramCodeList& codeList = memory[state];
+
+			if (!reachable[state] && (codeList.conditionMax != unused.conditionMax || codeList.intervals.front().code != unused.intervals.front().code)) {
+				memory[state].reset();
+				removed++;
+			}
+		}
+
+		return removed;
+	}
+
+
+	MicroProgramCycleCost MicroProgramOptimizer::measure(const uint8_t& state, const size_t& opCode, std::vector<MicroProgramCycleCost>& costs) const {
+		if (costs[state].maximum != 0) {
+			return costs[state];
+		}
+
+		//a state reached again before the instruction ends is part of a loop
+		constexpr size_t UNBOUNDED = MicroProgramCycleCost::UNBOUNDED;
+		costs[state] = { UNBOUNDED, UNBOUNDED };
+
+		const MicroProgramCodeList& codeList = memory[state];
+		bool decodingOpCode = codeList.intervals.size() > 1 && codeList.conditionName == OP_CODE_CONDITION;
+		size_t condition = std::min(opCode, codeList.conditionMax);
+
+		MicroProgramCycleCost cost = { UNBOUNDED, 0 };
+		size_t lowerLimit = 0;
+		for (const MicroProgramCodeInterval& interval : codeList.intervals) {
+			bool taken = !decodingOpCode || (lowerLimit <= condition && condition <= interval.upperConditionLimit);
+			lowerLimit = interval.upperConditionLimit + 1;
+
+			if (!taken) {
+				continue;
+			}
+
+			//the instruction ends with the jump to the start state or with halting in this state
+			MicroProgramCycleCost branch = { 1, 1 };
+			uint8_t next = interval.code.getNextInstructionDecoderState();
+			if (next != START_STATE && next != state) {
+				MicroProgramCycleCost following = measure(next, opCode, costs);
+				branch.minimum = following.minimum == UNBOUNDED ? UNBOUNDED : following.minimum + 1;
+				branch.maximum = following.maximum == UNBOUNDED ? UNBOUNDED : following.maximum + 1;
+			}
+
+			cost.minimum = std::min(cost.minimum, branch.minimum);
+			cost.maximum = std::max(cost.maximum, branch.maximum);
+		}
+
+		costs[state] = cost;
+		return cost;
+	}
+
+	std::vector<MicroProgramCycleCost> MicroProgramOptimizer::measure() const {
+		//every value of the operation code decoded by any state is measured on its own
+		size_t maxOpCode = 0;
+		for (size_t state = 0; state < STATE_COUNT; ++state) {
+			if (reachable[state] && memory[state].intervals.size() > 1 && memory[state].conditionName == OP_CODE_CONDITION) {
+				maxOpCode = std::max(maxOpCode, memory[state].conditionMax);
+			}
+		}
+
+		std::vector<MicroProgramCycleCost> opCodeCosts;
+		for (size_t opCode = 0; opCode <= maxOpCode; ++opCode) {
+			std::vector<MicroProgramCycleCost> costs(STATE_COUNT, { 0, 0 });
+			opCodeCosts.push_back(measure(START_STATE, opCode, costs));
+		}
+		return opCodeCosts;
+	}
+
+
+	MicroProgramOptimization MicroProgramOptimizer::optimize() {
+		MicroProgramOptimization optimization;
+
+		analyze();
+		fusionCounts.assign(STATE_COUNT, 0);
+		std::vector<MicroProgramCycleCost> before = measure();
+
+		//hoisting empties states which can be fused afterwards, fusing brings new pairs of states together
+		size_t changes;
+		do {
+			size_t hoisted = hoistALUOperations();
+			size_t fused = fuseStates();
+
+			optimization.hoistedOperations += hoisted;
+			optimization.fusedStates += fused;
+			changes = hoisted + fused;
+		} while (changes != 0);
+
+		optimization.mergedStates = mergeEquivalentStates();
+		optimization.removedStates = removeUnreachableStates();
+
+		std::vector<MicroProgramCycleCost> after = measure();
+
+		//neighbouring operation codes with the same costs share a line of the report
+		for (size_t opCode = 0; opCode < before.size(); ++opCode) {
+			if (!optimization.costs.empty() && optimization.costs.back().before == before[opCode] && optimization.costs.back().after == after[opCode]) {
+				optimization.costs.back().upperOpCode = opCode;
+			}
+			else {
+				optimization.costs.push_back({ opCode, opCode, before[opCode], after[opCode] });
+			}
+		}
+
+		MIMA_CHANNEL_LOG_INFO(MICROCOMPILER, "Optimized microprogram: hoisted {} ALU operations, fused {} states, merged {} and removed {} states", optimization.hoistedOperations, optimization.fusedStates, optimization.mergedStates, optimization.removedStates);
+		return optimization;
+	}
+}
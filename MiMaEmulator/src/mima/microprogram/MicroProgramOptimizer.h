@@ -0,0 +1,104 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//internal classes
+#include "MicroProgram.h"
+
+
+namespace MiMa {
+	//the clock cycles an instruction takes from the start state until it returns to it or halts, over all branches not decided by the operation code
+	struct MicroProgramCycleCost {
+		static constexpr size_t UNBOUNDED = SIZE_MAX;
+
+		size_t minimum;
+		size_t maximum;
+
+		inline bool operator==(const MicroProgramCycleCost& other) const { return minimum == other.minimum && maximum == other.maximum; }
+		inline bool operator!=(const MicroProgramCycleCost& other) const { return !(*this == other); }
+	};
+
+	//the cycle cost of a range of operation codes before and after the optimization
+	struct MicroProgramOpCodeCost {
+		size_t lowerOpCode;
+		size_t upperOpCode;
+		MicroProgramCycleCost before;
+		MicroProgramCycleCost after;
+	};
+
+	//what the optimizer did to a microprogram
+	struct MicroProgramOptimization {
+		size_t hoistedOperations = 0;
+		size_t fusedStates = 0;
+		size_t mergedStates = 0;
+		size_t removedStates = 0;
+
+		std::vector<MicroProgramOpCodeCost> costs;
+
+		//writes the changes and a table of the operation code ranges with their cycle costs before and after
+		void writeReport(std::ostream& output) const;
+	};
+
+
+
+	// ------------------------------------------------
+	// Microprogram optimizer
+	//
+	// Rewrites a compiled microprogram memory so that
+	// every instruction takes at most as many cycles,
+	// with the same effect on the registers, the
+	// memory and devices in every cycle it completes.
+	//
+	// ALU operations are hoisted into the preceding
+	// state and states are fused with the one they
+	// jump to, as long as both fit on the single data
+	// bus of one cycle. Memory accesses keep their
+	// number of cycles, since their duration is only
+	// counted while consecutive states access memory.
+	// Afterwards equivalent states are merged and the
+	// states no longer reachable from the start state
+	// are reset.
+	// ------------------------------------------------
+
+	class MicroProgramOptimizer {
+	public:
+		static constexpr size_t STATE_COUNT = 0x100;
+
+	private:
+		//the first state of every instruction, the optimizer never jumps past it
+		static constexpr uint8_t START_STATE = 0;
+
+		//a pointer to the memory to optimize
+		std::shared_ptr<MicroProgramCodeList[]> memory;
+
+		//the states reachable from the start state and the states jumping to each of them
+		std::vector<bool> reachable;
+		std::vector<std::vector<uint8_t>> predecessors;
+		//the fusions into each state over all passes, see fuseStates
+		std::vector<size_t> fusionCounts;
+
+		void analyze();
+
+		size_t hoistALUOperations();
+		size_t fuseStates();
+		size_t mergeEquivalentStates();
+		size_t removeUnreachableStates();
+
+		bool isAccessingMemory(const uint8_t& state) const;
+		bool isFusable(const uint8_t& state, const MicroProgramCode& code, const uint8_t& following) const;
+
+		//the cycle cost of every operation code, memorized per state while measuring one of them
+		MicroProgramCycleCost measure(const uint8_t& state, const size_t& opCode, std::vector<MicroProgramCycleCost>& costs) const;
+		std::vector<MicroProgramCycleCost> measure() const;
+
+	public:
+		MicroProgramOptimizer(const std::shared_ptr<MicroProgramCodeList[]>& memory);
+
+		MicroProgramOptimization optimize();
+	};
+}
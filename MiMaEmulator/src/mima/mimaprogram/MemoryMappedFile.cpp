@@ -0,0 +1,117 @@
+#include "mimapch.h"
+#include "MemoryMappedFile.h"
+
+//std library
+#include <stdexcept>
+
+//system libraries
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+#ifdef _WIN32
+	MemoryMappedFile::MemoryMappedFile(const std::string& fileName, const size_t& size) : size(size) {
+		fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE) {
+			fileHandle = nullptr;
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to open memory file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to open memory file '{}'", fileName));
+		}
+
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(fileHandle, &fileSize)) {
+			initialSize = ((size_t)fileSize.QuadPart < size) ? (size_t)fileSize.QuadPart : size;
+		}
+
+		//creating a mapping larger than the file grows the file, the new part reads as zeros
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+		if (mappingHandle != nullptr) {
+			data = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		}
+
+		if (data == nullptr) {
+			close();
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to map memory file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to map memory file '{}'", fileName));
+		}
+
+		MIMA_CHANNEL_LOG_INFO(MEMORY, "Mapped memory file '{}'", fileName);
+	}
+
+	void MemoryMappedFile::close() {
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+			data = nullptr;
+		}
+		if (mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+			mappingHandle = nullptr;
+		}
+		if (fileHandle != nullptr) {
+			CloseHandle(fileHandle);
+			fileHandle = nullptr;
+		}
+	}
+
+	void MemoryMappedFile::flush() {
+		FlushViewOfFile(data, size);
+		FlushFileBuffers(fileHandle);
+	}
+#else
+	MemoryMappedFile::MemoryMappedFile(const std::string& fileName, const size_t& size) : size(size) {
+		fileDescriptor = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fileDescriptor < 0) {
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to open memory file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to open memory file '{}'", fileName));
+		}
+
+		//grow the file to the mapped size, the new part reads as zeros without taking up any disk space
+		struct stat fileStatus;
+		if (fstat(fileDescriptor, &fileStatus) != 0 || ((size_t)fileStatus.st_size < size && ftruncate(fileDescriptor, (off_t)size) != 0)) {
+			close();
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to resize memory file '{}' to 0x{:X} bytes", fileName, size);
+			throw std::runtime_error(fmt::format("failed to resize memory file '{}' to 0x{:X} bytes", fileName, size));
+		}
+		initialSize = ((size_t)fileStatus.st_size < size) ? (size_t)fileStatus.st_size : size;
+
+		data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+		if (data == MAP_FAILED) {
+			data = nullptr;
+			close();
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to map memory file '{}'", fileName);
+			throw std::runtime_error(fmt::format("failed to map memory file '{}'", fileName));
+		}
+
+		MIMA_CHANNEL_LOG_INFO(MEMORY, "Mapped memory file '{}'", fileName);
+	}
+
+	void MemoryMappedFile::close() {
+		if (data != nullptr) {
+			munmap(data, size);
+			data = nullptr;
+		}
+		if (fileDescriptor >= 0) {
+			::close(fileDescriptor);
+			fileDescriptor = -1;
+		}
+	}
+
+	void MemoryMappedFile::flush() {
+		msync(data, size, MS_SYNC);
+	}
+#endif
+}
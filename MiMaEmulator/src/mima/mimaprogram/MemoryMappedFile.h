@@ -0,0 +1,50 @@
+#pragma once
+
+//std library
+#include <cstddef>
+#include <string>
+
+
+namespace MiMa {
+	// ------------------------------------------------
+	// Memory mapped file
+	//
+	// Maps a file of a fixed size into the address
+	// space, shared with the file itself, so every
+	// write lands in the file without any explicit
+	// saving and pages which are never touched are
+	// never read from disk.
+	// ------------------------------------------------
+
+	class MemoryMappedFile {
+	private:
+		void* data = nullptr;
+		size_t size = 0;
+		size_t initialSize = 0;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+
+		void close();
+
+	public:
+		//opens (or creates) the given file, growing it to the given size if it is smaller
+		MemoryMappedFile(const std::string& fileName, const size_t& size);
+		~MemoryMappedFile() { close(); }
+
+		MemoryMappedFile(const MemoryMappedFile&) = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+		inline void* getData() const { return data; }
+		inline size_t getSize() const { return size; }
+		//the size of the file before it was grown, everything behind it reads as zeros
+		inline size_t getInitialSize() const { return initialSize; }
+
+		//writes all changes back to the file, blocking until they are on disk
+		void flush();
+	};
+}
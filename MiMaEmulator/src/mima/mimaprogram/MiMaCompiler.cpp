@@ -1,13 +1,19 @@
 #include "mimapch.h"
 #include "MiMaCompiler.h"
 
+//std library
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
 //internal classes
 #include "mima/CompilerException.h"
 
 
 namespace MiMa {
 	const std::regex MiMaMemoryCompiler::assignmentMatcher(R"(\s*(.*?)\s*\=\s*(.*?)\s*)");
-	const std::regex MiMaMemoryCompiler::instructionMatcher(R"(\s*(?:([^\s]+?)\:\s*)?([^\s]+?)(?:\s+([^\s]+?))?\s*)");
+	const std::regex MiMaMemoryCompiler::instructionMatcher(R"(\s*(?:([^\s]+?)\:\s*)?(?:([^\s]+?)(?:\s+([^\s]+?))?)?\s*)");
 
 	const std::regex MiMaMemoryCompiler::identifiers(R"([_a-zA-Z][_a-zA-Z0-9]*)");
 	const std::regex MiMaMemoryCompiler::decNumber(R"(\-?[0-9]+)");
@@ -16,148 +22,329 @@ namespace MiMa {
 
 #define SET_FUNCTION(givenName, name, storage, value) if (givenName == name) { storage = value; return true; }
 
-	bool MiMaMemoryCompiler::addFunction(const std::string& functionName) {
-		if (functionName == "DS")
-			return true;
+	bool MiMaMemoryCompiler::encodeFunction(const std::string& functionName, uint32_t& cell) {
+		SET_FUNCTION(functionName, "HALT", cell, 0xF00000)
+		SET_FUNCTION(functionName, "NOT", cell, 0xF10000)
+		SET_FUNCTION(functionName, "RAR", cell, 0xF20000)
 
-		SET_FUNCTION(functionName, "HALT", (*mimaMemory)[compilationAddress], 0xF00000)
-		SET_FUNCTION(functionName, "NOT", (*mimaMemory)[compilationAddress], 0xF10000)
-		SET_FUNCTION(functionName, "RAR", (*mimaMemory)[compilationAddress], 0xF20000)
+		return false;
+	}
+
+	bool MiMaMemoryCompiler::encodeUnaryFunction(const std::string& functionName, const uint32_t& argument, uint32_t& cell) {
+		SET_FUNCTION(functionName, "DS", cell, argument)
+		SET_FUNCTION(functionName, "LDC", cell, argument)
+		SET_FUNCTION(functionName, "LDV", cell, 0x100000 | argument)
+		SET_FUNCTION(functionName, "STV", cell, 0x200000 | argument)
+		SET_FUNCTION(functionName, "ADD", cell, 0x300000 | argument)
+		SET_FUNCTION(functionName, "AND", cell, 0x400000 | argument)
+		SET_FUNCTION(functionName, "OR", cell, 0x500000 | argument)
+		SET_FUNCTION(functionName, "XOR", cell, 0x600000 | argument)
+		SET_FUNCTION(functionName, "EQL", cell, 0x700000 | argument)
+		SET_FUNCTION(functionName, "JMP", cell, 0x800000 | argument)
+		SET_FUNCTION(functionName, "JMN", cell, 0x900000 | argument)
 
 		return false;
 	}
 
-	bool MiMaMemoryCompiler::addUnaryFunction(const std::string& functionName, const uint32_t& argument) {
-		SET_FUNCTION(functionName, "DS", (*mimaMemory)[compilationAddress], argument)
-		SET_FUNCTION(functionName, "LDC", (*mimaMemory)[compilationAddress], argument)
-		SET_FUNCTION(functionName, "LDV", (*mimaMemory)[compilationAddress], 0x100000 | argument)
-		SET_FUNCTION(functionName, "STV", (*mimaMemory)[compilationAddress], 0x200000 | argument)
-		SET_FUNCTION(functionName, "ADD", (*mimaMemory)[compilationAddress], 0x300000 | argument)
-		SET_FUNCTION(functionName, "AND", (*mimaMemory)[compilationAddress], 0x400000 | argument)
-		SET_FUNCTION(functionName, "OR", (*mimaMemory)[compilationAddress], 0x500000 | argument)
-		SET_FUNCTION(functionName, "XOR", (*mimaMemory)[compilationAddress], 0x600000 | argument)
-		SET_FUNCTION(functionName, "EQL", (*mimaMemory)[compilationAddress], 0x700000 | argument)
-		SET_FUNCTION(functionName, "JMP", (*mimaMemory)[compilationAddress], 0x800000 | argument)
-		SET_FUNCTION(functionName, "JMN", (*mimaMemory)[compilationAddress], 0x900000 | argument)
+
+	bool MiMaMemoryCompiler::parseNumber(const std::string& text, int& value) {
+		//numbers exceeding an int match the patterns as well, but fail to convert like any other invalid value
+		try {
+			if (std::regex_match(text, decNumber)) {
+				value = std::stoi(text, nullptr, 10);
+				MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Interpreted {} as a decimal number", text);
+				return true;
+			}
+			if (std::regex_match(text, hexNumber)) {
+				value = std::stoi(text.substr(1), nullptr, 16);
+				MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Interpreted {} as a hexadecimal number", text);
+				return true;
+			}
+		}
+		catch (const std::out_of_range&) {
+			MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "{} exceeds the range of a number", text);
+		}
 
 		return false;
 	}
 
 
-	void MiMaMemoryCompiler::addLine(const std::string& line) {
+	MiMaMemoryCompiler::CodeLine MiMaMemoryCompiler::parseLine(const std::string& line) {
+		CodeLine result;
+
 		//remove any comments from the code line
 		std::smatch matches;
 		std::string codeLine = line.substr(0, line.find(';'));
-		MIMA_LOG_TRACE("Found code line '{}'", codeLine);
+		MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Found code line '{}'", codeLine);
+
+		//lines without any code don't affect the memory
+		if (std::all_of(codeLine.begin(), codeLine.end(), [](const char& c) { return isspace((unsigned char)c); })) {
+			return result;
+		}
 
 		//attempt to match the line as an assignment
 		if (std::regex_match(codeLine, matches, assignmentMatcher)) {
-			MIMA_LOG_TRACE("Matched code line as assignment");
-			int compilationStart;
+			MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Matched code line as assignment");
+			int assignedValue;
 
-			if (std::regex_match(matches[2].str(), decNumber)) {
-				//dec number from matches[2]
-				compilationStart = std::stoi(matches[2], nullptr, 10);
-				MIMA_LOG_TRACE("Interpreted {} as a decimal number", matches[2].str());
-			}
-			else if (std::regex_match(matches[2].str(), hexNumber)) {
-				//hex number from matches[2].substr(1)
-				compilationStart = std::stoi(matches[2].str().substr(1), nullptr, 16);
-				MIMA_LOG_TRACE("Interpreted {} as a hexadecimal number", matches[2].str());
-			}
-			else {
-				//invalid compilation start from matches[2]
-				MIMA_LOG_ERROR("Failed to convert value {} to a decimal or hexadecimal number", matches[2].str());
+			if (!parseNumber(matches[2].str(), assignedValue)) {
+				//invalid value from matches[2]
+				MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "Failed to convert value {} to a decimal or hexadecimal number", matches[2].str());
 				throw CompilerException(fmt::format("failed to convert value {} to a decimal or hexadecimal number", matches[2].str()));
 			}
 
 			if (matches[1] == "*") {
 				//range check compilation start
-				if (compilationStart < 0) {
+				if (assignedValue < 0) {
 					//compilation start may not be negative
-					MIMA_LOG_ERROR("The compilation start point may not be assigned the negative number 0x{:X}", compilationStart);
-					throw CompilerException(fmt::format("the compilation start point may not be assigned the negative number 0x{:X}", compilationStart));
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The compilation start point may not be assigned the negative number 0x{:X}", assignedValue);
+					throw CompilerException(fmt::format("the compilation start point may not be assigned the negative number 0x{:X}", assignedValue));
 				}
-				if (compilationStart >= DEFAULT_MEMORY_CAPACITY) {
+				if (assignedValue >= DEFAULT_MEMORY_CAPACITY) {
 					//compilation start may not exceed memory capacity
-					MIMA_LOG_ERROR("The compilation start point 0x{:X} may not exceed the memory capacity 0x{:X}", compilationStart, DEFAULT_MEMORY_CAPACITY);
-					throw CompilerException(fmt::format("the compilation start point 0x{:X} may not exceed the memory capacity 0x{:X}", compilationStart, DEFAULT_MEMORY_CAPACITY));
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The compilation start point 0x{:X} may not exceed the memory capacity 0x{:X}", assignedValue, DEFAULT_MEMORY_CAPACITY);
+					throw CompilerException(fmt::format("the compilation start point 0x{:X} may not exceed the memory capacity 0x{:X}", assignedValue, DEFAULT_MEMORY_CAPACITY));
 				}
 
 				//set compilation start
-				compilationAddress = compilationStart;
-				MIMA_LOG_TRACE("Set compilation start to 0x{:X}", compilationAddress);
-				return;
+				result.type = CodeLine::Type::ORIGIN;
+				result.value = assignedValue;
+				return result;
 			}
 			else if (std::regex_match(matches[1].str(), identifiers)) {
 				//constant definition
-				//identifier reservation
-				return;
+				result.type = CodeLine::Type::CONSTANT;
+				result.value = assignedValue;
+				result.symbol = matches[1].str();
+				return result;
 			}
 			
 			//unknown assignment to matches[1]
-			MIMA_LOG_ERROR("'{}' is not a valid identifier to have a value assigned too", matches[1].str());
+			MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "'{}' is not a valid identifier to have a value assigned too", matches[1].str());
 			throw CompilerException(fmt::format("'{}' is not a valid identifier to have a value assigned too", matches[1].str()));
 		}
 
 		//attempt to match the line as a unary instruction
 		if (std::regex_match(codeLine, matches, instructionMatcher)) {
-			if (matches[1] != "") {
-				//add label from matches[1]
+			if (matches[1].matched) {
+				//label from matches[1] marks the current compilation address
+				if (!std::regex_match(matches[1].str(), identifiers)) {
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "'{}' is not a valid label", matches[1].str());
+					throw CompilerException(fmt::format("'{}' is not a valid label", matches[1].str()));
+				}
+
+				result.symbol = matches[1].str();
 			}
 
-			if (matches[3] != "") {
+			if (!matches[2].matched) {
+				//line only consists of a label
+				return result;
+			}
+
+			if (matches[3].matched) {
 				//instruction has an argument, add unary instruction from matches[2] with argument matches[3]
-				uint32_t argument;
+				int argument = 0;
+				result.word = matches[2] == "DS";
 
-				if (std::regex_match(matches[3].str(), decNumber)) {
-					//dec number from matches[3]
-					argument = std::stoi(matches[3], nullptr, 10);
-					MIMA_LOG_TRACE("Interpreted {} as a decimal number", matches[3].str());
-				}
-				else if (std::regex_match(matches[3].str(), hexNumber)) {
-					//hex number from matches[3].substr(1)
-					argument = std::stoi(matches[3].str().substr(1), nullptr, 16);
-					MIMA_LOG_TRACE("Interpreted {} as a hexadecimal number", matches[3].str());
+				if (std::regex_match(matches[3].str(), identifiers)) {
+					//symbol from matches[3], its value is added once it is known
+					result.reference = matches[3].str();
 				}
-				else {
-					//invalid number from matches[2]
-					MIMA_LOG_ERROR("Failed to convert value {} to a decimal or hexadecimal number", matches[3].str());
+				else if (!parseNumber(matches[3].str(), argument)) {
+					//invalid number from matches[3]
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "Failed to convert value {} to a decimal or hexadecimal number", matches[3].str());
 					throw CompilerException(fmt::format("failed to convert value {} to a decimal or hexadecimal number", matches[3].str()));
 				}
+				else if (!fitsArgument(result.word, (uint32_t)argument)) {
+					//the argument of an instruction shares the cell with the op code
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The argument {} of '{}' doesn't fit into {} bits", matches[3].str(), matches[2].str(), result.word ? 24 : 20);
+					throw CompilerException(fmt::format("the argument {} of '{}' doesn't fit into {} bits", matches[3].str(), matches[2].str(), result.word ? 24 : 20));
+				}
 
-				if (addUnaryFunction(matches[2], argument)) {
-					compilationAddress++;
+				if (encodeUnaryFunction(matches[2], argument, result.value)) {
+					result.type = CodeLine::Type::CELL;
 				}
 				else {
 					//invalid function found
-					MIMA_LOG_ERROR("Unknown parameterizerd instruction '{}'", matches[2].str());
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "Unknown parameterizerd instruction '{}'", matches[2].str());
 					throw CompilerException(fmt::format("unknown parameterizerd instruction '{}'", matches[2].str()));
 				}
 			}
 			else {
 				//instruction has no argument, add function from matches[2]
-				if (addFunction(matches[2])) {
-					compilationAddress++;
+				if (matches[2] == "DS") {
+					//reserve a cell without changing it
+					result.type = CodeLine::Type::RESERVE;
+				}
+				else if (encodeFunction(matches[2], result.value)) {
+					result.type = CodeLine::Type::CELL;
 				}
 				else {
 					//invalid function found
-					MIMA_LOG_ERROR("Unknown instruction '{}'", matches[2].str());
+					MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "Unknown instruction '{}'", matches[2].str());
 					throw CompilerException(fmt::format("unknown instruction '{}'", matches[2].str()));
 				}
 			}
 
-			return;
+			return result;
 		}
 
 		//no valid match
-		MIMA_LOG_ERROR("Failed to compiler '{}'", codeLine);
+		MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "Failed to compiler '{}'", codeLine);
 		throw CompilerException(fmt::format("failed to compiler '{}'", codeLine));
 	}
 
 
+	void MiMaMemoryCompiler::defineSymbol(const std::string& symbol, const uint32_t& value) {
+		if (!symbols.insert({ symbol, value }).second) {
+			MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The symbol '{}' is defined more than once", symbol);
+			throw CompilerException(fmt::format("the symbol '{}' is defined more than once", symbol));
+		}
+
+		MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Defined symbol '{}' as 0x{:X}", symbol, value);
+	}
+
+
+	void MiMaMemoryCompiler::writeCell(const uint32_t& address, const uint32_t& cell) {
+		(*mimaMemory)[address] = cell;
+
+		//the memory wraps addresses around like the MiMa
+		std::unordered_map<uint32_t, size_t>::iterator fixupIndex = fixupIndices.find(address & DEFAULT_MEMORY_CAPACITY);
+		if (fixupIndex != fixupIndices.end()) {
+			fixups[fixupIndex->second].overwritten = true;
+			fixupIndices.erase(fixupIndex);
+		}
+	}
+
+
+	void MiMaMemoryCompiler::addFixup(Fixup&& fixup) {
+		fixupIndices[fixup.address & DEFAULT_MEMORY_CAPACITY] = fixups.size();
+		fixups.push_back(std::move(fixup));
+	}
+
+
+	void MiMaMemoryCompiler::addLine(const std::string& line) {
+		CodeLine codeLine = parseLine(line);
+		lineNumber++;
+
+		//labels mark the address of the cell on their line
+		if (codeLine.type == CodeLine::Type::CONSTANT) {
+			defineSymbol(codeLine.symbol, codeLine.value);
+		}
+		else if (!codeLine.symbol.empty()) {
+			defineSymbol(codeLine.symbol, compilationAddress);
+		}
+
+		switch (codeLine.type) {
+		case CodeLine::Type::EMPTY:
+		case CodeLine::Type::CONSTANT:
+			break;
+		case CodeLine::Type::ORIGIN:
+			compilationAddress = codeLine.value;
+			MIMA_CHANNEL_LOG_TRACE(ASSEMBLER, "Set compilation start to 0x{:X}", compilationAddress);
+			break;
+		case CodeLine::Type::RESERVE:
+			compilationAddress++;
+			break;
+		case CodeLine::Type::CELL:
+			if (codeLine.reference.empty()) {
+				writeCell(compilationAddress, codeLine.value);
+			}
+			else {
+				//the symbol might not be defined yet, so the cell is written once all symbols are known
+				addFixup({ compilationAddress, codeLine.value, std::move(codeLine.reference), codeLine.word });
+			}
+			if (sourceMap) {
+				size_t codeStart = line.find_first_not_of(" \t");
+				size_t codeEnd = line.find_last_not_of(" \t\r");
+				(*sourceMap)[compilationAddress] = { lineNumber, line.substr(codeStart, codeEnd - codeStart + 1) };
+			}
+			compilationAddress++;
+			break;
+		}
+	}
+
+
 	void MiMaMemoryCompiler::finish() {
+		//patch every cell referring to a symbol, now that all symbols are defined
+		for (const Fixup& fixup : fixups) {
+			MiMaSymbolTable::const_iterator symbol = symbols.find(fixup.symbol);
+
+			if (symbol == symbols.end()) {
+				MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The symbol '{}' referred to at 0x{:X} is never defined", fixup.symbol, fixup.address);
+				throw CompilerException(fmt::format("the symbol '{}' referred to at 0x{:X} is never defined", fixup.symbol, fixup.address));
+			}
+			if (!fitsArgument(fixup.word, symbol->second)) {
+				//the value of an instruction argument shares the cell with the op code, negative constants are stored as large unsigned values
+				MIMA_CHANNEL_LOG_ERROR(ASSEMBLER, "The value 0x{:X} of the symbol '{}' referred to at 0x{:X} doesn't fit into {} bits", symbol->second, fixup.symbol, fixup.address, fixup.word ? 24 : 20);
+				throw CompilerException(fmt::format("the value 0x{:X} of the symbol '{}' referred to at 0x{:X} doesn't fit into {} bits", symbol->second, fixup.symbol, fixup.address, fixup.word ? 24 : 20));
+			}
+
+			if (!fixup.overwritten) {
+				(*mimaMemory)[fixup.address] = fixup.cell | symbol->second;
+			}
+		}
 
+		fixups.clear();
+		fixupIndices.clear();
+	}
+
+
+
+	// -----------------------------
+	// Parallel compilation of chunks
+	// -----------------------------
+
+	//collects the memory block of a written cell, consecutive cells mostly share their block
+	static void reserveBlock(std::vector<size_t>& blockIndices, const uint32_t& address) {
+		//the memory wraps addresses around like the MiMa
+		size_t block = (address & DEFAULT_MEMORY_CAPACITY) / MiMaMemory::BLOCK_SIZE;
+
+		if (blockIndices.empty() || blockIndices.back() != block) {
+			blockIndices.push_back(block);
+		}
+	}
+
+
+	void MiMaMemoryCompiler::compileChunk(const std::string_view& chunk, std::vector<CompiledSegment>& segments) {
+		//the first segment continues wherever the previous chunk stopped
+		segments.assign(1, { true, 0, {}, 0, {}, {} });
+
+		size_t lineStart = 0;
+		while (lineStart < chunk.size()) {
+			size_t lineEnd = std::min(chunk.find('\n', lineStart), chunk.size());
+			CodeLine codeLine = parseLine(std::string(chunk.substr(lineStart, lineEnd - lineStart)));
+			lineStart = lineEnd + 1;
+
+			CompiledSegment& segment = segments.back();
+			if (codeLine.type == CodeLine::Type::CONSTANT) {
+				segment.symbols.push_back({ std::move(codeLine.symbol), codeLine.value, false });
+			}
+			else if (!codeLine.symbol.empty()) {
+				segment.symbols.push_back({ std::move(codeLine.symbol), segment.size, true });
+			}
+
+			switch (codeLine.type) {
+			case CodeLine::Type::EMPTY:
+			case CodeLine::Type::CONSTANT:
+				break;
+			case CodeLine::Type::ORIGIN:
+				segments.push_back({ false, codeLine.value, {}, 0, {}, {} });
+				break;
+			case CodeLine::Type::RESERVE:
+				segment.size++;
+				break;
+			case CodeLine::Type::CELL:
+				if (codeLine.reference.empty()) {
+					segment.cells.push_back({ segment.size, codeLine.value });
+				}
+				else {
+					segment.fixups.push_back({ segment.size, codeLine.value, std::move(codeLine.reference), codeLine.word });
+				}
+				segment.size++;
+				break;
+			}
+		}
 	}
 
 
@@ -167,45 +354,224 @@ namespace MiMa {
 	// ---------------------
 
 	//Interface: read input from a pointer to a char array containing the code for the program.
-	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compile(const std::string& mimaProgramCode) {
-		MIMA_LOG_INFO("Compiling mimaprogram from given code string");
-		MiMaMemoryCompiler compiler;
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compile(const std::string& mimaProgramCode, MiMaSymbolTable* symbolTable, MiMaSourceMap* sourceMap) {
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Compiling mimaprogram from given code string");
+		MiMaMemoryCompiler compiler(sourceMap);
 
 		std::istringstream mimaProgramCodeStream(mimaProgramCode);
 		std::string codeLine;
 		while (std::getline(mimaProgramCodeStream, codeLine)) {
 			compiler.addLine(codeLine);
 		}
+		compiler.finish();
+
+		if (symbolTable) {
+			*symbolTable = std::move(compiler.symbols);
+		}
 
 		return compiler.mimaMemory;
 	}
 
 	//Interface: read input from an input providing the code for the program.
-	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compile(std::istream& mimaProgramCode) {
-		MIMA_LOG_INFO("Compiling mimaprogram from given input");
-		MiMaMemoryCompiler compiler;
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compile(std::istream& mimaProgramCode, MiMaSymbolTable* symbolTable, MiMaSourceMap* sourceMap) {
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Compiling mimaprogram from given input");
+		MiMaMemoryCompiler compiler(sourceMap);
 
 		std::string codeLine;
 		while (std::getline(mimaProgramCode, codeLine)) {
 			compiler.addLine(codeLine);
 		}
+		compiler.finish();
+
+		if (symbolTable) {
+			*symbolTable = std::move(compiler.symbols);
+		}
 
 		return compiler.mimaMemory;
 	}
 
 
 	//Interface: read input from a file containing the code for the program.
-	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compileFile(const std::string& fileName) {
-		MIMA_LOG_INFO("Compiling mimaprogram from an input file");
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compileFile(const std::string& fileName, MiMaSymbolTable* symbolTable, MiMaSourceMap* sourceMap) {
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Compiling mimaprogram from an input file");
 
 		std::ifstream fileInputStream(fileName);
 		if (!fileInputStream.good()) {
 			throw CompilerException(fmt::format("Failed to open mima program code file '{}'", fileName));
 		}
 
-		std::shared_ptr<MiMaMemory> program = compile(fileInputStream);
+		std::shared_ptr<MiMaMemory> program = compile(fileInputStream, symbolTable, sourceMap);
 
 		fileInputStream.close();
 		return program;
 	}
+
+
+	//Interface: compile a code string in parallel chunks, each chunk ending at a line break.
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compileParallel(const std::string& mimaProgramCode, size_t threadCount, MiMaSymbolTable* symbolTable) {
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Compiling mimaprogram from given code string on {} threads", threadCount);
+
+		//split the code into one chunk per thread, moving each chunk border behind the next line break
+		std::vector<std::string_view> chunks;
+		std::string_view code(mimaProgramCode);
+
+		size_t chunkStart = 0;
+		for (size_t i = 1; i <= threadCount && chunkStart < code.size(); ++i) {
+			size_t chunkEnd = (i == threadCount) ? code.size() : std::max(chunkStart, code.size() * i / threadCount);
+			chunkEnd = std::min(code.find('\n', chunkEnd), code.size());
+
+			chunks.push_back(code.substr(chunkStart, chunkEnd - chunkStart));
+			chunkStart = chunkEnd + 1;
+		}
+
+		//compile all chunks in parallel, keeping the first exception of each chunk and the segments compiled before it
+		std::vector<std::vector<CompiledSegment>> compiledChunks(chunks.size());
+		std::vector<std::exception_ptr> chunkErrors(chunks.size());
+		std::vector<std::thread> workers;
+		//the workers log like the calling thread
+		Logger* logger = &currentLog();
+
+		try {
+			for (size_t i = 0; i < chunks.size(); ++i) {
+				workers.emplace_back([&chunks, &compiledChunks, &chunkErrors, logger, i]() {
+					MIMA_LOG_SCOPE(logger);
+					try {
+						compileChunk(chunks[i], compiledChunks[i]);
+					}
+					catch (...) {
+						chunkErrors[i] = std::current_exception();
+					}
+				});
+			}
+		}
+		catch (...) {
+			//a thread failed to start, the started ones refer to the chunks and have to finish before they go out of scope
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+			throw;
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		//resolve the start of relative segments from the end of the segment before them
+		//and define the symbols in code order, so duplicates are reported just like in sequential compilation
+		MiMaMemoryCompiler compiler;
+		std::vector<size_t> blockIndices;
+		uint32_t compilationAddress = 0;
+
+		for (size_t i = 0; i < compiledChunks.size(); ++i) {
+			for (CompiledSegment& segment : compiledChunks[i]) {
+				if (segment.relative) {
+					segment.start = compilationAddress;
+				}
+				compilationAddress = segment.start + segment.size;
+
+				for (SymbolDefinition& definition : segment.symbols) {
+					compiler.defineSymbol(definition.symbol, definition.isLabel ? segment.start + definition.value : definition.value);
+				}
+
+				//only the blocks of written cells, blocks covered by reserved cells alone stay empty like in sequential compilation
+				for (const std::pair<uint32_t, uint32_t>& cell : segment.cells) {
+					reserveBlock(blockIndices, segment.start + cell.first);
+				}
+				for (Fixup& fixup : segment.fixups) {
+					fixup.address += segment.start;
+					reserveBlock(blockIndices, fixup.address);
+				}
+			}
+
+			//the segments hold the lines before the error of their chunk, so all errors of earlier lines were reported already
+			//and the error is reported in the same order as by the sequential compilation
+			if (chunkErrors[i]) {
+				std::rethrow_exception(chunkErrors[i]);
+			}
+		}
+
+		//create all memory blocks up front in an order that keeps the memory search tree balanced,
+		//then merge the segments in code order, so later cells override earlier ones just like in sequential compilation
+		std::shared_ptr<MiMaMemory> mimaMemory = compiler.mimaMemory;
+
+		std::sort(blockIndices.begin(), blockIndices.end());
+		blockIndices.erase(std::unique(blockIndices.begin(), blockIndices.end()), blockIndices.end());
+		mimaMemory->reserveBlocks(blockIndices);
+
+		for (std::vector<CompiledSegment>& compiledChunk : compiledChunks) {
+			for (CompiledSegment& segment : compiledChunk) {
+				for (const std::pair<uint32_t, uint32_t>& cell : segment.cells) {
+					compiler.writeCell(segment.start + cell.first, cell.second);
+				}
+				//the cells of a segment don't overlap, so only the cells of later segments override its fixups
+				for (Fixup& fixup : segment.fixups) {
+					compiler.addFixup(std::move(fixup));
+				}
+			}
+		}
+		compiler.finish();
+
+		if (symbolTable) {
+			*symbolTable = std::move(compiler.symbols);
+		}
+
+		return mimaMemory;
+	}
+
+	//Interface: compile an input providing the code for the program in parallel chunks.
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compileParallel(std::istream& mimaProgramCode, size_t threadCount, MiMaSymbolTable* symbolTable) {
+		std::string code((std::istreambuf_iterator<char>(mimaProgramCode)), std::istreambuf_iterator<char>());
+		return compileParallel(code, threadCount, symbolTable);
+	}
+
+
+	//Interface: compile a file containing the code for the program in parallel chunks.
+	std::shared_ptr<MiMaMemory> MiMaMemoryCompiler::compileFileParallel(const std::string& fileName, size_t threadCount, MiMaSymbolTable* symbolTable) {
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Compiling mimaprogram from an input file in parallel");
+
+		std::ifstream fileInputStream(fileName);
+		if (!fileInputStream.good()) {
+			throw CompilerException(fmt::format("Failed to open mima program code file '{}'", fileName));
+		}
+
+		std::shared_ptr<MiMaMemory> program = compileParallel(fileInputStream, threadCount, symbolTable);
+
+		fileInputStream.close();
+		return program;
+	}
+
+
+	// -------------
+	// Symbol export
+	// -------------
+
+	void MiMaMemoryCompiler::writeSymbols(std::ostream& output, const MiMaSymbolTable& symbolTable) {
+		//negative constants are stored as large unsigned values, they are written signed ($-5), so the assembler can read them back
+		std::vector<std::pair<int32_t, std::string>> sortedSymbols;
+		sortedSymbols.reserve(symbolTable.size());
+
+		for (const std::pair<const std::string, uint32_t>& symbol : symbolTable) {
+			sortedSymbols.push_back({ (int32_t)symbol.second, symbol.first });
+		}
+		std::sort(sortedSymbols.begin(), sortedSymbols.end());
+
+		for (const std::pair<int32_t, std::string>& symbol : sortedSymbols) {
+			output << fmt::format("{} = ${:X}\n", symbol.second, symbol.first);
+		}
+	}
+
+	void MiMaMemoryCompiler::writeSymbolFile(const std::string& fileName, const MiMaSymbolTable& symbolTable) {
+		MIMA_CHANNEL_LOG_INFO(ASSEMBLER, "Writing {} symbols to an output file", symbolTable.size());
+
+		std::ofstream fileOutputStream(fileName);
+		if (!fileOutputStream.good()) {
+			throw CompilerException(fmt::format("Failed to open symbol file '{}'", fileName));
+		}
+
+		writeSymbols(fileOutputStream, symbolTable);
+		fileOutputStream.close();
+	}
 }
@@ -4,14 +4,32 @@
 #include <fstream>
 #include <istream>
 #include <memory>
+#include <ostream>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 //internal classes
 #include "mima/MinimalMachine.h"
 
 
 namespace MiMa {
+	//maps the names of labels and constants to their values
+	using MiMaSymbolTable = std::unordered_map<std::string, uint32_t>;
+
+	//the line of code a memory cell was compiled from
+	struct SourceLine {
+		size_t lineNumber; //starting at 1
+		std::string code;
+	};
+
+	//maps the addresses of all compiled cells to their line of code
+	using MiMaSourceMap = std::unordered_map<uint32_t, SourceLine>;
+
+
 	class MiMaMemoryCompiler {
 	private:
 		static const std::regex assignmentMatcher;
@@ -21,26 +39,115 @@ namespace MiMa {
 		static const std::regex decNumber;
 		static const std::regex hexNumber;
 
+	private:
+		//the effect a single line of code has on the compiled memory
+		struct CodeLine {
+			enum class Type { EMPTY, ORIGIN, CONSTANT, RESERVE, CELL };
+
+			Type type = Type::EMPTY;
+			uint32_t value = 0;
+
+			std::string symbol;    //label or constant defined by this line
+			std::string reference; //symbol whose value has to be added to the cell once it is known
+			bool word = false;     //the argument is a whole data word (DS), not the 20 bit argument of an instruction
+		};
+
+		//a cell whose argument refers to a symbol, patched in place once all symbols are defined
+		struct Fixup {
+			uint32_t address;
+			uint32_t cell;
+			std::string symbol;
+			bool word;
+			bool overwritten = false; //a later line wrote the cell, so only the symbol is checked
+		};
+
+		//a symbol defined within a chunk of code, labels are only known relative to the start of their segment
+		struct SymbolDefinition {
+			std::string symbol;
+			uint32_t value;
+			bool isLabel; //value is an offset from the segment start
+		};
+
+		//a run of consecutive cells compiled from one chunk of code, starting at a compilation start point (origin)
+		//or, if relative, at wherever the previous chunk stopped compiling
+		struct CompiledSegment {
+			bool relative;
+			uint32_t start;
+			std::vector<std::pair<uint32_t, uint32_t>> cells; //(offset from start, cell value)
+			uint32_t size = 0;
+
+			std::vector<SymbolDefinition> symbols;
+			std::vector<Fixup> fixups; //addresses are offsets from start
+		};
+
 	private:
 		uint32_t compilationAddress = 0;
 		std::shared_ptr<MiMaMemory> mimaMemory = std::make_shared<MiMaMemory>();
 
+		MiMaSymbolTable symbols;
+		std::vector<Fixup> fixups;
+		std::unordered_map<uint32_t, size_t> fixupIndices; //latest fixup of each address
+
+		size_t lineNumber = 0;
+		MiMaSourceMap* sourceMap = nullptr; //only filled if requested
+
 	private:
-		bool addFunction(const std::string& functionName);
-		bool addUnaryFunction(const std::string& functionName, const uint32_t& argument);
+		static bool encodeFunction(const std::string& functionName, uint32_t& cell);
+		static bool encodeUnaryFunction(const std::string& functionName, const uint32_t& argument, uint32_t& cell);
+
+		static bool parseNumber(const std::string& text, int& value);
+		//data words take any signed or unsigned 24 bit number, instruction arguments only 20 bit addresses
+		static inline bool fitsArgument(const bool& word, const uint32_t& value) { return word ? (value <= 0xFFFFFF || value >= 0xFF800000) : value <= DEFAULT_MEMORY_CAPACITY; }
+		static CodeLine parseLine(const std::string& line);
+		//compiles the chunk into the segments, which hold all lines before the error if it throws
+		static void compileChunk(const std::string_view& chunk, std::vector<CompiledSegment>& segments);
+
+		void defineSymbol(const std::string& symbol, const uint32_t& value);
+		//cells are written in code order, so later lines override earlier ones whether they refer to a symbol or not
+		void writeCell(const uint32_t& address, const uint32_t& cell);
+		void addFixup(Fixup&& fixup);
 
 	public:
+		MiMaMemoryCompiler(MiMaSourceMap* sourceMap = nullptr) : sourceMap(sourceMap) {}
+
 		void addLine(const std::string& line);
 
+		//resolves all symbol references, has to be called once all lines have been added
 		void finish();
 
+		inline const std::shared_ptr<MiMaMemory>& getMemory() const { return mimaMemory; }
+		inline const MiMaSymbolTable& getSymbols() const { return symbols; }
+
 		// ------------------------------------------------------
 		// Compilation utility methods
 		// Use these for simple compilation of common input types
+		//
+		// If symbolTable is given, the labels and constants of
+		// the program are exported into it, if sourceMap is
+		// given, the source line of every compiled cell
 		// ------------------------------------------------------
-		static std::shared_ptr<MiMaMemory> compile(const std::string& mimaProgramCode);
-		static std::shared_ptr<MiMaMemory> compile(std::istream& mimaProgramCode);
+		static std::shared_ptr<MiMaMemory> compile(const std::string& mimaProgramCode, MiMaSymbolTable* symbolTable = nullptr, MiMaSourceMap* sourceMap = nullptr);
+		static std::shared_ptr<MiMaMemory> compile(std::istream& mimaProgramCode, MiMaSymbolTable* symbolTable = nullptr, MiMaSourceMap* sourceMap = nullptr);
+
+		static std::shared_ptr<MiMaMemory> compileFile(const std::string& fileName, MiMaSymbolTable* symbolTable = nullptr, MiMaSourceMap* sourceMap = nullptr);
 
-		static std::shared_ptr<MiMaMemory> compileFile(const std::string& fileName);
+		// ------------------------------------------------------
+		// Parallel compilation utility methods
+		// Split large inputs into chunks compiled on threadCount
+		// threads (0 = one per hardware thread), producing the
+		// same memory as the sequential methods above
+		// ------------------------------------------------------
+		static std::shared_ptr<MiMaMemory> compileParallel(const std::string& mimaProgramCode, size_t threadCount = 0, MiMaSymbolTable* symbolTable = nullptr);
+		static std::shared_ptr<MiMaMemory> compileParallel(std::istream& mimaProgramCode, size_t threadCount = 0, MiMaSymbolTable* symbolTable = nullptr);
+
+		static std::shared_ptr<MiMaMemory> compileFileParallel(const std::string& fileName, size_t threadCount = 0, MiMaSymbolTable* symbolTable = nullptr);
+
+		// ------------------------------------------------------
+		// Symbol export
+		// Writes one constant definition per symbol, ordered by
+		// value, so the output can be prepended to other programs
+		// ------------------------------------------------------
+		static void writeSymbols(std::ostream& output, const MiMaSymbolTable& symbolTable);
+		static void writeSymbolFile(const std::string& fileName, const MiMaSymbolTable& symbolTable);
 	};
 }
@@ -2,12 +2,146 @@
 #include "MiMaMemory.h"
 
 namespace MiMa {
-	const std::function<std::shared_ptr<MiMaMemory::MemoryBlock>(void)> MiMaMemory::emptyMemoryBlockConstructor = std::make_shared<MiMaMemory::MemoryBlock>;
+	std::atomic<uint64_t> MiMaMemory::nextId(1);
+
+	MiMaMemory::MiMaMemory(const MiMaMemory& other) :
+		memory(other.memory),
+		dirtyBlocks(other.dirtyBlocks),
+		restoredImageId(other.restoredImageId)
+	{
+		if (other.mappedBlocks) {
+			other.forEachBlockInRange(0, DEFAULT_MEMORY_CAPACITY + 1, [this](const size_t& blockStart, const MemoryBlock& block) {
+				if (!block.isEmpty()) {
+					memory.find(blockStart / BLOCK_SIZE) = block;
+				}
+			});
+		}
+	}
+
 
 	MemoryCell& MiMaMemory::operator[](const size_t& index) {
-		size_t offset = index % MiMaMemory::MemoryBlock::MEMORY_BLOCK_SIZE;
-		size_t blockIndex = (index - offset) / MiMaMemory::MemoryBlock::MEMORY_BLOCK_SIZE;
-		
-		return (*(memory.find(blockIndex)))[offset];
+		size_t address = index & DEFAULT_MEMORY_CAPACITY;
+		size_t offset = address % MiMaMemory::MemoryBlock::MEMORY_BLOCK_SIZE;
+		size_t blockIndex = (address - offset) / MiMaMemory::MemoryBlock::MEMORY_BLOCK_SIZE;
+
+		if (mappedBlocks) {
+			markPopulated(blockIndex);
+			return mappedBlocks[blockIndex][offset];
+		}
+
+		return memory.find(blockIndex)[offset];
+	}
+
+	MemoryCell MiMaMemory::get(const size_t& index) const {
+		size_t address = index & DEFAULT_MEMORY_CAPACITY;
+		const MemoryBlock* block = findBlock(address / BLOCK_SIZE);
+
+		return (block == nullptr) ? MemoryCell() : (*block)[address % BLOCK_SIZE];
+	}
+
+
+	void MiMaMemory::reserveBlocks(const std::vector<size_t>& blockIndices, const size_t& lower, const size_t& upper) {
+		//all blocks of file backed memory exist already
+		if (lower >= upper || mappedBlocks) {
+			return;
+		}
+
+		//create the median block first, so it becomes the root of the sub-tree holding the blocks in [lower, upper)
+		size_t median = lower + (upper - lower) / 2;
+		memory.find(blockIndices[median]);
+
+		reserveBlocks(blockIndices, lower, median);
+		reserveBlocks(blockIndices, median + 1, upper);
+	}
+
+
+	void MiMaMemory::restore(const MiMaMemory& image) {
+		static const MemoryBlock emptyBlock;
+
+		if (restoredImageId == image.id) {
+			//all clean blocks still hold the content of the image
+			forEachDirtyBlock([this, &image](const size_t& blockStart) {
+				const MemoryBlock* imageBlock = image.findBlock(blockStart / BLOCK_SIZE);
+				getBlock(blockStart / BLOCK_SIZE) = (imageBlock == nullptr) ? emptyBlock : *imageBlock;
+			});
+		}
+		else {
+			//empty all blocks not in the image and copy all blocks of the image
+			forEachBlockInRange(0, DEFAULT_MEMORY_CAPACITY + 1, [this, &image](const size_t& blockStart, const MemoryBlock&) {
+				if (image.findBlock(blockStart / BLOCK_SIZE) == nullptr) {
+					getBlock(blockStart / BLOCK_SIZE) = emptyBlock;
+				}
+			});
+			image.forEachBlockInRange(0, DEFAULT_MEMORY_CAPACITY + 1, [this](const size_t& blockStart, const MemoryBlock& imageBlock) {
+				getBlock(blockStart / BLOCK_SIZE) = imageBlock;
+			});
+		}
+
+		restoredImageId = image.id;
+		clearDirty();
+	}
+
+
+	std::shared_ptr<MiMaMemory> MiMaMemory::mapFile(const std::string& fileName) {
+		//the file holds the blocks exactly as they are laid out in memory
+		static_assert(sizeof(MemoryCell) == sizeof(uint32_t), "memory cells have to be stored as 32 bit words");
+		static_assert(sizeof(MemoryBlock) == BLOCK_SIZE * sizeof(MemoryCell), "memory blocks have to be stored without padding");
+
+		std::shared_ptr<MiMaMemory> mimaMemory = std::make_shared<MiMaMemory>();
+		mimaMemory->mappedFile = std::make_shared<MemoryMappedFile>(fileName, BLOCK_COUNT * sizeof(MemoryBlock));
+		mimaMemory->mappedBlocks = static_cast<MemoryBlock*>(mimaMemory->mappedFile->getData());
+
+		//only the part of the file which existed before can hold data, a new file isn't read at all
+		mimaMemory->populatedBlocks.assign(BLOCK_COUNT / 64, 0);
+		size_t initialBlocks = (mimaMemory->mappedFile->getInitialSize() + sizeof(MemoryBlock) - 1) / sizeof(MemoryBlock);
+		for (size_t blockIndex = 0; blockIndex < initialBlocks; ++blockIndex) {
+			if (!mimaMemory->mappedBlocks[blockIndex].isEmpty()) {
+				mimaMemory->markPopulated(blockIndex);
+			}
+		}
+
+		return mimaMemory;
+	}
+
+
+	std::vector<MemoryDifference> diff(const MiMaMemory& left, const MiMaMemory& right, const bool& onlyDirty) {
+		static const MiMaMemory::MemoryBlock emptyBlock;
+		std::vector<MemoryDifference> differences;
+
+		//compares the block starting at the given address, treating blocks which aren't populated as empty
+		auto compareBlock = [&left, &right, &differences](const size_t& blockStart) {
+			const MiMaMemory::MemoryBlock* leftBlock = left.findBlock(blockStart / MiMaMemory::BLOCK_SIZE);
+			const MiMaMemory::MemoryBlock* rightBlock = right.findBlock(blockStart / MiMaMemory::BLOCK_SIZE);
+			const MiMaMemory::MemoryBlock& leftCells = (leftBlock == nullptr) ? emptyBlock : *leftBlock;
+			const MiMaMemory::MemoryBlock& rightCells = (rightBlock == nullptr) ? emptyBlock : *rightBlock;
+
+			if (leftCells == rightCells) {
+				return;
+			}
+
+			for (size_t i = 0; i < MiMaMemory::BLOCK_SIZE; ++i) {
+				if (leftCells[i] != rightCells[i]) {
+					differences.push_back({ blockStart + i, leftCells[i], rightCells[i] });
+				}
+			}
+		};
+
+		if (onlyDirty) {
+			left.forEachDirtyBlock(compareBlock);
+			return differences;
+		}
+
+		//every block populated in left, then the blocks only populated in right
+		left.forEachBlockInRange(0, DEFAULT_MEMORY_CAPACITY + 1, [&compareBlock](const size_t& blockStart, const MiMaMemory::MemoryBlock&) {
+			compareBlock(blockStart);
+		});
+		right.forEachBlockInRange(0, DEFAULT_MEMORY_CAPACITY + 1, [&left, &compareBlock](const size_t& blockStart, const MiMaMemory::MemoryBlock&) {
+			if (left.findBlock(blockStart / MiMaMemory::BLOCK_SIZE) == nullptr) {
+				compareBlock(blockStart);
+			}
+		});
+
+		std::sort(differences.begin(), differences.end(), [](const MemoryDifference& first, const MemoryDifference& second) { return first.address < second.address; });
+		return differences;
 	}
 }
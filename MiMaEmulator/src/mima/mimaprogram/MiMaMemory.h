@@ -1,14 +1,20 @@
 #pragma once
 
 //std library
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
-#include <functional>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 //external vendor libraries
 #include <fmt/format.h>
 
+//internal classes
+#include "MemoryMappedFile.h"
+
 //internal utility
 #include "util/BinarySearchTree.h"
 
@@ -35,7 +41,7 @@ namespace MiMa {
 	class MiMaMemory {
 		friend struct fmt::formatter<MiMa::MiMaMemory>;
 
-	private:
+	public:
 		class MemoryBlock {
 			friend MemoryBlock;
 
@@ -47,12 +53,20 @@ namespace MiMa {
 
 		public:
 			bool operator==(const MemoryBlock& other) const {
+				//accumulate the differences of all cells without branching, so the comparison can be vectorized
+				uint32_t differences = 0;
 				for (size_t i = 0; i < MEMORY_BLOCK_SIZE; ++i) {
-					if (memory[i] != other.memory[i]) {
-						return false;
-					}
+					differences |= memory[i].data ^ other.memory[i].data;
+				}
+				return differences == 0;
+			}
+
+			inline bool isEmpty() const {
+				uint32_t content = 0;
+				for (size_t i = 0; i < MEMORY_BLOCK_SIZE; ++i) {
+					content |= memory[i].data;
 				}
-				return true;
+				return content == 0;
 			}
 			inline bool operator!=(const MemoryBlock& other) const { return !(*this == other); }
 
@@ -61,15 +75,150 @@ namespace MiMa {
 		};
 
 
-	private:
-		static const std::function<std::shared_ptr<MemoryBlock>(void)> emptyMemoryBlockConstructor;
+	public:
+		static constexpr size_t BLOCK_SIZE = MemoryBlock::MEMORY_BLOCK_SIZE;
+		static constexpr size_t BLOCK_COUNT = (DEFAULT_MEMORY_CAPACITY + 1) / BLOCK_SIZE;
 
 	private:
-		BinarySearchTree<MemoryBlock> memory = BinarySearchTree(0, emptyMemoryBlockConstructor);
+		BinarySearchTree<MemoryBlock> memory = BinarySearchTree<MemoryBlock>(0);
+
+		//if the memory is backed by a file, all blocks are stored there as one flat array instead of the search tree
+		std::shared_ptr<MemoryMappedFile> mappedFile;
+		MemoryBlock* mappedBlocks = nullptr;
+		//one bit per block of the file which wasn't empty when it was mapped or was accessed since,
+		//so walking the populated blocks doesn't read every page of the file
+		std::vector<uint64_t> populatedBlocks;
+
+		//one bit per block, set for every block written to by store
+		std::vector<uint64_t> dirtyBlocks = std::vector<uint64_t>(BLOCK_COUNT / 64);
+
+		//every memory gets a distinct id, so restoring from the same image twice can be recognized
+		static std::atomic<uint64_t> nextId;
+		const uint64_t id = nextId++;
+		uint64_t restoredImageId = 0;
+
+		//the block with the given index, created if it isn't populated
+		inline MemoryBlock& getBlock(const size_t& blockIndex) {
+			if (mappedBlocks) {
+				markPopulated(blockIndex);
+				return mappedBlocks[blockIndex];
+			}
+
+			return memory.find(blockIndex);
+		}
+		inline void markPopulated(const size_t& blockIndex) { populatedBlocks[blockIndex / 64] |= uint64_t(1) << (blockIndex % 64); }
+
+		//calls function(blockIndex) for every bit set in the bitmap for the blocks [lowerBlock, upperBlock), in ascending order
+		template<typename Function>
+		static void forEachBlockInBitmap(const std::vector<uint64_t>& bitmap, const size_t& lowerBlock, const size_t& upperBlock, const Function& function) {
+			for (size_t word = lowerBlock / 64; word < std::min((upperBlock + 63) / 64, bitmap.size()); ++word) {
+				//skip the clear parts of the bitmap a whole word at a time
+				for (uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1) {
+					size_t bit = 0;
+					while (((bits >> bit) & 1) == 0) {
+						++bit;
+					}
+
+					size_t blockIndex = word * 64 + bit;
+					if (blockIndex >= lowerBlock && blockIndex < upperBlock) {
+						function(blockIndex);
+					}
+				}
+			}
+		}
+
+		void reserveBlocks(const std::vector<size_t>& blockIndices, const size_t& lower, const size_t& upper);
 
 	public:
+		MiMaMemory() {}
+		//copies get an id of their own, copies of memory backed by a file hold its populated blocks in the search tree,
+		//so writing to them doesn't change the file
+		MiMaMemory(const MiMaMemory& other);
+
+		//indices wrap around at the end of the 20 bit address space, like the addresses of the MiMa
 		MemoryCell& operator[](const size_t& index);
+
+		//reads a cell without creating its block
+		MemoryCell get(const size_t& index) const;
+		//the block with the given index, nullptr if it isn't populated
+		inline const MemoryBlock* findBlock(const size_t& blockIndex) const { return mappedBlocks ? mappedBlocks + blockIndex : memory.get(blockIndex); }
+
+		//writes a cell and marks its block as dirty
+		inline void store(const size_t& index, const uint32_t& data) {
+			size_t address = index & DEFAULT_MEMORY_CAPACITY;
+			(*this)[address].data = data;
+			dirtyBlocks[address / BLOCK_SIZE / 64] |= uint64_t(1) << (address / BLOCK_SIZE % 64);
+		}
+
+		inline bool isDirty(const size_t& blockIndex) const { return (dirtyBlocks[blockIndex / 64] >> (blockIndex % 64)) & 1; }
+		inline void clearDirty() { std::fill(dirtyBlocks.begin(), dirtyBlocks.end(), 0); }
+
+		//sets the content to the given image, reusing the blocks which are populated already
+		//if the memory was restored from the same image before, only the blocks dirtied since then are restored,
+		//so the image mustn't change and the memory mustn't be written to other than through store in between
+		//(memory backed by a file is restored in the file itself, overwriting its content)
+		void restore(const MiMaMemory& image);
+
+		//statistics of the allocations of all populated blocks except the first one
+		inline SlabAllocatorStatistics getAllocationStatistics() const { return memory.getAllocationStatistics(); }
+
+		// ------------------------------------------------------
+		// File backed memory
+		// Maps the given file as the flat array of all 2^20
+		// 32 bit cells (growing it if necessary), so its content
+		// is the initial memory and every write goes straight
+		// to the file
+		// ------------------------------------------------------
+		static std::shared_ptr<MiMaMemory> mapFile(const std::string& fileName);
+
+		inline bool isMapped() const { return mappedBlocks != nullptr; }
+		//blocks until all writes are on disk
+		inline void flush() { if (mappedFile) mappedFile->flush(); }
+
+		//creates the blocks with the given (sorted) indices in an order which keeps the memory balanced
+		inline void reserveBlocks(const std::vector<size_t>& blockIndices) { reserveBlocks(blockIndices, 0, blockIndices.size()); }
+
+		//calls function(blockStart, block) for every populated block overlapping the addresses [lowerLimit, upperLimit), in ascending order
+		//(for memory backed by a file, every block which wasn't empty when the file was mapped or was accessed since counts as populated)
+		template<typename Function>
+		void forEachBlockInRange(const size_t& lowerLimit, const size_t& upperLimit, const Function& function) const {
+			if (mappedBlocks) {
+				forEachBlockInBitmap(populatedBlocks, lowerLimit / BLOCK_SIZE, std::min((upperLimit + BLOCK_SIZE - 1) / BLOCK_SIZE, BLOCK_COUNT), [this, &function](const size_t& blockIndex) {
+					function(blockIndex * BLOCK_SIZE, mappedBlocks[blockIndex]);
+				});
+				return;
+			}
+
+			memory.forEachInRange(lowerLimit / BLOCK_SIZE, (upperLimit + BLOCK_SIZE - 1) / BLOCK_SIZE, [&function](const size_t& blockIndex, const MemoryBlock& block) {
+				function(blockIndex * BLOCK_SIZE, block);
+			});
+		}
+
+		//calls function(blockStart) for every dirty block, in ascending order
+		template<typename Function>
+		void forEachDirtyBlock(const Function& function) const {
+			forEachBlockInBitmap(dirtyBlocks, 0, BLOCK_COUNT, [&function](const size_t& blockIndex) {
+				function(blockIndex * BLOCK_SIZE);
+			});
+		}
 	};
+
+
+	//a memory used as the initial state of minimal machines
+	using MemoryImage = MiMaMemory;
+
+
+	// --- Memory comparison ---
+
+	struct MemoryDifference {
+		size_t address;
+		MemoryCell left;
+		MemoryCell right;
+	};
+
+	//lists all cells differing between the memories by ascending address, only examining populated blocks
+	//if onlyDirty is set, only the dirty blocks of left are examined, assuming left was equal to right before those writes
+	std::vector<MemoryDifference> diff(const MiMaMemory& left, const MiMaMemory& right, const bool& onlyDirty = false);
 }
 
 
@@ -89,33 +238,88 @@ struct fmt::formatter<MiMa::MemoryCell> {
 	}
 };
 
+//format specification: [x][lowerLimit,upperLimit]
+//x selects a compact hex dump with one line per block, the optional (decimal) limits select the addresses [lowerLimit, upperLimit)
 template<>
 struct fmt::formatter<MiMa::MiMaMemory> {
-	constexpr auto parse(format_parse_context& ctx) { return ctx.end(); }
+private:
+	bool compact = false;
+	size_t lowerLimit = 0;
+	size_t upperLimit = MiMa::DEFAULT_MEMORY_CAPACITY + 1;
+
+public:
+	constexpr auto parse(format_parse_context& ctx) {
+		auto it = ctx.begin();
+		auto end = ctx.end();
+
+		if (it != end && *it == 'x') {
+			compact = true;
+			++it;
+		}
 
-	template<typename FormatContext>
-	auto format(const MiMa::MiMaMemory& memory, FormatContext& ctx) {
-		BinarySearchTreeIterator<MiMa::MiMaMemory::MemoryBlock> it(memory.memory);
-		BinarySearchTreeIterator<MiMa::MiMaMemory::MemoryBlock> end;
-
-		std::string treeOutput = "Minimal machine memory:\n{}";
-		std::string blockFormat = "from {:X}:\n{}";
-		std::string addressFormat = "{}\n{{}}";
-
-		while (it != end) {
-			std::pair<size_t, std::shared_ptr<MiMa::MiMaMemory::MemoryBlock>> currentBlock = *it;
-			
-			std::string addressOutput = fmt::format("Block starting at 0x{:X}:\n{{}}", currentBlock.first);
-			for (size_t i = 0; i < MiMa::MiMaMemory::MemoryBlock::MEMORY_BLOCK_SIZE; ++i) {
-				std::string addressContent = fmt::format(addressFormat, (*(currentBlock.second))[i]);
-				addressOutput = fmt::format(addressOutput, addressContent);
+		if (it == end || *it == '}') {
+			return it;
+		}
+
+		lowerLimit = 0;
+		while (it != end && *it != ',') {
+			if (*it == '}' || *it < '0' || *it > '9') {
+				throw format_error("Expected a range declaration made of digits [0-9] separated by a ','");
 			}
 
-			treeOutput = fmt::format(treeOutput, addressOutput);
+			lowerLimit = lowerLimit * 10 + (*it - '0');
+			++it;
+		}
+		if (it == end) {
+			throw format_error("Expected a ',' somewhere in the range declaration");
+		}
+		++it;
 
+		upperLimit = 0;
+		while (it != end && *it != '}') {
+			if (*it < '0' || *it > '9') {
+				throw format_error("Only digits [0-9] are allowed for range declarations");
+			}
+
+			upperLimit = upperLimit * 10 + (*it - '0');
 			++it;
 		}
 
-		return fmt::format_to(ctx.out(), treeOutput, "");
+		if (lowerLimit > upperLimit) {
+			throw format_error("The lower limit may not exceed the upper limit");
+		}
+
+		return it;
+	}
+
+	template<typename FormatContext>
+	auto format(const MiMa::MiMaMemory& memory, FormatContext& ctx) {
+		//write straight into the output, so the dump grows linearly with the number of cells
+		auto out = ctx.out();
+		if (!compact) {
+			out = fmt::format_to(out, "Minimal machine memory:\n");
+		}
+
+		memory.forEachBlockInRange(lowerLimit, upperLimit, [this, &out](const size_t& blockStart, const MiMa::MiMaMemory::MemoryBlock& block) {
+			//only print the part of the block inside the selected range
+			size_t first = std::max(blockStart, lowerLimit);
+			size_t last = std::min(blockStart + MiMa::MiMaMemory::BLOCK_SIZE, upperLimit);
+
+			if (compact) {
+				out = fmt::format_to(out, "{:05X}:", first);
+				for (size_t address = first; address < last; ++address) {
+					out = fmt::format_to(out, " {:06X}", block[address - blockStart].data);
+				}
+				*out++ = '\n';
+			}
+			else {
+				out = fmt::format_to(out, "Block starting at 0x{:X}:\n", blockStart);
+				for (size_t address = first; address < last; ++address) {
+					out = fmt::format_to(out, "{}\n", block[address - blockStart]);
+				}
+			}
+		});
+
+		return out;
 	}
 };
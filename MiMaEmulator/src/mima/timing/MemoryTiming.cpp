@@ -0,0 +1,134 @@
+#include "mimapch.h"
+#include "MemoryTiming.h"
+
+//std library
+#include <algorithm>
+#include <stdexcept>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//debugging utility
+#include "debug/Log.h"
+
+
+namespace MiMa {
+	// ---------------------
+	// Region memory timing
+	// ---------------------
+
+	RegionMemoryTiming::RegionMemoryTiming(const uint32_t& defaultLatency) {
+		setDefaultLatency(defaultLatency);
+	}
+
+
+	void RegionMemoryTiming::setLatency(const size_t& lower, const size_t& upper, const uint32_t& latency) {
+		if (lower >= upper || latency == 0 || latency > MAX_MEMORY_LATENCY) {
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to set the latency {} for the address range [0x{:05X}, 0x{:05X}), latencies need a non-empty range and 1 to {} cycles", latency, lower, upper, MAX_MEMORY_LATENCY);
+			throw std::invalid_argument(fmt::format("failed to set the latency {} for the address range [0x{:05X}, 0x{:05X}), latencies need a non-empty range and 1 to {} cycles", latency, lower, upper, MAX_MEMORY_LATENCY));
+		}
+
+		auto position = std::lower_bound(regions.begin(), regions.end(), lower, [](const Region& region, const size_t& address) {
+			return region.lower < address;
+		});
+
+		//only the direct neighbours can overlap the new range
+		if ((position != regions.end() && position->lower < upper) || (position != regions.begin() && std::prev(position)->upper > lower)) {
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to set the latency of [0x{:05X}, 0x{:05X}), the range overlaps another region", lower, upper);
+			throw std::invalid_argument(fmt::format("failed to set the latency of [0x{:05X}, 0x{:05X}), the range overlaps another region", lower, upper));
+		}
+
+		regions.insert(position, { lower, upper, latency });
+		MIMA_CHANNEL_LOG_INFO(MEMORY, "Set the memory latency of [0x{:05X}, 0x{:05X}) to {} cycles", lower, upper, latency);
+	}
+
+	void RegionMemoryTiming::setDefaultLatency(const uint32_t& latency) {
+		if (latency == 0 || latency > MAX_MEMORY_LATENCY) {
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to set the default memory latency to {}, accesses take 1 to {} cycles", latency, MAX_MEMORY_LATENCY);
+			throw std::invalid_argument(fmt::format("failed to set the default memory latency to {}, accesses take 1 to {} cycles", latency, MAX_MEMORY_LATENCY));
+		}
+
+		defaultLatency = latency;
+	}
+
+
+	uint32_t RegionMemoryTiming::getLatency(const size_t& address) const {
+		//find the last region starting at or before the address
+		auto position = std::upper_bound(regions.begin(), regions.end(), address, [](const size_t& address, const Region& region) {
+			return address < region.lower;
+		});
+
+		if (position == regions.begin() || address >= std::prev(position)->upper) {
+			return defaultLatency;
+		}
+		return std::prev(position)->latency;
+	}
+
+
+
+	// ---------------------
+	// Cached memory timing
+	// ---------------------
+
+	CachedMemoryTiming::CachedMemoryTiming(const size_t& setCount, const size_t& associativity, const size_t& lineSize, const uint32_t& hitLatency) :
+		setCount(setCount),
+		associativity(associativity),
+		lineSize(lineSize),
+		hitLatency(hitLatency)
+	{
+		if (setCount == 0 || associativity == 0 || lineSize == 0 || hitLatency == 0 || hitLatency > MAX_MEMORY_LATENCY) {
+			MIMA_CHANNEL_LOG_ERROR(MEMORY, "Failed to create a cache of {} sets with {} lines of {} cells and a hit latency of {}, all of them need to be at least 1 and the latency at most {}", setCount, associativity, lineSize, hitLatency, MAX_MEMORY_LATENCY);
+			throw std::invalid_argument(fmt::format("failed to create a cache of {} sets with {} lines of {} cells and a hit latency of {}, all of them need to be at least 1 and the latency at most {}", setCount, associativity, lineSize, hitLatency, MAX_MEMORY_LATENCY));
+		}
+
+		lines.resize(setCount * associativity);
+		MIMA_CHANNEL_LOG_INFO(MEMORY, "Initialized a cache of {} sets with {} lines of {} cells", setCount, associativity, lineSize);
+	}
+
+
+	CachedMemoryTiming::CacheLine* CachedMemoryTiming::find(const size_t& line) {
+		std::vector<CacheLine>::iterator set = lines.begin() + (line % setCount) * associativity;
+		std::vector<CacheLine>::iterator cached = std::find_if(set, set + associativity, [&line](const CacheLine& cacheLine) { return cacheLine.line == line; });
+
+		return cached == set + associativity ? nullptr : &*cached;
+	}
+
+
+	uint32_t CachedMemoryTiming::startAccess(const size_t& address, const bool& writing) {
+		size_t line = address / lineSize;
+		CacheLine* cached = find(line);
+		accessCount++;
+
+		if (cached) {
+			cached->lastUse = accessCount;
+		}
+
+		//write through, without allocating a line on a miss
+		if (writing) {
+			(cached ? statistics.writeHits : statistics.writeMisses)++;
+			return memoryTiming.getLatency(address);
+		}
+
+		if (cached) {
+			statistics.readHits++;
+			return hitLatency;
+		}
+
+		//load the line into the least recently used line of its set, unused lines were never used
+		std::vector<CacheLine>::iterator set = lines.begin() + (line % setCount) * associativity;
+		std::vector<CacheLine>::iterator replaced = std::min_element(set, set + associativity, [](const CacheLine& left, const CacheLine& right) {
+			return left.lastUse < right.lastUse;
+		});
+		*replaced = { line, accessCount };
+
+		statistics.readMisses++;
+		return memoryTiming.getLatency(address);
+	}
+
+
+	void CachedMemoryTiming::reset() {
+		std::fill(lines.begin(), lines.end(), CacheLine());
+		accessCount = 0;
+		statistics = CacheStatistics();
+	}
+}
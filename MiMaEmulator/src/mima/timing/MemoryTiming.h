@@ -0,0 +1,146 @@
+#pragma once
+
+//std library
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace MiMa {
+	// ------------------------------------------------
+	// Memory timing models
+	//
+	// Policies of BasicMinimalMachine deciding how
+	// many consecutive access cycles a memory access
+	// takes. A model provides
+	//   uint32_t startAccess(address, writing)
+	// called in the first cycle of every access with
+	// the latency of it (at least 1, at most
+	// MAX_MEMORY_LATENCY), and reset(), called when
+	// the MiMa is reset, and the trait
+	//   static constexpr bool STALLS
+	// The accessed data is always taken from the
+	// memory or device when the access completes,
+	// models only decide when that happens. If STALLS
+	// is set, an access outlasting the access cycles
+	// of the microcode stalls the decoder in the last
+	// one of them until it completes, otherwise such
+	// an access is dropped like on the original MiMa.
+	// ------------------------------------------------
+
+	//the MiMa counts the cycles of an access in 11 bits
+	constexpr uint32_t MAX_MEMORY_LATENCY = 0x7FF;
+
+
+	// --- Fixed latency, the timing of the original MiMa ---
+
+	class FixedMemoryTiming {
+	public:
+		static constexpr uint32_t LATENCY = 3;
+		static constexpr bool STALLS = false;
+
+		inline uint32_t startAccess(const size_t&, const bool&) { return LATENCY; }
+		inline void reset() {}
+	};
+
+
+	// --- Latencies by address region ---
+
+	class RegionMemoryTiming {
+	public:
+		static constexpr uint32_t DEFAULT_LATENCY = FixedMemoryTiming::LATENCY;
+		static constexpr bool STALLS = true;
+
+	private:
+		struct Region {
+			size_t lower;
+			size_t upper;
+			uint32_t latency;
+		};
+
+	private:
+		std::vector<Region> regions; //sorted by address
+		uint32_t defaultLatency;
+
+	public:
+		RegionMemoryTiming(const uint32_t& defaultLatency = DEFAULT_LATENCY);
+
+		//sets the latency of the addresses [lower, upper), which may not overlap any other region
+		void setLatency(const size_t& lower, const size_t& upper, const uint32_t& latency);
+		//the latency of all addresses outside of the regions
+		void setDefaultLatency(const uint32_t& latency);
+
+		uint32_t getLatency(const size_t& address) const;
+
+		inline uint32_t startAccess(const size_t& address, const bool&) { return getLatency(address); }
+		inline void reset() {}
+	};
+
+
+	// --- Cache in front of the memory ---
+
+	struct CacheStatistics {
+		uint64_t readHits = 0;
+		uint64_t readMisses = 0;
+		uint64_t writeHits = 0;
+		uint64_t writeMisses = 0;
+	};
+
+	// ------------------------------------------------
+	// Simulated set associative cache
+	//
+	// Tracks which memory lines a cache of setCount
+	// sets with associativity lines of lineSize cells
+	// each would hold, replacing the least recently
+	// used line of a set. Reads of cached lines take
+	// the hit latency, misses the latency of the
+	// memory behind the cache and load the line.
+	// Writes go through to the memory without
+	// allocating a line. An associativity of 1 is a
+	// direct mapped cache.
+	// ------------------------------------------------
+
+	class CachedMemoryTiming {
+	public:
+		static constexpr size_t DEFAULT_SET_COUNT = 64;
+		static constexpr size_t DEFAULT_ASSOCIATIVITY = 1;
+		static constexpr size_t DEFAULT_LINE_SIZE = 4;
+		static constexpr uint32_t DEFAULT_HIT_LATENCY = 1;
+		static constexpr bool STALLS = true;
+
+	private:
+		static constexpr size_t INVALID_LINE = SIZE_MAX;
+
+		struct CacheLine {
+			size_t line = INVALID_LINE;
+			uint64_t lastUse = 0;
+		};
+
+	private:
+		RegionMemoryTiming memoryTiming;
+
+		size_t setCount;
+		size_t associativity;
+		size_t lineSize;
+		uint32_t hitLatency;
+
+		//the lines of set i are lines[i * associativity, (i + 1) * associativity)
+		std::vector<CacheLine> lines;
+		uint64_t accessCount = 0;
+		CacheStatistics statistics;
+
+		//returns the cache line holding the given memory line or nullptr
+		CacheLine* find(const size_t& line);
+
+	public:
+		CachedMemoryTiming(const size_t& setCount = DEFAULT_SET_COUNT, const size_t& associativity = DEFAULT_ASSOCIATIVITY, const size_t& lineSize = DEFAULT_LINE_SIZE, const uint32_t& hitLatency = DEFAULT_HIT_LATENCY);
+
+		//the latencies of the memory behind the cache
+		inline RegionMemoryTiming& getMemoryTiming() { return memoryTiming; }
+		inline const CacheStatistics& getStatistics() const { return statistics; }
+
+		uint32_t startAccess(const size_t& address, const bool& writing);
+		//empties the cache and its statistics
+		void reset();
+	};
+}
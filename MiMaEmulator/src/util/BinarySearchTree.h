@@ -1,10 +1,11 @@
 #pragma once
 
 //std library
-#include <functional>
-#include <memory>
-#include <stack>
 #include <utility>
+#include <vector>
+
+//internal utility
+#include "util/SlabAllocator.h"
 
 
 template<typename Data>
@@ -36,129 +37,109 @@ class BinarySearchTreeNode {
 
 private:
 	const size_t index; //the index/value of the data stored in this node, which the search tree sorts/searches by
-	std::shared_ptr<Data> data; //the actual data stored in this node
-	const std::function<std::shared_ptr<Data>(void)>& emptyConstructor; //a reference to the constructor creating empty data pieces in case a non-existent node is searched for
-
-	//left (lower) and right (higher) child
-	std::shared_ptr<BinarySearchTreeNode<Data>> leftChild;
-	std::shared_ptr<BinarySearchTreeNode<Data>> rightChild;
+	Data data; //the actual data stored in this node
 
+	//left (lower) and right (higher) child, owned by the allocator of the tree
+	BinarySearchTreeNode<Data>* leftChild = nullptr;
+	BinarySearchTreeNode<Data>* rightChild = nullptr;
 
-	//creates a node with given data
-	BinarySearchTreeNode(const size_t& index, const std::shared_ptr<Data>& data, const std::function<std::shared_ptr<Data>(void)>& emptyConstructor) :
-		index(index),
-		data(data),
-		emptyConstructor(emptyConstructor)
-	{}
+public:
 	//create a node with empty data
-	BinarySearchTreeNode(const size_t & index, const std::function<std::shared_ptr<Data>(void)>& emptyConstructor) :
-		index(index),
-		data(emptyConstructor()),
-		emptyConstructor(emptyConstructor)
-	{}
+	BinarySearchTreeNode(const size_t& index) : index(index), data() {}
+	//creates a node with given data
+	BinarySearchTreeNode(const size_t& index, const Data& data) : index(index), data(data) {}
+};
+
 
 
+// --------------------
+// Binary search tree
+//
+// Stores the head node
+// and allocates all
+// other nodes in slabs,
+// which are released
+// together with the
+// tree.
+// --------------------
+
+template<typename Data>
+class BinarySearchTree {
+	friend BinarySearchTreeIterator<Data>;
+
 private:
-	//find data by its index
-	std::shared_ptr<Data> find(const size_t& index) {
-		//if the searched index is lower than the index of this node, look for the data in the left sub-tree
-		if (index < this->index) {
-			if (leftChild == nullptr) {
-				leftChild.reset(new BinarySearchTreeNode<Data>(index, emptyConstructor));
-				return leftChild->data;
-			}
-			return leftChild->find(index);
-		}
+	BinarySearchTreeNode<Data> root;
+	SlabAllocator<BinarySearchTreeNode<Data>> nodes;
+
+public:
+	BinarySearchTree(const size_t& headIndex) : root(headIndex) {}
 
-		//if the searched index is higher than the index of this node, look for the data in the right sub-tree
-		if (this->index < index) {
-			if (rightChild == nullptr) {
-				rightChild.reset(new BinarySearchTreeNode<Data>(index, emptyConstructor));
-				return rightChild->data;
+	//copies all nodes, keeping the shape of the tree
+	BinarySearchTree(const BinarySearchTree<Data>& other) : root(other.root.index, other.root.data) {
+		std::vector<std::pair<const BinarySearchTreeNode<Data>*, BinarySearchTreeNode<Data>*>> pending = { { &other.root, &root } };
+
+		while (!pending.empty()) {
+			std::pair<const BinarySearchTreeNode<Data>*, BinarySearchTreeNode<Data>*> current = pending.back();
+			pending.pop_back();
+
+			if (current.first->leftChild != nullptr) {
+				current.second->leftChild = nodes.allocate(current.first->leftChild->index, current.first->leftChild->data);
+				pending.push_back({ current.first->leftChild, current.second->leftChild });
+			}
+			if (current.first->rightChild != nullptr) {
+				current.second->rightChild = nodes.allocate(current.first->rightChild->index, current.first->rightChild->data);
+				pending.push_back({ current.first->rightChild, current.second->rightChild });
 			}
-			return rightChild->find(index);
 		}
-
-		//assertion: index == this->index
-		//the data searched for is stored in this node
-		return this->data;
 	}
+	BinarySearchTree<Data>& operator=(const BinarySearchTree<Data>&) = delete;
 
-	//create a new node or update an existing node with the given data
-	void place(const size_t& index, const std::shared_ptr<Data>& data) {
-		//if the given index is lower than the index of this node, place the data in the left sub-tree
-		if (index < this->index) {
-			if (leftChild == nullptr) {
-				//if the left sub-tree doesn't exist, create a new node with the given index and data
-				leftChild = new BinarySearchTreeNode<Data>(index, data, emptyConstructor);
-				return;
-			}
 
-			//assertion: the left sub-tree exists
-			//place the data under the given index in the left sub-tree
-			leftChild->place(index, data);
-			return;
-		}
+	//find data by its index, creating a node with empty data if there is none
+	Data& find(const size_t& index) {
+		BinarySearchTreeNode<Data>* current = &root;
 
-		//if the given index is higher than the index of this node, place the data in the right sub-tree
-		if (this->index < index) {
-			if (rightChild == nullptr) {
-				//if the right sub-tree doesn't exist, create a new node with the given index and data
-				rightChild = new BinarySearchTreeNode<Data>(index, data, emptyConstructor);
-				return;
+		//walk down iteratively, so even a degenerated (list-like) tree can't overflow the stack
+		while (current->index != index) {
+			//if the searched index is lower than the index of the current node, look for the data in the left sub-tree, otherwise in the right one
+			BinarySearchTreeNode<Data>*& child = (index < current->index) ? current->leftChild : current->rightChild;
+
+			if (child == nullptr) {
+				child = nodes.allocate(index);
+				return child->data;
 			}
 
-			//assertion: the right sub-tree exists
-			//place the data under the given index in the right sub-tree
-			rightChild->place(index, data);
-			return;
+			current = child;
 		}
 
-		//assertion: index == this->index
-		//update this node
-		this->data = data;
-	}
-
-public:
-	bool operator==(const BinarySearchTreeNode<Data>& other) const {
-		return (*(this->data)) == (*(other.data))
-			&& this->index == other.index
-			&& (this->leftChild == nullptr) ? (other.leftChild == nullptr) : (other.leftChild != nullptr && *(this->leftChild) == *(other.leftChild))
-			&& (this->rightChild == nullptr) ? (other.rightChild == nullptr) : (other.rightChild != nullptr && *(this->rightChild) == *(other.rightChild));
-	}
-	inline bool operator!=(const BinarySearchTreeNode<Data>& other) const {
-		return !(*this == other);
+		//assertion: index == current->index
+		//the data searched for is stored in this node
+		return current->data;
 	}
-};
-
 
+	//looks up data without creating it, returns nullptr if there is no node with the given index
+	const Data* get(const size_t& index) const {
+		const BinarySearchTreeNode<Data>* current = &root;
 
-// --------------------
-// Binary search tree
-//
-// Stores the head node
-// and keeps a copy of
-// the constructor for
-// empty data elements.
-// --------------------
+		while (current != nullptr && current->index != index) {
+			current = (index < current->index) ? current->leftChild : current->rightChild;
+		}
 
-template<typename Data>
-class BinarySearchTree {
-	friend BinarySearchTreeIterator<Data>;
-	friend BinarySearchTreeIterator<Data>;
+		return (current == nullptr) ? nullptr : &(current->data);
+	}
 
-private:
-	const std::function<std::shared_ptr<Data>(void)> emptyConstructor;
-	BinarySearchTreeNode<Data> root;
+	//calls the given function with the index and data of every node with an index in [lowerBound, upperBound), in ascending order
+	template<typename Function>
+	void forEachInRange(const size_t& lowerBound, const size_t& upperBound, const Function& function) const {
+		BinarySearchTreeIterator<Data> end;
 
-public:
-	BinarySearchTree(const size_t& headIndex, const std::function<std::shared_ptr<Data>(void)>& emptyConstructor) :
-		emptyConstructor(emptyConstructor),
-		root(headIndex, emptyConstructor)
-	{}
+		for (BinarySearchTreeIterator<Data> it(*this, lowerBound); it != end && it.index() < upperBound; ++it) {
+			function(it.index(), *it);
+		}
+	}
 
-	inline std::shared_ptr<Data> find(const size_t& index) { return root.find(index); }
-	inline void place(const size_t& index, const std::shared_ptr<Data>& data) { root.place(index, data); }
+	//statistics of the node allocations (excluding the head node)
+	inline SlabAllocatorStatistics getAllocationStatistics() const { return nodes.getStatistics(); }
 };
 
 
@@ -170,77 +151,72 @@ public:
 // stored in a binary search
 // tree from lowest to highest
 // index.
+//
+// Only keeps pointers to the
+// nodes on the path to the
+// current node, so the tree
+// mustn't change while it is
+// being iterated.
 // ---------------------------
 
 template<typename Data>
 class BinarySearchTreeIterator {
 private:
-	//the stack of nodes for the depth first search
-	std::stack<BinarySearchTreeNode<Data>> dfsStack;
+	//the path of nodes still to be visited, the current node on top
+	std::vector<const BinarySearchTreeNode<Data>*> dfsStack;
 
 private:
-	//builds the depth first stack using the top element of the dfs stack as a starting point
-	//to recursively add all left children
-	void buildDFSStack() {
-		if (dfsStack.empty()) {
-			return;
-		}
-
-		while (dfsStack.top().leftChild != nullptr) {
-			dfsStack.push(*(dfsStack.top().leftChild));
+	//adds the given node and all of its left descendants to the dfs stack
+	void pushLeftPath(const BinarySearchTreeNode<Data>* node) {
+		while (node != nullptr) {
+			dfsStack.push_back(node);
+			node = node->leftChild;
 		}
 	}
 
 	//removes the top element from the dfs stack
-	//if the top element had a right child, add it to the dfs stack and build it from there
+	//if the top element had a right child, continue with the lowest node of that sub-tree
 	void next() {
 		if (dfsStack.empty()) {
 			return;
 		}
 
-		BinarySearchTreeNode<Data> topElement = dfsStack.top();
-		dfsStack.pop();
+		const BinarySearchTreeNode<Data>* topElement = dfsStack.back();
+		dfsStack.pop_back();
 
-		if (topElement.rightChild != nullptr) {
-			dfsStack.push(*(topElement.rightChild));
-			buildDFSStack();
-		}
+		pushLeftPath(topElement->rightChild);
 	}
 
 public:
 	BinarySearchTreeIterator() {}
-	BinarySearchTreeIterator(const BinarySearchTree<Data>& tree) { dfsStack.push(tree.root); buildDFSStack(); }
-
-	//(in)equality operator
-	bool operator==(const BinarySearchTreeIterator<Data>& other) const {
-		std::stack<BinarySearchTreeNode<Data>> thisDFSStack = dfsStack;
-		std::stack<BinarySearchTreeNode<Data>> otherDFSStack = other.dfsStack;
-
-		while (!thisDFSStack.empty()) {
-			if (otherDFSStack.empty()) {
-				return false;
+	BinarySearchTreeIterator(const BinarySearchTree<Data>& tree) { pushLeftPath(&tree.root); }
+	//starts at the lowest index not below the given lower bound
+	BinarySearchTreeIterator(const BinarySearchTree<Data>& tree, const size_t& lowerBound) {
+		const BinarySearchTreeNode<Data>* node = &tree.root;
+
+		//only the nodes not below the bound are visited on the way back up, so only those are kept
+		while (node != nullptr) {
+			if (node->index < lowerBound) {
+				node = node->rightChild;
 			}
-
-			if (thisDFSStack.top() != otherDFSStack.top()) {
-				return false;
+			else {
+				dfsStack.push_back(node);
+				node = node->leftChild;
 			}
-
-			thisDFSStack.pop();
-			otherDFSStack.pop();
-		}
-
-		if (!otherDFSStack.empty()) {
-			return false;
 		}
+	}
 
-		return true;
+	//(in)equality operator, two iterators are equal if they point to the same node or are both at the end
+	inline bool operator==(const BinarySearchTreeIterator<Data>& other) const {
+		return dfsStack.empty() ? other.dfsStack.empty() : (!other.dfsStack.empty() && dfsStack.back() == other.dfsStack.back());
 	}
 	inline bool operator!=(const BinarySearchTreeIterator<Data>& other) const { return !(*this == other); }
 
-	//pre/post-increment operator
+	//pre-increment operator
 	inline BinarySearchTreeIterator<Data>& operator++() { next(); return *this; };
-	inline BinarySearchTreeIterator<Data>& operator++(int) { BinarySearchTreeIterator<Data>& ref = *this; next(); return ref; };
 
-	//dereference operator
-	inline std::pair<size_t, std::shared_ptr<Data>> operator*() { return { dfsStack.top().index, dfsStack.top().data }; }
+	//index and data of the current node
+	inline size_t index() const { return dfsStack.back()->index; }
+	inline const Data& operator*() const { return dfsStack.back()->data; }
+	inline const Data* operator->() const { return &(dfsStack.back()->data); }
 };
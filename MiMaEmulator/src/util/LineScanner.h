@@ -0,0 +1,127 @@
+#pragma once
+
+//std library
+#include <cctype>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+
+
+// ------------------------------------
+// Single pass line scanner
+//
+// Walks over a single line of code
+// exactly once, handing out words,
+// numbers and punctuation without
+// building any intermediate strings or
+// running regular expressions on them.
+// ------------------------------------
+
+class LineScanner {
+private:
+	std::string_view line;
+	size_t position = 0;
+
+	static inline bool isWordCharacter(const char& character) { return isalnum((unsigned char)character) || character == '_'; }
+
+public:
+	LineScanner(const std::string_view& line) : line(line) {}
+
+	inline bool atEnd() const { return position >= line.size(); }
+	inline char peek() const { return atEnd() ? '\0' : line[position]; }
+
+	inline size_t getPosition() const { return position; }
+	inline void setPosition(const size_t& position) { this->position = position; }
+
+	//the part of the line which hasn't been scanned yet
+	inline std::string_view rest() const { return atEnd() ? std::string_view() : line.substr(position); }
+
+
+	//skips any whitespace and returns true if the end of the line has been reached
+	bool skipWhitespace() {
+		while (!atEnd() && isspace((unsigned char)line[position])) {
+			++position;
+		}
+
+		return atEnd();
+	}
+
+	//consumes the given character if it is the next non-whitespace character
+	bool consume(const char& expected) {
+		skipWhitespace();
+
+		if (peek() != expected) {
+			return false;
+		}
+
+		++position;
+		return true;
+	}
+
+	//consumes the given character sequence if it follows the next whitespace
+	bool consume(const std::string_view& expected) {
+		skipWhitespace();
+
+		if (line.compare(position, expected.size(), expected) != 0) {
+			return false;
+		}
+
+		position += expected.size();
+		return true;
+	}
+
+
+	//reads a word made of letters, digits and underscores (empty if there is none)
+	std::string_view readWord() {
+		skipWhitespace();
+
+		size_t start = position;
+		while (!atEnd() && isWordCharacter(line[position])) {
+			++position;
+		}
+
+		return line.substr(start, position - start);
+	}
+
+	//reads everything up to (excluding) one of the given delimiters or the end of the line, trimming whitespace
+	std::string_view readUntil(const std::string_view& delimiters) {
+		skipWhitespace();
+
+		size_t start = position;
+		size_t end = position;
+		while (!atEnd() && delimiters.find(line[position]) == std::string_view::npos) {
+			if (!isspace((unsigned char)line[position])) {
+				end = position + 1;
+			}
+
+			++position;
+		}
+
+		return line.substr(start, end - start);
+	}
+
+	//reads an unsigned decimal number, returns false without consuming anything if there is none or it exceeds the maximum
+	bool readDecimal(size_t& value, const size_t& maxValue = std::numeric_limits<size_t>::max()) {
+		skipWhitespace();
+
+		if (!isdigit((unsigned char)peek())) {
+			return false;
+		}
+
+		size_t start = position;
+		size_t number = 0;
+		while (!atEnd() && isdigit((unsigned char)line[position])) {
+			size_t digit = line[position] - '0';
+			if (number > (maxValue - digit) / 10) {
+				position = start;
+				return false;
+			}
+
+			number = number * 10 + digit;
+			++position;
+		}
+
+		value = number;
+		return true;
+	}
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+//std library
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+// ---------------------------------
+// Single producer single consumer
+// queue
+//
+// Bounded lock-free ring buffer for
+// handing values from exactly one
+// thread to exactly one other. Both
+// sides only touch the index of the
+// other side once their cached copy
+// of it says the queue is full or
+// empty, so a push or pop usually
+// stays within their own cache line.
+// ---------------------------------
+
+template<typename T>
+class SPSCQueue {
+private:
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+private:
+	std::unique_ptr<T[]> slots;
+	size_t mask; //capacity - 1, the capacity is a power of two
+
+	//consumer side
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+	size_t cachedTail = 0;
+
+	//producer side
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+	size_t cachedHead = 0;
+
+	static size_t roundUpToPowerOfTwo(const size_t& value) {
+		size_t power = 1;
+		while (power < value) {
+			power <<= 1;
+		}
+		return power;
+	}
+
+public:
+	//the capacity is rounded up to the next power of two
+	SPSCQueue(const size_t& capacity) :
+		slots(new T[roundUpToPowerOfTwo(capacity)]),
+		mask(roundUpToPowerOfTwo(capacity) - 1),
+		head(0),
+		tail(0)
+	{}
+
+	SPSCQueue(const SPSCQueue<T>&) = delete;
+	SPSCQueue<T>& operator=(const SPSCQueue<T>&) = delete;
+
+
+	inline size_t getCapacity() const { return mask + 1; }
+
+
+	//only called by the producer, returns false without pushing if the queue is full
+	bool tryPush(const T& value) {
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+
+		if (currentTail - cachedHead > mask) {
+			cachedHead = head.load(std::memory_order_acquire);
+
+			if (currentTail - cachedHead > mask) {
+				return false;
+			}
+		}
+
+		slots[currentTail & mask] = value;
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//only called by the consumer, returns false without writing the value if the queue is empty
+	bool tryPop(T& value) {
+		size_t currentHead = head.load(std::memory_order_relaxed);
+
+		if (currentHead == cachedTail) {
+			cachedTail = tail.load(std::memory_order_acquire);
+
+			if (currentHead == cachedTail) {
+				return false;
+			}
+		}
+
+		value = slots[currentHead & mask];
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+//std library
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// ---------------------------------
+// Slab allocator statistics
+// ---------------------------------
+
+struct SlabAllocatorStatistics {
+	size_t objects = 0;       //objects constructed
+	size_t slabs = 0;         //slabs allocated
+	size_t reservedBytes = 0; //bytes allocated for all slabs
+};
+
+
+
+// ---------------------------------
+// Slab allocator
+//
+// Constructs objects of one type in
+// slabs of growing size, which are
+// only released all at once, either
+// through clear or on destruction.
+// Saves a separate heap allocation
+// (and reference count) per object.
+// ---------------------------------
+
+template<typename T>
+class SlabAllocator {
+private:
+	static const size_t FIRST_SLAB_SIZE = 8;
+	static const size_t MAX_SLAB_SIZE = 4096;
+
+	struct Slab {
+		T* objects;
+		size_t capacity;
+		size_t used;
+	};
+
+private:
+	std::allocator<T> allocator;
+	std::vector<Slab> slabs;
+
+	size_t objectCount = 0;
+	size_t reservedObjects = 0;
+
+public:
+	SlabAllocator() {}
+	~SlabAllocator() { clear(); }
+
+	SlabAllocator(const SlabAllocator<T>&) = delete;
+	SlabAllocator<T>& operator=(const SlabAllocator<T>&) = delete;
+
+
+	//constructs an object in the current slab, starting a new (larger) slab if it is full
+	template<typename... Arguments>
+	T* allocate(Arguments&&... arguments) {
+		if (slabs.empty() || slabs.back().used == slabs.back().capacity) {
+			size_t capacity = slabs.empty() ? FIRST_SLAB_SIZE : std::min(slabs.back().capacity * 2, MAX_SLAB_SIZE);
+
+			slabs.push_back({ allocator.allocate(capacity), capacity, 0 });
+			reservedObjects += capacity;
+		}
+
+		Slab& slab = slabs.back();
+		T* object = new (slab.objects + slab.used) T(std::forward<Arguments>(arguments)...);
+		slab.used++;
+		objectCount++;
+
+		return object;
+	}
+
+	//destroys all objects and releases all slabs
+	void clear() {
+		for (Slab& slab : slabs) {
+			if constexpr (!std::is_trivially_destructible<T>::value) {
+				for (size_t i = 0; i < slab.used; ++i) {
+					slab.objects[i].~T();
+				}
+			}
+
+			allocator.deallocate(slab.objects, slab.capacity);
+		}
+
+		slabs.clear();
+		objectCount = 0;
+		reservedObjects = 0;
+	}
+
+
+	inline SlabAllocatorStatistics getStatistics() const { return { objectCount, slabs.size(), reservedObjects * sizeof(T) }; }
+};
@@ -0,0 +1,99 @@
+//std library
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+//internal classes
+#include "runner/JobRunner.h"
+#include "runner/Manifest.h"
+#include "runner/ResultWriter.h"
+
+
+static const char* USAGE = "usage: mima-run [--threads <count>] [--format json|csv] [--output <fileName>] [--optimize] <manifestFileName>";
+
+//exit codes
+static const int ALL_JOBS_RUN = 0;
+static const int JOBS_FAILED = 1;
+static const int INVALID_INVOCATION = 2;
+
+
+int main(int argc, char** argv) {
+	size_t threadCount = 0;
+	std::string format = "json";
+	std::string outputFileName;
+	std::string manifestFileName;
+	bool optimize = false;
+
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	for (size_t i = 0; i < arguments.size(); ++i) {
+		bool hasValue = i + 1 < arguments.size();
+
+		if (arguments[i] == "--threads" && hasValue) {
+			try {
+				threadCount = std::stoul(arguments[++i]);
+			}
+			catch (const std::exception&) {
+				std::cerr << fmt::format("invalid thread count '{}'\n{}\n", arguments[i], USAGE);
+				return INVALID_INVOCATION;
+			}
+		}
+		else if (arguments[i] == "--format" && hasValue && (arguments[i + 1] == "json" || arguments[i + 1] == "csv")) {
+			format = arguments[++i];
+		}
+		else if (arguments[i] == "--output" && hasValue) {
+			outputFileName = arguments[++i];
+		}
+		else if (arguments[i] == "--optimize") {
+			optimize = true;
+		}
+		else if (manifestFileName.empty() && arguments[i].rfind("--", 0) != 0) {
+			manifestFileName = arguments[i];
+		}
+		else {
+			std::cerr << fmt::format("unexpected argument '{}'\n{}\n", arguments[i], USAGE);
+			return INVALID_INVOCATION;
+		}
+	}
+
+	if (manifestFileName.empty()) {
+		std::cerr << USAGE << "\n";
+		return INVALID_INVOCATION;
+	}
+
+	std::vector<MiMaRunner::Job> jobs;
+	try {
+		jobs = MiMaRunner::Manifest::parseFile(manifestFileName);
+	}
+	catch (const std::runtime_error& exc) {
+		std::cerr << exc.what() << "\n";
+		return INVALID_INVOCATION;
+	}
+
+	std::vector<MiMaRunner::JobResult> results = MiMaRunner::JobRunner(jobs, optimize).run(threadCount);
+	std::string output = format == "csv" ? MiMaRunner::ResultWriter::toCSV(jobs, results) : MiMaRunner::ResultWriter::toJSON(jobs, results);
+
+	if (outputFileName.empty()) {
+		std::cout.write(output.data(), output.size());
+		std::cout.flush();
+	}
+	else {
+		std::ofstream fileOutputStream(outputFileName, std::ios::binary);
+		if (!fileOutputStream.good()) {
+			std::cerr << fmt::format("failed to open output file '{}'\n", outputFileName);
+			return INVALID_INVOCATION;
+		}
+		fileOutputStream.write(output.data(), output.size());
+	}
+
+	for (const MiMaRunner::JobResult& result : results) {
+		if (result.reason == MiMaRunner::HaltReason::FAILED) {
+			return JOBS_FAILED;
+		}
+	}
+	return ALL_JOBS_RUN;
+}
@@ -0,0 +1,119 @@
+#include "JobRunner.h"
+
+//std library
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <thread>
+#include <utility>
+
+//minimal machine
+#include "mima/microprogram/MicroProgramCompiler.h"
+#include "mima/mimaprogram/MiMaCompiler.h"
+#include "mima/MinimalMachine.h"
+#include "mima/CompilerException.h"
+
+
+namespace MiMaRunner {
+	const char* toString(const HaltReason& reason) {
+		switch (reason) {
+		case HaltReason::HALTED:
+			return "halted";
+		case HaltReason::CYCLE_LIMIT:
+			return "cycle_limit";
+		case HaltReason::FAILED:
+		default:
+			return "error";
+		}
+	}
+
+
+	JobRunner::JobRunner(const std::vector<Job>& jobs, bool optimizeMicroprograms) : jobs(jobs) {
+		//compile errors only fail the jobs using the file
+		for (const Job& job : jobs) {
+			if (microprograms.find(job.microprogramFileName) == microprograms.end()) {
+				Compiled<MiMa::MicroProgram>& microprogram = microprograms[job.microprogramFileName];
+				try {
+					MiMa::MicroProgramOptimization optimization;
+					microprogram.result = MiMa::MicroProgramCompiler::compileFile(job.microprogramFileName, optimizeMicroprograms ? &optimization : nullptr);
+				}
+				catch (const MiMa::CompilerException& exc) {
+					microprogram.error = exc.what();
+				}
+			}
+
+			if (images.find(job.programFileName) == images.end()) {
+				Compiled<MiMa::MemoryImage>& image = images[job.programFileName];
+				try {
+					image.result = MiMa::MiMaMemoryCompiler::compileFile(job.programFileName);
+				}
+				catch (const MiMa::CompilerException& exc) {
+					image.error = exc.what();
+				}
+			}
+		}
+	}
+
+
+	std::vector<JobResult> JobRunner::run(size_t threadCount) const {
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		threadCount = std::max<size_t>(std::min(threadCount, jobs.size()), 1);
+
+		std::vector<JobResult> results(jobs.size());
+		std::atomic<size_t> nextJob(0);
+		std::vector<std::thread> workers;
+
+		//workers take the next job until none are left, so long jobs don't hold up a fixed share of the manifest
+		for (size_t worker = 0; worker < threadCount; ++worker) {
+			workers.emplace_back([this, &results, &nextJob]() {
+				std::map<std::pair<const MiMa::MicroProgram*, const MiMa::MemoryImage*>, std::unique_ptr<MiMa::MinimalMachine>> machines;
+
+				for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+					const Job& job = jobs[i];
+					JobResult& result = results[i];
+
+					const Compiled<MiMa::MicroProgram>& microprogram = microprograms.at(job.microprogramFileName);
+					const Compiled<MiMa::MemoryImage>& image = images.at(job.programFileName);
+					if (!microprogram.error.empty() || !image.error.empty()) {
+						result.error = microprogram.error.empty() ? image.error : microprogram.error;
+						continue;
+					}
+
+					try {
+						std::unique_ptr<MiMa::MinimalMachine>& mima = machines[{ microprogram.result.get(), image.result.get() }];
+						if (mima) {
+							mima->reset(*image.result);
+						}
+						else {
+							mima = std::make_unique<MiMa::MinimalMachine>(microprogram.result, std::make_shared<MiMa::MiMaMemory>(*image.result));
+						}
+
+						mima->emulateLifeTime(job.cycleBudget);
+
+						result.reason = mima->isRunning() ? HaltReason::CYCLE_LIMIT : HaltReason::HALTED;
+						result.cycles = mima->getCycleCount();
+						for (const MiMa::AddressRange& outputRange : job.outputRanges) {
+							std::vector<uint32_t>& cells = result.outputs.emplace_back();
+							for (size_t address = outputRange.lower; address < outputRange.upper; ++address) {
+								cells.push_back(mima->getMemory()->get(address).data);
+							}
+						}
+					}
+					catch (const std::exception& exc) {
+						result = JobResult();
+						result.error = exc.what();
+					}
+				}
+			});
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		return results;
+	}
+}
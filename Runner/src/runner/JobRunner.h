@@ -0,0 +1,68 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//minimal machine
+#include "mima/microprogram/MicroProgram.h"
+#include "mima/mimaprogram/MiMaMemory.h"
+
+//internal classes
+#include "Manifest.h"
+
+
+namespace MiMaRunner {
+	enum class HaltReason {
+		HALTED,      //the program halted on its own
+		CYCLE_LIMIT, //the cycle budget ran out first
+		FAILED       //the job could not be run, see the error message
+	};
+
+	const char* toString(const HaltReason& reason);
+
+
+	struct JobResult {
+		HaltReason reason = HaltReason::FAILED;
+		uint64_t cycles = 0;
+		std::vector<std::vector<uint32_t>> outputs; //the cells of every output range of the job
+		std::string error;
+	};
+
+
+	// ------------------------------------------------
+	// Job runner
+	//
+	// Compiles every microprogram and program of a
+	// manifest once, then runs the jobs on a pool of
+	// worker threads. Workers keep one machine per
+	// (microprogram, program) pair they ran and reset
+	// it to the compiled memory image for every later
+	// job of that pair, so only the memory blocks the
+	// previous job dirtied are copied.
+	// ------------------------------------------------
+
+	class JobRunner {
+	private:
+		template<typename T>
+		struct Compiled {
+			std::shared_ptr<const T> result;
+			std::string error;
+		};
+
+	private:
+		std::vector<Job> jobs;
+		std::unordered_map<std::string, Compiled<MiMa::MicroProgram>> microprograms;
+		std::unordered_map<std::string, Compiled<MiMa::MemoryImage>> images;
+
+	public:
+		//optimized microprograms run the same jobs in fewer cycles, see MiMa::MicroProgramOptimizer
+		JobRunner(const std::vector<Job>& jobs, bool optimizeMicroprograms = false);
+
+		//runs all jobs on threadCount threads (0 = one per hardware thread), results are in job order
+		std::vector<JobResult> run(size_t threadCount = 0) const;
+	};
+}
@@ -0,0 +1,102 @@
+#include "Manifest.h"
+
+//std library
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+//external vendor libraries
+#include <fmt/format.h>
+
+
+namespace MiMaRunner {
+	namespace Manifest {
+		static bool parseNumber(const std::string& text, uint64_t& value) {
+			std::string digits = text;
+			int base = 10;
+			if (text.size() > 1 && text[0] == '$') {
+				digits = text.substr(1);
+				base = 16;
+			}
+			else if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+				digits = text.substr(2);
+				base = 16;
+			}
+
+			if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [base](const char& digit) { return base == 16 ? std::isxdigit(digit) : std::isdigit(digit); })) {
+				return false;
+			}
+
+			try {
+				value = std::stoull(digits, nullptr, base);
+			}
+			catch (const std::out_of_range&) {
+				return false;
+			}
+			return true;
+		}
+
+		static std::string resolve(const std::string& fileName, const std::string& baseDirectory) {
+			std::filesystem::path path(fileName);
+			return (path.is_absolute() || baseDirectory.empty()) ? fileName : (std::filesystem::path(baseDirectory) / path).string();
+		}
+
+
+		std::vector<Job> parse(std::istream& input, const std::string& baseDirectory) {
+			std::vector<Job> jobs;
+			std::unordered_set<std::string> jobNames;
+
+			std::string line;
+			for (size_t lineNumber = 1; std::getline(input, line); ++lineNumber) {
+				std::istringstream fields(line);
+				std::vector<std::string> arguments;
+				for (std::string field; fields >> field;) {
+					arguments.push_back(field);
+				}
+
+				if (arguments.empty() || arguments[0].rfind("//", 0) == 0) {
+					continue;
+				}
+
+				if (arguments.size() < 4) {
+					throw std::runtime_error(fmt::format("manifest line {}: expected name, microprogram, program and cycle budget, got {} fields", lineNumber, arguments.size()));
+				}
+				if (!jobNames.insert(arguments[0]).second) {
+					throw std::runtime_error(fmt::format("manifest line {}: the job name '{}' is already in use", lineNumber, arguments[0]));
+				}
+
+				Job job = { arguments[0], resolve(arguments[1], baseDirectory), resolve(arguments[2], baseDirectory), 0, {} };
+				if (!parseNumber(arguments[3], job.cycleBudget)) {
+					throw std::runtime_error(fmt::format("manifest line {}: invalid cycle budget '{}'", lineNumber, arguments[3]));
+				}
+
+				for (size_t i = 4; i < arguments.size(); ++i) {
+					size_t separator = arguments[i].find(':');
+					uint64_t lower, upper;
+					if (separator == std::string::npos || !parseNumber(arguments[i].substr(0, separator), lower) || !parseNumber(arguments[i].substr(separator + 1), upper) || lower > upper || upper > MiMa::DEFAULT_MEMORY_CAPACITY + 1) {
+						throw std::runtime_error(fmt::format("manifest line {}: invalid output range '{}', expected lower:upper within the address space", lineNumber, arguments[i]));
+					}
+
+					job.outputRanges.push_back({ (size_t)lower, (size_t)upper });
+				}
+
+				jobs.push_back(job);
+			}
+
+			return jobs;
+		}
+
+		std::vector<Job> parseFile(const std::string& fileName) {
+			std::ifstream fileInputStream(fileName);
+			if (!fileInputStream.good()) {
+				throw std::runtime_error(fmt::format("failed to open manifest file '{}'", fileName));
+			}
+
+			return parse(fileInputStream, std::filesystem::path(fileName).parent_path().string());
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+//std library
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+//minimal machine
+#include "mima/BatchExecutor.h"
+
+
+namespace MiMaRunner {
+	struct Job {
+		std::string name;
+		std::string microprogramFileName;
+		std::string programFileName;
+		uint64_t cycleBudget;
+		std::vector<MiMa::AddressRange> outputRanges;
+	};
+
+
+	// ------------------------------------------------
+	// Job manifest
+	//
+	// One job per line, blank lines and lines starting
+	// with // are skipped:
+	//   name microprogram program cycleBudget [lo:hi]...
+	// Numbers are decimal or hexadecimal with a $ or
+	// 0x prefix, output ranges exclude their upper
+	// address and relative file names are resolved
+	// against the directory of the manifest.
+	// ------------------------------------------------
+
+	namespace Manifest {
+		//throws a std::runtime_error naming the line of the first malformed job
+		std::vector<Job> parse(std::istream& input, const std::string& baseDirectory = "");
+		std::vector<Job> parseFile(const std::string& fileName);
+	}
+}
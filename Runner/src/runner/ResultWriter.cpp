@@ -0,0 +1,106 @@
+#include "ResultWriter.h"
+
+//std library
+#include <iterator>
+
+//external vendor libraries
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+
+namespace MiMaRunner {
+	namespace ResultWriter {
+		static std::string escapeJSON(const std::string& text) {
+			std::string escaped;
+			for (const char& character : text) {
+				switch (character) {
+				case '"':  escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\r': escaped += "\\r"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if ((unsigned char)character < 0x20) {
+						escaped += fmt::format("\\u{:04x}", (unsigned char)character);
+					}
+					else {
+						escaped += character;
+					}
+				}
+			}
+			return escaped;
+		}
+
+		static std::string escapeCSV(const std::string& text) {
+			if (text.find_first_of(",\"\r\n") == std::string::npos) {
+				return text;
+			}
+
+			std::string escaped = "\"";
+			for (const char& character : text) {
+				escaped += character;
+				if (character == '"') {
+					escaped += '"';
+				}
+			}
+			return escaped + "\"";
+		}
+
+
+		std::string toJSON(const std::vector<Job>& jobs, const std::vector<JobResult>& results) {
+			fmt::memory_buffer output;
+			fmt::format_to(std::back_inserter(output), "{{\n\t\"jobs\": [");
+
+			for (size_t i = 0; i < jobs.size(); ++i) {
+				const Job& job = jobs[i];
+				const JobResult& result = results[i];
+
+				fmt::format_to(std::back_inserter(output), "{}\n\t\t{{\n\t\t\t\"name\": \"{}\",\n\t\t\t\"reason\": \"{}\",\n\t\t\t\"cycles\": {}",
+					i == 0 ? "" : ",", escapeJSON(job.name), toString(result.reason), result.cycles);
+
+				if (result.reason == HaltReason::FAILED) {
+					fmt::format_to(std::back_inserter(output), ",\n\t\t\t\"error\": \"{}\"", escapeJSON(result.error));
+				}
+				else {
+					fmt::format_to(std::back_inserter(output), ",\n\t\t\t\"outputs\": [");
+					for (size_t range = 0; range < result.outputs.size(); ++range) {
+						fmt::format_to(std::back_inserter(output), "{}\n\t\t\t\t{{ \"lower\": {}, \"upper\": {}, \"cells\": [{}] }}",
+							range == 0 ? "" : ",", job.outputRanges[range].lower, job.outputRanges[range].upper, fmt::join(result.outputs[range], ", "));
+					}
+					fmt::format_to(std::back_inserter(output), "{}]", result.outputs.empty() ? "" : "\n\t\t\t");
+				}
+
+				fmt::format_to(std::back_inserter(output), "\n\t\t}}");
+			}
+
+			fmt::format_to(std::back_inserter(output), "{}]\n}}\n", jobs.empty() ? "" : "\n\t");
+			return fmt::to_string(output);
+		}
+
+
+		std::string toCSV(const std::vector<Job>& jobs, const std::vector<JobResult>& results) {
+			fmt::memory_buffer output;
+			fmt::format_to(std::back_inserter(output), "name,reason,cycles,address,value,error\n");
+
+			for (size_t i = 0; i < jobs.size(); ++i) {
+				const Job& job = jobs[i];
+				const JobResult& result = results[i];
+				std::string prefix = fmt::format("{},{},{}", escapeCSV(job.name), toString(result.reason), result.cycles);
+
+				bool hasCells = false;
+				for (size_t range = 0; range < result.outputs.size(); ++range) {
+					for (size_t cell = 0; cell < result.outputs[range].size(); ++cell) {
+						fmt::format_to(std::back_inserter(output), "{},{},{},\n", prefix, job.outputRanges[range].lower + cell, result.outputs[range][cell]);
+						hasCells = true;
+					}
+				}
+
+				if (!hasCells) {
+					fmt::format_to(std::back_inserter(output), "{},,,{}\n", prefix, escapeCSV(result.error));
+				}
+			}
+
+			return fmt::to_string(output);
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+//std library
+#include <string>
+#include <vector>
+
+//internal classes
+#include "JobRunner.h"
+#include "Manifest.h"
+
+
+namespace MiMaRunner {
+	// ------------------------------------------------
+	// Result writer
+	//
+	// Formats the results of all jobs into a single
+	// string, so they can be written out at once:
+	// JSON with one object per job and its output
+	// ranges, or CSV with one row per output cell
+	// (and one row for jobs without any).
+	// ------------------------------------------------
+
+	namespace ResultWriter {
+		std::string toJSON(const std::vector<Job>& jobs, const std::vector<JobResult>& results);
+		std::string toCSV(const std::vector<Job>& jobs, const std::vector<JobResult>& results);
+	}
+}
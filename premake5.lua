@@ -40,7 +40,9 @@ project (projectName)
 
 	postbuildcommands {
 		"{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputDir .. "/Sandbox",
-		"{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputDir .. "/ConsoleInterface"
+		"{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputDir .. "/ConsoleInterface",
+		"{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputDir .. "/Runner",
+		"{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputDir .. "/Fuzz"
 	}
 
 	filter "system:windows"
@@ -127,6 +129,90 @@ project "ConsoleInterface"
 		staticruntime "on"
 		
 
+	filter "configurations:Debug"
+		defines "MIMA_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "MIMA_RELEASE"
+		optimize "On"
+
+
+--Headless batch runner executing a manifest of jobs, for CI and grading scripts
+project "Runner"
+	location "Runner"
+	kind "ConsoleApp"
+	targetname "mima-run"
+
+	language "C++"
+	cppdialect (newestCppDialect)
+	
+	targetdir ("bin/" .. outputDir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputDir .. "/%{prj.name}")
+
+	files {
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp"
+	}
+
+	includedirs {
+		"%{prj.name}/src",
+		projectName .. "/src",
+		projectName .. "/vendor/spdlog/include",
+		projectName .. "/vendor/fmt/include"
+	}
+
+	links {
+		projectName
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		staticruntime "on"
+		
+
+	filter "configurations:Debug"
+		defines "MIMA_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "MIMA_RELEASE"
+		optimize "On"
+
+
+--Fuzzer generating programs and microprograms to compare the emulators and compilers on
+project "Fuzz"
+	location "Fuzz"
+	kind "ConsoleApp"
+	targetname "mima-fuzz"
+
+	language "C++"
+	cppdialect (newestCppDialect)
+	
+	targetdir ("bin/" .. outputDir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputDir .. "/%{prj.name}")
+
+	files {
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp"
+	}
+
+	includedirs {
+		"%{prj.name}/src",
+		projectName .. "/src",
+		projectName .. "/vendor/spdlog/include",
+		projectName .. "/vendor/fmt/include"
+	}
+
+	links {
+		projectName
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		staticruntime "on"
+		
+
 	filter "configurations:Debug"
 		defines "MIMA_DEBUG"
 		symbols "On"